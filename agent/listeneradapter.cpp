@@ -19,16 +19,38 @@
  */
 
 #include "listeneradapter_p.h"
+#include "polkitqt1-tracing_p.h"
 #include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
 #define POLKIT_AGENT_I_KNOW_API_IS_SUBJECT_TO_CHANGE 1
 #include <polkitagent/polkitagent.h>
 
+POLKITQT1_SEMAPHORE(agent__initiate)
+POLKITQT1_SEMAPHORE(agent__initiate__done)
+POLKITQT1_SEMAPHORE(agent__cancelled)
+
 namespace PolkitQt1
 {
 
 namespace Agent
 {
 
+#ifdef POLKIT_QT_1_TRACEPOINTS
+// Carried by the result of an authentication, for agent__initiate__done
+struct TracedAuthentication
+{
+    QByteArray actionId;
+    QElapsedTimer timer;
+};
+
+static const char tracedAuthenticationKey[] = "polkitqt1-traced-authentication";
+
+static void freeTracedAuthentication(gpointer data)
+{
+    delete (TracedAuthentication *) data;
+}
+#endif
+
 class ListenerAdapterHelper
 {
 public:
@@ -83,6 +105,15 @@ void ListenerAdapter::polkit_qt_listener_initiate_authentication(PolkitAgentList
         GSimpleAsyncResult *result)
 {
     qDebug() << "polkit_qt_listener_initiate_authentication callback for " << listener;
+    POLKITQT1_TRACE2(agent__initiate, action_id, cookie);
+#ifdef POLKIT_QT_1_TRACEPOINTS
+    if (POLKITQT1_ENABLED(agent__initiate__done)) {
+        TracedAuthentication *traced = new TracedAuthentication;
+        traced->actionId = action_id;
+        traced->timer.start();
+        g_object_set_data_full(G_OBJECT(result), tracedAuthenticationKey, traced, freeTracedAuthentication);
+    }
+#endif
 
     PolkitQt1::Identity::List idents;
     PolkitQt1::Details dets(details);
@@ -109,15 +140,21 @@ gboolean ListenerAdapter::polkit_qt_listener_initiate_authentication_finish(Polk
     qDebug() << "polkit_qt_listener_initiate_authentication_finish callback for " << listener;
 
     GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT(res);
-    if (g_simple_async_result_propagate_error(simple, error)) {
-        return false;
+    const bool failed = g_simple_async_result_propagate_error(simple, error);
+#ifdef POLKIT_QT_1_TRACEPOINTS
+    TracedAuthentication *traced = (TracedAuthentication *) g_object_get_data(G_OBJECT(res), tracedAuthenticationKey);
+    if (traced != NULL) {
+        POLKITQT1_TRACE3(agent__initiate__done, traced->actionId.constData(), int(failed),
+                         (long long)(traced->timer.nsecsElapsed() / 1000));
     }
-    return true;
+#endif
+    return !failed;
 }
 
 void ListenerAdapter::cancelled_cb(PolkitAgentListener *listener)
 {
     qDebug() << "cancelled_cb for " << listener;
+    POLKITQT1_TRACE1(agent__cancelled, listener);
 
     Listener *list = findListener(listener);
 
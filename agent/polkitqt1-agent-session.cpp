@@ -21,12 +21,20 @@
 #include "polkitqt1-agent-session.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
 
 #include "polkitqt1-identity.h"
+#include "polkitqt1-tracing_p.h"
 
 #define POLKIT_AGENT_I_KNOW_API_IS_SUBJECT_TO_CHANGE 1
 #include <polkitagent/polkitagent.h>
 
+POLKITQT1_SEMAPHORE(session__initiate)
+POLKITQT1_SEMAPHORE(session__request)
+POLKITQT1_SEMAPHORE(session__response)
+POLKITQT1_SEMAPHORE(session__cancel)
+POLKITQT1_SEMAPHORE(session__completed)
+
 using namespace PolkitQt1::Agent;
 
 class Session::Private
@@ -42,6 +50,10 @@ public:
 
     AsyncResult *result;
     PolkitAgentSession *polkitAgentSession;
+#ifdef POLKIT_QT_1_TRACEPOINTS
+    QByteArray cookie;
+    QElapsedTimer timer;
+#endif
 };
 
 Session::Private::~Private()
@@ -54,6 +66,9 @@ Session::Session(const PolkitQt1::Identity &identity, const QString &cookie, Asy
         , d(new Private)
 {
     d->result = result;
+#ifdef POLKIT_QT_1_TRACEPOINTS
+    d->cookie = cookie.toUtf8();
+#endif
     d->polkitAgentSession = polkit_agent_session_new(identity.identity(), cookie.toUtf8().data());
     g_signal_connect(G_OBJECT(d->polkitAgentSession), "completed", G_CALLBACK(Private::completed), this);
     g_signal_connect(G_OBJECT(d->polkitAgentSession), "request", G_CALLBACK(Private::request), this);
@@ -82,16 +97,22 @@ Session::~Session()
 
 void Session::initiate()
 {
+#ifdef POLKIT_QT_1_TRACEPOINTS
+    d->timer.start();
+#endif
+    POLKITQT1_TRACE2(session__initiate, this, d->cookie.constData());
     polkit_agent_session_initiate(d->polkitAgentSession);
 }
 
 void Session::setResponse(const QString &response)
 {
+    POLKITQT1_TRACE1(session__response, this);
     polkit_agent_session_response(d->polkitAgentSession, response.toUtf8().data());
 }
 
 void Session::cancel()
 {
+    POLKITQT1_TRACE1(session__cancel, this);
     polkit_agent_session_cancel(d->polkitAgentSession);
 }
 
@@ -104,6 +125,10 @@ void Session::Private::completed(PolkitAgentSession *s, gboolean gained_authoriz
 {
     qDebug() << "COMPLETED";
     Session *session = (Session *)user_data;
+#ifdef POLKIT_QT_1_TRACEPOINTS
+    const long long usecs = session->d->timer.isValid() ? session->d->timer.nsecsElapsed() / 1000 : -1;
+    POLKITQT1_TRACE3(session__completed, session, int(gained_authorization), usecs);
+#endif
     Q_EMIT(session)->completed(gained_authorization);
 
     //free session here as polkit documentation asks
@@ -114,6 +139,7 @@ void Session::Private::completed(PolkitAgentSession *s, gboolean gained_authoriz
 void Session::Private::request(PolkitAgentSession *s, gchar *request, gboolean echo_on, gpointer user_data)
 {
     qDebug() << "REQUEST";
+    POLKITQT1_TRACE2(session__request, user_data, int(echo_on));
     Q_EMIT((Session *)user_data)->request(QString::fromUtf8(request), echo_on);
 }
 
@@ -0,0 +1,513 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "polkitqt1-actioncatalog.h"
+#include "polkitqt1-actionsnapshot_p.h"
+#include "polkitqt1-authority.h"
+#include "polkitqt1-deadline_p.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMetaMethod>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QPointer>
+#include <QtCore/QRunnable>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+#include <polkit/polkit.h>
+
+namespace PolkitQt1
+{
+
+// Time between two lookups enumerating the actions, while polkitd does not answer
+static const int retryDelay = 1000;
+
+// The actions of one enumeration, never modified once built
+typedef QSharedPointer<const ActionSnapshot> ActionSnapshotPointer;
+
+// An enumeration in flight; the catalog may be deleted before it finishes
+struct ActionCatalogListing
+{
+    QPointer<ActionCatalog> catalog;
+    // what the actions are enumerated for, taken before asking polkitd
+    QByteArray locale;
+    ActionSnapshot::Stamps stamps;
+};
+
+// Saves a snapshot away from the thread of the authority, which is usually the GUI one
+class ActionSnapshotWriter : public QRunnable
+{
+public:
+    ActionSnapshotWriter(const ActionSnapshotPointer &snapshot, const QString &path)
+            : m_snapshot(snapshot)
+            , m_path(path) {}
+
+    void run() {
+        // the catalog works the same without it, only slower to start
+        m_snapshot->save(m_path);
+    }
+
+private:
+    ActionSnapshotPointer m_snapshot;
+    QString m_path;
+};
+
+static ActionDescription::List actionsFromList(GList *glist)
+{
+    ActionDescription::List result;
+    for (GList *glist2 = glist; glist2 != NULL; glist2 = g_list_next(glist2)) {
+        result.append(ActionDescription((PolkitActionDescription *) glist2->data));
+        g_object_unref(glist2->data);
+    }
+    g_list_free(glist);
+    return result;
+}
+
+static QString defaultSnapshotPath()
+{
+    const QString cache = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (cache.isEmpty()) {
+        return QString();
+    }
+
+    QString locale = QString::fromLatin1(ActionSnapshot::currentLocale());
+    for (int i = 0; i < locale.size(); ++i) {
+        const QChar c = locale.at(i);
+        if (!c.isLetterOrNumber() && c != QLatin1Char('_') && c != QLatin1Char('.') && c != QLatin1Char('@')
+            && c != QLatin1Char('-')) {
+            locale[i] = QLatin1Char('_');
+        }
+    }
+    return cache + QLatin1String("/polkit-qt-1/actions-") + locale + QLatin1String(".snapshot");
+}
+
+class ActionCatalog::Private
+{
+public:
+    Private(ActionCatalog *qq)
+        : q(qq)
+        , authority(0)
+        , attempted(false)
+        , cancellable(NULL)
+        , stale(false) {}
+
+    /** Returns the current snapshot, mapping or enumerating the actions first if that never worked */
+    ActionSnapshotPointer snapshot();
+    /** Returns whether the lookups answer from the current snapshot, needs mutex */
+    bool settled() const;
+    /** Returns a snapshot of \p list, and saves it for the processes to come */
+    ActionSnapshotPointer store(const ActionDescription::List &list, const QByteArray &locale,
+                                const ActionSnapshot::Stamps &stamps);
+    /** Replaces the snapshot with \p snapshot and reports how it differs from the previous one */
+    void load(const ActionSnapshotPointer &snapshot);
+    /** Returns the libpolkit-gobject authority, without leaving an error behind */
+    PolkitAuthority *polkitAuthority();
+
+    static void listCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+
+    ActionCatalog *q;
+    Authority *authority;
+    // protects current, attempted, failure and snapshotPath
+    QMutex mutex;
+    ActionSnapshotPointer current;
+    bool attempted;
+    // started when the last enumeration of a lookup failed
+    QElapsedTimer failure;
+    QString snapshotPath;
+    // serializes the blocking enumerations of the first lookups
+    QMutex loadMutex;
+    // set while an asynchronous enumeration runs
+    GCancellable *cancellable;
+    // whether a change came in since the running enumeration started
+    bool stale;
+};
+
+PolkitAuthority *ActionCatalog::Private::polkitAuthority()
+{
+    // the fake backend has no actions, and failing to get the authority is
+    // not an error of the caller's
+    const bool hadError = authority->hasError();
+    PolkitAuthority *pkAuthority = authority->polkitAuthority();
+    if (pkAuthority == NULL && !hadError) {
+        authority->clearError();
+    }
+    return pkAuthority;
+}
+
+ActionSnapshotPointer ActionCatalog::Private::store(const ActionDescription::List &list, const QByteArray &locale,
+                                                    const ActionSnapshot::Stamps &stamps)
+{
+    const ActionSnapshotPointer snapshot = ActionSnapshot::build(list, locale, stamps);
+    QString path;
+    {
+        QMutexLocker locker(&mutex);
+        path = snapshotPath;
+    }
+    if (!path.isEmpty()) {
+        // the snapshot never changes, so it can be written while it is used
+        QThreadPool::globalInstance()->start(new ActionSnapshotWriter(snapshot, path));
+    }
+    return snapshot;
+}
+
+bool ActionCatalog::Private::settled() const
+{
+    return attempted || (failure.isValid() && failure.elapsed() < retryDelay);
+}
+
+ActionSnapshotPointer ActionCatalog::Private::snapshot()
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (settled()) {
+            return current;
+        }
+    }
+
+    QMutexLocker loadLocker(&loadMutex);
+    QString path;
+    {
+        QMutexLocker locker(&mutex);
+        if (settled()) {
+            return current;
+        }
+        path = snapshotPath;
+    }
+
+    // taken before enumerating, so that a policy installed meanwhile makes
+    // the saved snapshot stale rather than missing
+    const QByteArray locale = ActionSnapshot::currentLocale();
+    const ActionSnapshot::Stamps stamps = ActionSnapshot::currentStamps();
+    if (!path.isEmpty()) {
+        const ActionSnapshotPointer mapped = ActionSnapshot::map(path, locale, stamps);
+        if (mapped) {
+            load(mapped);
+            return mapped;
+        }
+    }
+
+    PolkitAuthority *pkAuthority = polkitAuthority();
+    GList *glist = NULL;
+    GError *error = NULL;
+    if (pkAuthority != NULL) {
+        Deadline deadline(authority->defaultTimeout());
+        glist = polkit_authority_enumerate_actions_sync(pkAuthority, deadline.cancellable(), &error);
+    }
+
+    if (pkAuthority == NULL || error != NULL) {
+        if (error != NULL) {
+            g_error_free(error);
+        }
+        // the next lookups try again, once polkitd had some time to come back
+        QMutexLocker locker(&mutex);
+        failure.start();
+        return current;
+    }
+
+    const ActionSnapshotPointer enumerated = store(actionsFromList(glist), locale, stamps);
+    load(enumerated);
+    return enumerated;
+}
+
+void ActionCatalog::Private::load(const ActionSnapshotPointer &snapshot)
+{
+    ActionSnapshotPointer previous;
+    {
+        QMutexLocker locker(&mutex);
+        previous = current;
+        current = snapshot;
+        attempted = true;
+    }
+
+    // only create the descriptions somebody is going to look at
+    const bool reportAdded = q->isSignalConnected(QMetaMethod::fromSignal(&ActionCatalog::actionsAdded));
+    const bool reportRemoved = q->isSignalConnected(QMetaMethod::fromSignal(&ActionCatalog::actionsRemoved));
+    const bool reportChanged = q->isSignalConnected(QMetaMethod::fromSignal(&ActionCatalog::actionsChanged));
+
+    // both are sorted by action id, so one walk over them finds the differences
+    ActionDescription::List added;
+    ActionDescription::List removed;
+    ActionDescription::List changed;
+    const int beforeCount = previous ? previous->count() : 0;
+    const int afterCount = snapshot->count();
+    int i = 0;
+    int j = 0;
+    while (i < beforeCount || j < afterCount) {
+        const int order = i == beforeCount ? 1 : (j == afterCount ? -1 : previous->compareIds(i, *snapshot, j));
+        if (order < 0) {
+            if (reportRemoved) {
+                removed.append(ActionSnapshot::action(previous, i));
+            }
+            ++i;
+        } else if (order > 0) {
+            if (reportAdded) {
+                added.append(ActionSnapshot::action(snapshot, j));
+            }
+            ++j;
+        } else {
+            if (reportChanged && !previous->sameAction(i, *snapshot, j)) {
+                changed.append(ActionSnapshot::action(snapshot, j));
+            }
+            ++i;
+            ++j;
+        }
+    }
+
+    if (!added.isEmpty()) {
+        Q_EMIT q->actionsAdded(added);
+    }
+    if (!removed.isEmpty()) {
+        Q_EMIT q->actionsRemoved(removed);
+    }
+    if (!changed.isEmpty()) {
+        Q_EMIT q->actionsChanged(changed);
+    }
+    Q_EMIT q->loaded(q);
+}
+
+void ActionCatalog::Private::listCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    QScopedPointer<ActionCatalogListing> listing((ActionCatalogListing *) user_data);
+    GError *error = NULL;
+
+    GList *glist = polkit_authority_enumerate_actions_finish((PolkitAuthority *) object, result, &error);
+    const ActionDescription::List list = actionsFromList(glist);
+    if (listing->catalog.isNull()) {
+        if (error != NULL) {
+            g_error_free(error);
+        }
+        return;
+    }
+
+    Private *d = listing->catalog->d;
+    g_object_unref(d->cancellable);
+    d->cancellable = NULL;
+    if (d->stale) {
+        // the actions may predate the last change
+        if (error != NULL) {
+            g_error_free(error);
+        }
+        d->q->refresh();
+        return;
+    }
+
+    if (error != NULL) {
+        // keep answering from the actions we have
+        g_error_free(error);
+        return;
+    }
+
+    d->load(d->store(list, listing->locale, listing->stamps));
+}
+
+ActionCatalog::ActionCatalog(Authority *authority)
+        : QObject(authority)
+        , d(new Private(this))
+{
+    d->authority = authority;
+    d->snapshotPath = defaultSnapshotPath();
+    connect(authority, SIGNAL(configChanged()), this, SLOT(refresh()));
+}
+
+ActionCatalog::~ActionCatalog()
+{
+    if (d->cancellable != NULL) {
+        g_cancellable_cancel(d->cancellable);
+        g_object_unref(d->cancellable);
+    }
+    delete d;
+}
+
+QString ActionCatalog::snapshotPath() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->snapshotPath;
+}
+
+void ActionCatalog::setSnapshotPath(const QString &path)
+{
+    QMutexLocker locker(&d->mutex);
+    if (path == d->snapshotPath) {
+        return;
+    }
+    d->snapshotPath = path;
+    if (!path.isEmpty()) {
+        // the next lookup maps the new snapshot, or saves one there
+        d->attempted = false;
+        d->failure.invalidate();
+    }
+}
+
+bool ActionCatalog::isLoaded() const
+{
+    QMutexLocker locker(&d->mutex);
+    return !d->current.isNull();
+}
+
+int ActionCatalog::count() const
+{
+    const ActionSnapshotPointer snapshot = d->snapshot();
+    return snapshot ? snapshot->count() : 0;
+}
+
+bool ActionCatalog::contains(const QString &actionId) const
+{
+    const ActionSnapshotPointer snapshot = d->snapshot();
+    return snapshot && snapshot->find(actionId.toUtf8()) >= 0;
+}
+
+ActionDescription ActionCatalog::action(const QString &actionId) const
+{
+    const ActionSnapshotPointer snapshot = d->snapshot();
+    if (!snapshot) {
+        return ActionDescription();
+    }
+
+    const int index = snapshot->find(actionId.toUtf8());
+    return index >= 0 ? ActionSnapshot::action(snapshot, index) : ActionDescription();
+}
+
+ActionDescription::List ActionCatalog::actions() const
+{
+    ActionDescription::List result;
+    const ActionSnapshotPointer snapshot = d->snapshot();
+    if (!snapshot) {
+        return result;
+    }
+
+    result.reserve(snapshot->count());
+    for (int i = 0; i < snapshot->count(); ++i) {
+        result.append(ActionSnapshot::action(snapshot, i));
+    }
+    return result;
+}
+
+QStringList ActionCatalog::actionIds() const
+{
+    QStringList result;
+    const ActionSnapshotPointer snapshot = d->snapshot();
+    if (!snapshot) {
+        return result;
+    }
+
+    result.reserve(snapshot->count());
+    for (int i = 0; i < snapshot->count(); ++i) {
+        result.append(snapshot->actionId(i));
+    }
+    return result;
+}
+
+ActionDescription::List ActionCatalog::actionsWithPrefix(const QString &prefix) const
+{
+    ActionDescription::List result;
+    const ActionSnapshotPointer snapshot = d->snapshot();
+    if (!snapshot) {
+        return result;
+    }
+
+    // the matches are contiguous in the sorted actions
+    const QByteArray utf8Prefix = prefix.toUtf8();
+    for (int i = snapshot->lowerBound(utf8Prefix); i < snapshot->count() && snapshot->hasPrefix(i, utf8Prefix); ++i) {
+        result.append(ActionSnapshot::action(snapshot, i));
+    }
+    return result;
+}
+
+ActionDescription::List ActionCatalog::actionsByVendor(const QString &vendorName) const
+{
+    ActionDescription::List result;
+    const ActionSnapshotPointer snapshot = d->snapshot();
+    if (!snapshot) {
+        return result;
+    }
+
+    const QVector<int> indexes = snapshot->actionsByVendor(vendorName.toUtf8());
+    result.reserve(indexes.size());
+    Q_FOREACH(int index, indexes) {
+        result.append(ActionSnapshot::action(snapshot, index));
+    }
+    return result;
+}
+
+ActionDescription::List ActionCatalog::actionsWithImplicitAuthorization(ImplicitScope scope,
+                                                                        ActionDescription::ImplicitAuthorization authorization) const
+{
+    ActionDescription::List result;
+    const ActionSnapshotPointer snapshot = d->snapshot();
+    if (!snapshot) {
+        return result;
+    }
+
+    ImplicitField field;
+    switch (scope) {
+    case ImplicitInactive:
+        field = ImplicitInactiveField;
+        break;
+    case ImplicitActive:
+        field = ImplicitActiveField;
+        break;
+    default:
+        field = ImplicitAnyField;
+        break;
+    }
+
+    const QVector<int> indexes = snapshot->actionsWithImplicit(field, authorization);
+    result.reserve(indexes.size());
+    Q_FOREACH(int index, indexes) {
+        result.append(ActionSnapshot::action(snapshot, index));
+    }
+    return result;
+}
+
+void ActionCatalog::refresh()
+{
+    if (QThread::currentThread() != thread()) {
+        // the running enumeration belongs to the thread of the authority
+        QMetaObject::invokeMethod(this, "refresh", Qt::QueuedConnection);
+        return;
+    }
+
+    if (d->cancellable != NULL) {
+        d->stale = true;
+        return;
+    }
+
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        return;
+    }
+
+    d->stale = false;
+    d->cancellable = g_cancellable_new();
+    ActionCatalogListing *listing = new ActionCatalogListing;
+    listing->catalog = this;
+    listing->locale = ActionSnapshot::currentLocale();
+    listing->stamps = ActionSnapshot::currentStamps();
+    polkit_authority_enumerate_actions(pkAuthority, d->cancellable, Private::listCallback, listing);
+}
+
+}
+
+#include "moc_polkitqt1-actioncatalog.cpp"
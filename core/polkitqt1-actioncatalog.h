@@ -0,0 +1,200 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_ACTIONCATALOG_H
+#define POLKITQT1_ACTIONCATALOG_H
+
+#include "polkitqt1-export.h"
+#include "polkitqt1-actiondescription.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+
+namespace PolkitQt1
+{
+
+class Authority;
+
+/**
+ * \class ActionCatalog polkitqt1-actioncatalog.h ActionCatalog
+ *
+ * \brief Indexed copy of the actions registered with polkit
+ *
+ * Returned by Authority::actionCatalog(). The catalog enumerates the actions
+ * once, on the first lookup, and keeps them indexed by action id, vendor and
+ * implicit authorizations. It only enumerates them again, asynchronously, when
+ * Authority emits configChanged(); lookups keep answering from the previous
+ * actions until the new ones are in.
+ *
+ * Every enumeration is compared with the previous one, and only the actions
+ * which were added, removed or changed are reported, so that views do not
+ * have to be rebuilt from scratch when a package installs a policy.
+ *
+ * Every enumeration is also saved as a snapshot file, in a compact binary
+ * form, see snapshotPath(). The first lookup of the next process maps that
+ * file instead of asking polkitd, as long as the policy directories were not
+ * modified and the locale is the same; the processes using it share its pages.
+ *
+ * All the lookups are thread safe. If the first enumeration fails, the catalog
+ * stays empty, and the first lookup made a second or more after the failure
+ * enumerates again; configChanged() and refresh() also do.
+ *
+ * \see Authority::actionCatalog
+ */
+class POLKITQT1_EXPORT ActionCatalog : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(ActionCatalog)
+public:
+    /**
+     * The implicit authorizations of an action, depending on the session of the subject
+     */
+    enum ImplicitScope {
+        /** ActionDescription::implicitAny(), for any subject */
+        ImplicitAny = 0,
+        /** ActionDescription::implicitInactive(), for subjects in an inactive local session */
+        ImplicitInactive,
+        /** ActionDescription::implicitActive(), for subjects in an active local session */
+        ImplicitActive
+    };
+
+    ~ActionCatalog();
+
+    /**
+     * \return the file the actions are saved to and loaded from, by default
+     *         polkit-qt-1/actions-<locale>.snapshot in the cache directory of
+     *         the user
+     */
+    QString snapshotPath() const;
+
+    /**
+     * Sets the file the actions are saved to and loaded from, or disables the
+     * snapshot if \p path is empty.
+     *
+     * The catalog loads the snapshot on the first lookup. Setting another
+     * non-empty path makes the next lookup load the actions again, from the
+     * new snapshot if it is current, else from polkitd.
+     *
+     * \param path the snapshot file
+     */
+    void setSnapshotPath(const QString &path);
+
+    /**
+     * \return \c true once the actions have been enumerated
+     */
+    bool isLoaded() const;
+
+    /**
+     * \return the number of actions
+     */
+    int count() const;
+
+    /**
+     * \return \c true if \p actionId is a registered action
+     */
+    bool contains(const QString &actionId) const;
+
+    /**
+     * \return the description of \p actionId, or an empty ActionDescription if
+     *         there is no such action
+     */
+    ActionDescription action(const QString &actionId) const;
+
+    /**
+     * \return all the actions, sorted by action id
+     */
+    ActionDescription::List actions() const;
+
+    /**
+     * \return the ids of all the actions, sorted
+     */
+    QStringList actionIds() const;
+
+    /**
+     * \return the actions whose id starts with \p prefix, e.g. "org.kde.", sorted by action id
+     */
+    ActionDescription::List actionsWithPrefix(const QString &prefix) const;
+
+    /**
+     * \return the actions whose ActionDescription::vendorName() is \p vendorName,
+     *         sorted by action id
+     */
+    ActionDescription::List actionsByVendor(const QString &vendorName) const;
+
+    /**
+     * \return the actions whose implicit authorization in \p scope is
+     *         \p authorization, sorted by action id
+     */
+    ActionDescription::List actionsWithImplicitAuthorization(ImplicitScope scope,
+                                                             ActionDescription::ImplicitAuthorization authorization) const;
+
+public Q_SLOTS:
+    /**
+     * Enumerates the actions again, asynchronously, as if Authority had
+     * emitted configChanged().
+     */
+    void refresh();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when actions appear, including every action of
+     * the first enumeration.
+     *
+     * \param actions the new actions, sorted by action id
+     */
+    void actionsAdded(const PolkitQt1::ActionDescription::List &actions);
+
+    /**
+     * This signal is emitted when actions go away.
+     *
+     * \param actions the descriptions the actions had, sorted by action id
+     */
+    void actionsRemoved(const PolkitQt1::ActionDescription::List &actions);
+
+    /**
+     * This signal is emitted when the description of existing actions changes,
+     * e.g. their message or implicit authorizations.
+     *
+     * \param actions the new descriptions, sorted by action id
+     */
+    void actionsChanged(const PolkitQt1::ActionDescription::List &actions);
+
+    /**
+     * This signal is emitted every time the actions have been enumerated and
+     * the lookups answer from them, after actionsAdded(), actionsRemoved()
+     * and actionsChanged().
+     *
+     * \param catalog the catalog which was loaded, i.e. this object
+     */
+    void loaded(PolkitQt1::ActionCatalog *catalog);
+
+private:
+    explicit ActionCatalog(Authority *authority);
+
+    class Private;
+    friend class Private;
+    friend class Authority;
+    Private * const d;
+};
+
+}
+
+#endif
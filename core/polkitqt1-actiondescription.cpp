@@ -19,46 +19,13 @@
  * Boston, MA 02110-1301, USA.
  */
 
-#include "polkitqt1-actiondescription.h"
-
-#include <QtCore/QString>
+#include "polkitqt1-actiondescription_p.h"
 
 #include <polkit/polkit.h>
 
 namespace PolkitQt1
 {
 
-class ActionDescription::Data : public QSharedData
-{
-public:
-    Data() {}
-    Data(const Data& other)
-        : QSharedData(other)
-        , actionId(other.actionId)
-        , description(other.description)
-        , message(other.message)
-        , vendorName(other.vendorName)
-        , vendorUrl(other.vendorUrl)
-        , iconName(other.iconName)
-        , implicitAny(other.implicitAny)
-        , implicitInactive(other.implicitInactive)
-        , implicitActive(other.implicitActive)
-    {
-    }
-    virtual ~Data() {}
-
-    QString actionId;
-    QString description;
-    QString message;
-    QString vendorName;
-    QString vendorUrl;
-    QString iconName;
-
-    ActionDescription::ImplicitAuthorization implicitAny;
-    ActionDescription::ImplicitAuthorization implicitInactive;
-    ActionDescription::ImplicitAuthorization implicitActive;
-};
-
 ActionDescription::ActionDescription()
         : d(new Data)
 {
@@ -70,12 +37,27 @@ ActionDescription::ActionDescription(PolkitActionDescription *polkitActionDescri
 {
     g_type_init();
 
-    d->actionId = QString::fromUtf8(polkit_action_description_get_action_id(polkitActionDescription));
-    d->description = QString::fromUtf8(polkit_action_description_get_description(polkitActionDescription));
-    d->message = QString::fromUtf8(polkit_action_description_get_message(polkitActionDescription));
-    d->vendorName = QString::fromUtf8(polkit_action_description_get_vendor_name(polkitActionDescription));
-    d->vendorUrl = QString::fromUtf8(polkit_action_description_get_vendor_url(polkitActionDescription));
-    d->iconName = QString::fromUtf8(polkit_action_description_get_icon_name(polkitActionDescription));
+    const char *fields[ActionFieldCount];
+    fields[ActionIdField] = polkit_action_description_get_action_id(polkitActionDescription);
+    fields[DescriptionField] = polkit_action_description_get_description(polkitActionDescription);
+    fields[MessageField] = polkit_action_description_get_message(polkitActionDescription);
+    fields[VendorNameField] = polkit_action_description_get_vendor_name(polkitActionDescription);
+    fields[VendorUrlField] = polkit_action_description_get_vendor_url(polkitActionDescription);
+    fields[IconNameField] = polkit_action_description_get_icon_name(polkitActionDescription);
+
+    // one allocation for all the strings, converted when asked for
+    int size = 0;
+    for (int field = 0; field < ActionFieldCount; ++field) {
+        size += (fields[field] != NULL ? qstrlen(fields[field]) : 0) + 1;
+    }
+    d->strings.reserve(size);
+    for (int field = 0; field < ActionFieldCount; ++field) {
+        if (fields[field] != NULL) {
+            d->strings.append(fields[field]);
+        }
+        d->ends[field] = d->strings.size();
+        d->strings.append('\0');
+    }
 
     d->implicitAny = static_cast<ActionDescription::ImplicitAuthorization>(polkit_action_description_get_implicit_any(
                          polkitActionDescription));
@@ -85,6 +67,11 @@ ActionDescription::ActionDescription(PolkitActionDescription *polkitActionDescri
                             polkitActionDescription));
 }
 
+ActionDescription::ActionDescription(Data *data)
+        : d(data)
+{
+}
+
 ActionDescription::ActionDescription(const PolkitQt1::ActionDescription& other)
         : d(other.d)
 {
@@ -100,34 +87,59 @@ ActionDescription::~ActionDescription()
 {
 }
 
+bool ActionDescription::operator==(const ActionDescription &other) const
+{
+    if (d == other.d) {
+        return true;
+    }
+
+    if (d->snapshot && d->snapshot == other.d->snapshot && d->index == other.d->index) {
+        return true;
+    }
+
+    for (int field = 0; field < ActionFieldCount; ++field) {
+        if (d->utf8(ActionField(field)) != other.d->utf8(ActionField(field))) {
+            return false;
+        }
+    }
+    return d->implicitAny == other.d->implicitAny
+           && d->implicitInactive == other.d->implicitInactive
+           && d->implicitActive == other.d->implicitActive;
+}
+
+bool ActionDescription::operator!=(const ActionDescription &other) const
+{
+    return !(*this == other);
+}
+
 QString ActionDescription::actionId() const
 {
-    return d->actionId;
+    return d->string(ActionIdField);
 }
 
 QString ActionDescription::description() const
 {
-    return d->description;
+    return d->string(DescriptionField);
 }
 
 QString ActionDescription::message() const
 {
-    return d->message;
+    return d->string(MessageField);
 }
 
 QString ActionDescription::vendorName() const
 {
-    return d->vendorName;
+    return d->string(VendorNameField);
 }
 
 QString ActionDescription::vendorUrl() const
 {
-    return d->vendorUrl;
+    return d->string(VendorUrlField);
 }
 
 QString ActionDescription::iconName() const
 {
-    return d->iconName;
+    return d->string(IconNameField);
 }
 
 ActionDescription::ImplicitAuthorization ActionDescription::implicitAny() const
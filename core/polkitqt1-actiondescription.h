@@ -75,6 +75,13 @@ public:
 
     ActionDescription &operator=(const ActionDescription &other);
 
+    /**
+     * \return \c true if \p other describes the same action with the same
+     *         texts, vendor, icon and implicit authorizations
+     */
+    bool operator==(const ActionDescription &other) const;
+    bool operator!=(const ActionDescription &other) const;
+
     /**
      * \brief Gets the action id for ActionDescription
      *
@@ -140,6 +147,8 @@ public:
 
 private:
     class Data;
+    explicit ActionDescription(Data *data);
+    friend class ActionSnapshot;
     QSharedDataPointer< Data > d;
 };
 }
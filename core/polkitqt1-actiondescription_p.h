@@ -0,0 +1,89 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_ACTIONDESCRIPTION_P_H
+#define POLKITQT1_ACTIONDESCRIPTION_P_H
+
+#include "polkitqt1-actiondescription.h"
+#include "polkitqt1-actionsnapshot_p.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+
+namespace PolkitQt1
+{
+
+/**
+  * \internal
+  * The strings of a description are kept in UTF-8, and only converted when
+  * they are asked for: either in the record of a catalog snapshot, shared by
+  * all the descriptions read from it, or one after the other in a buffer of
+  * their own.
+  */
+class ActionDescription::Data : public QSharedData
+{
+public:
+    Data()
+        : index(-1)
+        , implicitAny(ActionDescription::Unknown)
+        , implicitInactive(ActionDescription::Unknown)
+        , implicitActive(ActionDescription::Unknown)
+    {
+        for (int field = 0; field < ActionFieldCount; ++field) {
+            ends[field] = 0;
+        }
+    }
+
+    /** Returns the UTF-8 bytes of \p field, without copying them */
+    QByteArray utf8(ActionField field) const
+    {
+        if (snapshot) {
+            return snapshot->utf8(index, field);
+        }
+        if (strings.isEmpty()) {
+            return QByteArray();
+        }
+        const quint32 begin = field == ActionIdField ? 0 : ends[field - 1] + 1;
+        return QByteArray::fromRawData(strings.constData() + begin, ends[field] - begin);
+    }
+
+    QString string(ActionField field) const
+    {
+        const QByteArray bytes = utf8(field);
+        return QString::fromUtf8(bytes.constData(), bytes.size());
+    }
+
+    // the snapshot record the description comes from, if any
+    QSharedPointer<const ActionSnapshot> snapshot;
+    int index;
+    // otherwise the strings, each followed by a NUL at the offset in ends
+    QByteArray strings;
+    quint32 ends[ActionFieldCount];
+
+    ActionDescription::ImplicitAuthorization implicitAny;
+    ActionDescription::ImplicitAuthorization implicitInactive;
+    ActionDescription::ImplicitAuthorization implicitActive;
+};
+
+}
+
+#endif
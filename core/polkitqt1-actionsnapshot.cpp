@@ -0,0 +1,547 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "polkitqt1-actionsnapshot_p.h"
+#include "polkitqt1-actiondescription_p.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QSaveFile>
+#include <QtCore/QVector>
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef POLKIT_QT_1_ACTIONS_DIR
+#define POLKIT_QT_1_ACTIONS_DIR "/usr/share/polkit-1/actions"
+#endif
+
+namespace PolkitQt1
+{
+
+// The file starts with a SnapshotHeader, followed by the directories, the
+// actions and the strings, each aligned to 8 bytes. Everything is in the byte
+// order of the machine which wrote it; a snapshot from another byte order is
+// treated as missing.
+
+static const char snapshotMagic[8] = { 'P', 'K', 'Q', 'T', 'A', 'C', 'T', '\0' };
+static const quint32 snapshotVersion = 1;
+static const quint32 snapshotByteOrder = 0x01020304;
+// a bigger file is not one of ours
+static const qint64 snapshotMaxSize = 64 * 1024 * 1024;
+
+// A string in the arena, followed by a NUL which is not counted in length
+struct SnapshotString
+{
+    // relative to the start of the strings
+    quint32 offset;
+    quint32 length;
+};
+
+struct SnapshotHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint64 size;
+    quint32 directoryCount;
+    quint32 directoriesOffset;
+    quint32 actionCount;
+    quint32 actionsOffset;
+    quint32 stringsOffset;
+    quint32 stringsSize;
+    SnapshotString locale;
+};
+
+struct SnapshotDirectory
+{
+    SnapshotString path;
+    qint64 mtime;
+};
+
+struct SnapshotAction
+{
+    SnapshotString fields[ActionFieldCount];
+    qint32 implicitAny;
+    qint32 implicitInactive;
+    qint32 implicitActive;
+    quint32 reserved;
+};
+
+static quint32 align8(quint32 offset)
+{
+    return (offset + 7) & ~quint32(7);
+}
+
+// Stores every distinct string once; the empty string is at offset 0
+class SnapshotArena
+{
+public:
+    SnapshotArena() {
+        m_bytes.append('\0');
+    }
+
+    SnapshotString add(const QByteArray &string) {
+        SnapshotString ref;
+        ref.length = string.size();
+        if (string.isEmpty()) {
+            ref.offset = 0;
+            return ref;
+        }
+
+        QHash<QByteArray, quint32>::const_iterator it = m_offsets.constFind(string);
+        if (it != m_offsets.constEnd()) {
+            ref.offset = it.value();
+        } else {
+            ref.offset = m_bytes.size();
+            m_offsets.insert(string, ref.offset);
+            m_bytes.append(string);
+            m_bytes.append('\0');
+        }
+        return ref;
+    }
+
+    const QByteArray &bytes() const {
+        return m_bytes;
+    }
+
+private:
+    QByteArray m_bytes;
+    // the keys may be views of the strings added, which outlive the arena
+    QHash<QByteArray, quint32> m_offsets;
+};
+
+// An action being written, and its id to sort by
+struct SnapshotEntry
+{
+    // a view of the id of action
+    QByteArray actionId;
+    const ActionDescription *action;
+};
+
+static bool snapshotEntryLess(const SnapshotEntry &a, const SnapshotEntry &b)
+{
+    return a.actionId < b.actionId;
+}
+
+static int compareBytes(const char *a, quint32 aLength, const char *b, quint32 bLength)
+{
+    const int result = memcmp(a, b, qMin(aLength, bLength));
+    if (result != 0) {
+        return result;
+    }
+    return aLength < bLength ? -1 : (aLength > bLength ? 1 : 0);
+}
+
+ActionSnapshot::ActionSnapshot()
+        : m_base(0)
+        , m_size(0)
+{
+}
+
+ActionSnapshot::~ActionSnapshot()
+{
+}
+
+QSharedPointer<const ActionSnapshot> ActionSnapshot::build(const ActionDescription::List &actions, const QByteArray &locale,
+                                                           const Stamps &stamps)
+{
+    QVector<SnapshotEntry> entries;
+    entries.reserve(actions.size());
+    // pointing into actions, not into a copy of it
+    for (int i = 0; i < actions.size(); ++i) {
+        SnapshotEntry entry;
+        entry.action = &actions.at(i);
+        entry.actionId = entry.action->d->utf8(ActionIdField);
+        entries.append(entry);
+    }
+    std::sort(entries.begin(), entries.end(), snapshotEntryLess);
+
+    SnapshotArena arena;
+    QVector<SnapshotDirectory> directories;
+    Q_FOREACH(const DirectoryStamp &stamp, stamps) {
+        SnapshotDirectory directory;
+        directory.path = arena.add(stamp.path);
+        directory.mtime = stamp.mtime;
+        directories.append(directory);
+    }
+
+    QVector<SnapshotAction> records;
+    records.reserve(entries.size());
+    for (int i = 0; i < entries.size(); ++i) {
+        // ids have to be unique for the lookups
+        if (i > 0 && entries.at(i).actionId == entries.at(i - 1).actionId) {
+            continue;
+        }
+        const ActionDescription &action = *entries.at(i).action;
+        SnapshotAction record;
+        for (int field = 0; field < ActionFieldCount; ++field) {
+            record.fields[field] = arena.add(action.d->utf8(ActionField(field)));
+        }
+        record.implicitAny = action.implicitAny();
+        record.implicitInactive = action.implicitInactive();
+        record.implicitActive = action.implicitActive();
+        record.reserved = 0;
+        records.append(record);
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+    header.version = snapshotVersion;
+    header.byteOrder = snapshotByteOrder;
+    header.locale = arena.add(locale);
+    header.directoryCount = directories.size();
+    header.directoriesOffset = align8(sizeof(SnapshotHeader));
+    header.actionCount = records.size();
+    header.actionsOffset = align8(header.directoriesOffset + directories.size() * sizeof(SnapshotDirectory));
+    header.stringsOffset = align8(header.actionsOffset + records.size() * sizeof(SnapshotAction));
+    header.stringsSize = arena.bytes().size();
+    header.size = header.stringsOffset + header.stringsSize;
+
+    QSharedPointer<ActionSnapshot> snapshot(new ActionSnapshot);
+    snapshot->m_bytes.fill('\0', header.size);
+    char *base = snapshot->m_bytes.data();
+    memcpy(base, &header, sizeof(header));
+    if (!directories.isEmpty()) {
+        memcpy(base + header.directoriesOffset, directories.constData(), directories.size() * sizeof(SnapshotDirectory));
+    }
+    if (!records.isEmpty()) {
+        memcpy(base + header.actionsOffset, records.constData(), records.size() * sizeof(SnapshotAction));
+    }
+    memcpy(base + header.stringsOffset, arena.bytes().constData(), header.stringsSize);
+
+    snapshot->m_base = reinterpret_cast<const uchar *>(snapshot->m_bytes.constData());
+    snapshot->m_size = header.size;
+    snapshot->buildIndexes();
+    return snapshot;
+}
+
+QSharedPointer<const ActionSnapshot> ActionSnapshot::map(const QString &path, const QByteArray &locale,
+                                                         const Stamps &stamps)
+{
+    QSharedPointer<ActionSnapshot> snapshot(new ActionSnapshot);
+    snapshot->m_file.reset(new QFile(path));
+    QFile *file = snapshot->m_file.data();
+    if (!file->open(QIODevice::ReadOnly)) {
+        return QSharedPointer<const ActionSnapshot>();
+    }
+
+    const qint64 size = file->size();
+    if (size < qint64(sizeof(SnapshotHeader)) || size > snapshotMaxSize) {
+        return QSharedPointer<const ActionSnapshot>();
+    }
+
+    // a read only mapping, so every process using the snapshot shares its
+    // pages; it is replaced by renaming, never rewritten in place
+    const uchar *base = file->map(0, size);
+    if (base == 0 || !isValid(base, size)) {
+        return QSharedPointer<const ActionSnapshot>();
+    }
+    snapshot->m_base = base;
+    snapshot->m_size = size;
+
+    const SnapshotHeader *header = snapshot->header();
+    if (snapshot->bytes(header->locale) != locale || int(header->directoryCount) != stamps.size()) {
+        return QSharedPointer<const ActionSnapshot>();
+    }
+    const SnapshotDirectory *directories = reinterpret_cast<const SnapshotDirectory *>(base + header->directoriesOffset);
+    for (int i = 0; i < stamps.size(); ++i) {
+        if (snapshot->bytes(directories[i].path) != stamps.at(i).path || directories[i].mtime != stamps.at(i).mtime) {
+            return QSharedPointer<const ActionSnapshot>();
+        }
+    }
+
+    snapshot->buildIndexes();
+    return snapshot;
+}
+
+bool ActionSnapshot::isValid(const uchar *base, qint64 size)
+{
+    if ((quintptr(base) & 7) != 0) {
+        return false;
+    }
+
+    const SnapshotHeader *header = reinterpret_cast<const SnapshotHeader *>(base);
+    if (memcmp(header->magic, snapshotMagic, sizeof(snapshotMagic)) != 0
+        || header->version != snapshotVersion
+        || header->byteOrder != snapshotByteOrder
+        || header->size != quint64(size)) {
+        return false;
+    }
+
+    // the areas follow each other, and have to fit
+    const quint64 directoriesEnd = quint64(header->directoriesOffset)
+                                   + quint64(header->directoryCount) * sizeof(SnapshotDirectory);
+    const quint64 actionsEnd = quint64(header->actionsOffset) + quint64(header->actionCount) * sizeof(SnapshotAction);
+    const quint64 stringsEnd = quint64(header->stringsOffset) + header->stringsSize;
+    if (header->directoriesOffset < sizeof(SnapshotHeader) || (header->directoriesOffset & 7) != 0
+        || header->actionsOffset < directoriesEnd || (header->actionsOffset & 7) != 0
+        || header->stringsOffset < actionsEnd
+        || stringsEnd > quint64(size)
+        || header->stringsSize == 0) {
+        return false;
+    }
+
+    const char *strings = reinterpret_cast<const char *>(base + header->stringsOffset);
+    // every string has to be inside the arena and NUL terminated
+    if (quint64(header->locale.offset) + header->locale.length >= header->stringsSize
+        || strings[header->locale.offset + header->locale.length] != '\0') {
+        return false;
+    }
+
+    const SnapshotDirectory *directories = reinterpret_cast<const SnapshotDirectory *>(base + header->directoriesOffset);
+    for (quint32 i = 0; i < header->directoryCount; ++i) {
+        const SnapshotString &path = directories[i].path;
+        if (quint64(path.offset) + path.length >= header->stringsSize || strings[path.offset + path.length] != '\0') {
+            return false;
+        }
+    }
+
+    const SnapshotAction *actions = reinterpret_cast<const SnapshotAction *>(base + header->actionsOffset);
+    for (quint32 i = 0; i < header->actionCount; ++i) {
+        const SnapshotAction &action = actions[i];
+        for (int field = 0; field < ActionFieldCount; ++field) {
+            const SnapshotString &string = action.fields[field];
+            if (quint64(string.offset) + string.length >= header->stringsSize
+                || strings[string.offset + string.length] != '\0') {
+                return false;
+            }
+        }
+        if (action.implicitAny < ActionDescription::Unknown || action.implicitAny > ActionDescription::Authorized
+            || action.implicitInactive < ActionDescription::Unknown || action.implicitInactive > ActionDescription::Authorized
+            || action.implicitActive < ActionDescription::Unknown || action.implicitActive > ActionDescription::Authorized) {
+            return false;
+        }
+
+        // the lookups rely on the ids being sorted and unique
+        if (i > 0) {
+            const SnapshotString &id = action.fields[ActionIdField];
+            const SnapshotString &previous = actions[i - 1].fields[ActionIdField];
+            if (compareBytes(strings + previous.offset, previous.length, strings + id.offset, id.length) >= 0) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void ActionSnapshot::buildIndexes()
+{
+    for (int i = 0; i < count(); ++i) {
+        const SnapshotAction *action = record(i);
+        m_vendors[bytes(action->fields[VendorNameField])].append(i);
+        // isValid() checked the range of the values of a mapped snapshot
+        m_implicit[ImplicitAnyField][action->implicitAny - ActionDescription::Unknown].append(i);
+        m_implicit[ImplicitInactiveField][action->implicitInactive - ActionDescription::Unknown].append(i);
+        m_implicit[ImplicitActiveField][action->implicitActive - ActionDescription::Unknown].append(i);
+    }
+}
+
+bool ActionSnapshot::save(const QString &path) const
+{
+    // most refreshes enumerate the same actions, which need no new file
+    QFile existing(path);
+    if (existing.open(QIODevice::ReadOnly) && existing.size() == m_size
+        && existing.readAll() == QByteArray::fromRawData(reinterpret_cast<const char *>(m_base), m_size)) {
+        return true;
+    }
+    existing.close();
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // the new file replaces the old one atomically, so processes which mapped
+    // the old one keep reading it undisturbed
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    if (file.write(reinterpret_cast<const char *>(m_base), m_size) != m_size) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+ActionSnapshot::Stamps ActionSnapshot::currentStamps()
+{
+    Stamps stamps;
+    DirectoryStamp stamp;
+    stamp.path = POLKIT_QT_1_ACTIONS_DIR;
+    // adding, removing or renaming a policy file changes the directory
+    const QFileInfo info(QFile::decodeName(stamp.path));
+    stamp.mtime = info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+    stamps.append(stamp);
+    return stamps;
+}
+
+QByteArray ActionSnapshot::currentLocale()
+{
+    // the same precedence as gettext
+    const char *variables[] = { "LC_ALL", "LC_MESSAGES", "LANG" };
+    for (unsigned i = 0; i < sizeof(variables) / sizeof(variables[0]); ++i) {
+        const char *value = getenv(variables[i]);
+        if (value != NULL && *value != '\0') {
+            return QByteArray(value);
+        }
+    }
+    return QByteArray("C");
+}
+
+const SnapshotHeader *ActionSnapshot::header() const
+{
+    return reinterpret_cast<const SnapshotHeader *>(m_base);
+}
+
+const SnapshotAction *ActionSnapshot::record(int index) const
+{
+    return reinterpret_cast<const SnapshotAction *>(m_base + header()->actionsOffset) + index;
+}
+
+const char *ActionSnapshot::data(const SnapshotString &string) const
+{
+    return reinterpret_cast<const char *>(m_base + header()->stringsOffset) + string.offset;
+}
+
+QByteArray ActionSnapshot::bytes(const SnapshotString &string) const
+{
+    // no copy, the snapshot outlives the result
+    return QByteArray::fromRawData(data(string), string.length);
+}
+
+int ActionSnapshot::count() const
+{
+    return header()->actionCount;
+}
+
+QString ActionSnapshot::actionId(int index) const
+{
+    const SnapshotString &id = record(index)->fields[ActionIdField];
+    return QString::fromUtf8(data(id), id.length);
+}
+
+QByteArray ActionSnapshot::utf8(int index, ActionField field) const
+{
+    return bytes(record(index)->fields[field]);
+}
+
+int ActionSnapshot::lowerBound(const QByteArray &actionId) const
+{
+    int low = 0;
+    int high = count();
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        const SnapshotString &id = record(middle)->fields[ActionIdField];
+        if (compareBytes(data(id), id.length, actionId.constData(), actionId.size()) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+int ActionSnapshot::find(const QByteArray &actionId) const
+{
+    const int index = lowerBound(actionId);
+    if (index == count()) {
+        return -1;
+    }
+    const SnapshotString &id = record(index)->fields[ActionIdField];
+    return compareBytes(data(id), id.length, actionId.constData(), actionId.size()) == 0 ? index : -1;
+}
+
+bool ActionSnapshot::hasPrefix(int index, const QByteArray &prefix) const
+{
+    const SnapshotString &id = record(index)->fields[ActionIdField];
+    return id.length >= quint32(prefix.size()) && memcmp(data(id), prefix.constData(), prefix.size()) == 0;
+}
+
+QVector<int> ActionSnapshot::actionsByVendor(const QByteArray &vendorName) const
+{
+    return m_vendors.value(vendorName);
+}
+
+QVector<int> ActionSnapshot::actionsWithImplicit(ImplicitField field,
+                                                 ActionDescription::ImplicitAuthorization authorization) const
+{
+    if (authorization < ActionDescription::Unknown || authorization > ActionDescription::Authorized) {
+        return QVector<int>();
+    }
+    return m_implicit[field][authorization - ActionDescription::Unknown];
+}
+
+ActionDescription::ImplicitAuthorization ActionSnapshot::implicitAny(int index) const
+{
+    return static_cast<ActionDescription::ImplicitAuthorization>(record(index)->implicitAny);
+}
+
+ActionDescription::ImplicitAuthorization ActionSnapshot::implicitInactive(int index) const
+{
+    return static_cast<ActionDescription::ImplicitAuthorization>(record(index)->implicitInactive);
+}
+
+ActionDescription::ImplicitAuthorization ActionSnapshot::implicitActive(int index) const
+{
+    return static_cast<ActionDescription::ImplicitAuthorization>(record(index)->implicitActive);
+}
+
+ActionDescription ActionSnapshot::action(const QSharedPointer<const ActionSnapshot> &snapshot, int index)
+{
+    // the strings stay in the snapshot until they are asked for
+    ActionDescription::Data *data = new ActionDescription::Data;
+    data->snapshot = snapshot;
+    data->index = index;
+    data->implicitAny = snapshot->implicitAny(index);
+    data->implicitInactive = snapshot->implicitInactive(index);
+    data->implicitActive = snapshot->implicitActive(index);
+    return ActionDescription(data);
+}
+
+int ActionSnapshot::compareIds(int index, const ActionSnapshot &other, int otherIndex) const
+{
+    const SnapshotString &id = record(index)->fields[ActionIdField];
+    const SnapshotString &otherId = other.record(otherIndex)->fields[ActionIdField];
+    return compareBytes(data(id), id.length, other.data(otherId), otherId.length);
+}
+
+bool ActionSnapshot::sameAction(int index, const ActionSnapshot &other, int otherIndex) const
+{
+    const SnapshotAction *action = record(index);
+    const SnapshotAction *otherAction = other.record(otherIndex);
+    for (int field = 0; field < ActionFieldCount; ++field) {
+        const SnapshotString &string = action->fields[field];
+        const SnapshotString &otherString = otherAction->fields[field];
+        if (compareBytes(data(string), string.length, other.data(otherString), otherString.length) != 0) {
+            return false;
+        }
+    }
+    return action->implicitAny == otherAction->implicitAny
+           && action->implicitInactive == otherAction->implicitInactive
+           && action->implicitActive == otherAction->implicitActive;
+}
+
+}
@@ -0,0 +1,158 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_ACTIONSNAPSHOT_P_H
+#define POLKITQT1_ACTIONSNAPSHOT_P_H
+
+#include "polkitqt1-actiondescription.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QVector>
+
+class QFile;
+
+namespace PolkitQt1
+{
+
+struct SnapshotHeader;
+struct SnapshotAction;
+struct SnapshotString;
+
+/** \internal The strings of an action, in the order they are stored */
+enum ActionField {
+    ActionIdField = 0,
+    DescriptionField,
+    MessageField,
+    VendorNameField,
+    VendorUrlField,
+    IconNameField,
+    ActionFieldCount
+};
+
+/** \internal The implicit authorizations of an action */
+enum ImplicitField {
+    ImplicitAnyField = 0,
+    ImplicitInactiveField,
+    ImplicitActiveField,
+    ImplicitFieldCount
+};
+
+/**
+  * \internal
+  * \brief Immutable, binary copy of the registered actions
+  *
+  * The actions are sorted by id, and their strings are stored once, in UTF-8,
+  * in a single arena. The same bytes are kept in memory after an enumeration
+  * and saved to disk, so that later processes map the file instead of asking
+  * polkitd, and share its pages.
+  *
+  * A snapshot on disk records the locale and the modification times of the
+  * policy directories it was taken with, and is only used while they match.
+  *
+  * The actions of a vendor, or with a given implicit authorization, are
+  * indexed in memory when the snapshot is built or mapped.
+  */
+class ActionSnapshot
+{
+public:
+    /** The modification time of a policy directory */
+    struct DirectoryStamp
+    {
+        QByteArray path;
+        // in milliseconds since the epoch, or -1 if the directory does not exist
+        qint64 mtime;
+    };
+    typedef QList<DirectoryStamp> Stamps;
+
+    ~ActionSnapshot();
+
+    /** Returns a snapshot of \p actions, which were enumerated for \p locale while the directories were as in \p stamps */
+    static QSharedPointer<const ActionSnapshot> build(const ActionDescription::List &actions, const QByteArray &locale,
+                                                      const Stamps &stamps);
+    /** Maps the snapshot saved at \p path, or returns \c NULL if it is missing, corrupt or stale */
+    static QSharedPointer<const ActionSnapshot> map(const QString &path, const QByteArray &locale, const Stamps &stamps);
+    /** Saves the snapshot to \p path, atomically, unless the file already holds the same bytes */
+    bool save(const QString &path) const;
+
+    /** Returns the policy directories as they are now */
+    static Stamps currentStamps();
+    /** Returns the locale the actions are translated for */
+    static QByteArray currentLocale();
+
+    int count() const;
+    QString actionId(int index) const;
+    /** Returns the UTF-8 bytes of \p field of the action at \p index, without copying them */
+    QByteArray utf8(int index, ActionField field) const;
+    /** Returns the index of \p actionId, or -1 */
+    int find(const QByteArray &actionId) const;
+    /** Returns the index of the first action whose id is not before \p actionId */
+    int lowerBound(const QByteArray &actionId) const;
+    bool hasPrefix(int index, const QByteArray &prefix) const;
+    /** Returns the indexes of the actions of \p vendorName, in order */
+    QVector<int> actionsByVendor(const QByteArray &vendorName) const;
+    /** Returns the indexes of the actions whose implicit authorization \p field is \p authorization, in order */
+    QVector<int> actionsWithImplicit(ImplicitField field, ActionDescription::ImplicitAuthorization authorization) const;
+    ActionDescription::ImplicitAuthorization implicitAny(int index) const;
+    ActionDescription::ImplicitAuthorization implicitInactive(int index) const;
+    ActionDescription::ImplicitAuthorization implicitActive(int index) const;
+    /** Returns the description of the action at \p index, which reads its strings from \p snapshot */
+    static ActionDescription action(const QSharedPointer<const ActionSnapshot> &snapshot, int index);
+
+    /** Compares the ids of the actions \p index and \p otherIndex of \p other, like strcmp() */
+    int compareIds(int index, const ActionSnapshot &other, int otherIndex) const;
+    /** Returns \c true if the actions \p index and \p otherIndex of \p other are described the same */
+    bool sameAction(int index, const ActionSnapshot &other, int otherIndex) const;
+
+private:
+    ActionSnapshot();
+    Q_DISABLE_COPY(ActionSnapshot)
+
+    enum {
+        ImplicitValueCount = ActionDescription::Authorized - ActionDescription::Unknown + 1
+    };
+
+    /** Checks the bounds of everything in the \p size bytes at \p base */
+    static bool isValid(const uchar *base, qint64 size);
+    /** Fills the indexes, once the actions are in place */
+    void buildIndexes();
+    const SnapshotHeader *header() const;
+    const SnapshotAction *record(int index) const;
+    QByteArray bytes(const SnapshotString &string) const;
+    const char *data(const SnapshotString &string) const;
+
+    // owns the bytes of a snapshot which was built
+    QByteArray m_bytes;
+    // owns the mapping of a snapshot which was mapped
+    QScopedPointer<QFile> m_file;
+    const uchar *m_base;
+    qint64 m_size;
+    // the keys point into the strings of the snapshot
+    QHash<QByteArray, QVector<int> > m_vendors;
+    QVector<int> m_implicit[ImplicitFieldCount][ImplicitValueCount];
+};
+
+}
+
+#endif
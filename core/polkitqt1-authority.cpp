@@ -22,45 +22,81 @@
  */
 
 #include "polkitqt1-authority.h"
-
+#include "polkitqt1-actioncatalog.h"
+#include "polkitqt1-authoritybackend_p.h"
+#include "polkitqt1-authoritymetrics_p.h"
+#include "polkitqt1-authorizationmatrix.h"
+#include "polkitqt1-authorizationwatch.h"
+#include "polkitqt1-deadline_p.h"
+#include "polkitqt1-fakeauthoritybackend.h"
+#include "polkitqt1-pendingauthorization_p.h"
+#include "polkitqt1-pendingrevocation_p.h"
+#include "polkitqt1-pendingactions_p.h"
+#include "polkitqt1-temporaryauthorizationwatch.h"
+#include "polkitqt1-tracing_p.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QPointer>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
 #include <QtDBus/QDBusInterface>
 #include <QtDBus/QDBusReply>
 
 #include <polkit/polkit.h>
 
+POLKITQT1_SEMAPHORE(callback__enter)
+POLKITQT1_SEMAPHORE(callback__exit)
+POLKITQT1_SEMAPHORE(check__start)
+POLKITQT1_SEMAPHORE(check__done)
+
 namespace PolkitQt1
 {
 
 class AuthorityHelper
 {
 public:
-    AuthorityHelper() : q(0) {}
+    AuthorityHelper() : q(0), asyncInit(false), fakeBackend(0) {}
     ~AuthorityHelper() {
-        delete q;
+        delete q.load();
     }
-    Authority *q;
+    QAtomicPointer<Authority> q;
+    // serializes the creation of the instance
+    QMutex mutex;
+    bool asyncInit;
+    FakeAuthorityBackend *fakeBackend;
 };
 
 Q_GLOBAL_STATIC(AuthorityHelper, s_globalAuthority)
 
+static const char polkitService[] = "org.freedesktop.PolicyKit1";
+// the delays between two attempts to bring polkitd back, growing exponentially
+static const int reconnectMinDelay = 10;
+static const int reconnectMaxDelay = 2000;
+// how long the checks asked for while polkitd is away wait for it to come back
+static const int reconnectGracePeriod = 5000;
+
 Authority *Authority::instance(PolkitAuthority *authority)
 {
-    if (!s_globalAuthority()->q) {
-        new Authority(authority);
+    Authority *result = s_globalAuthority()->q.loadAcquire();
+    if (!result) {
+        QMutexLocker locker(&s_globalAuthority()->mutex);
+        result = s_globalAuthority()->q.loadAcquire();
+        if (!result) {
+            result = new Authority(authority);
+        }
     }
 
-    return s_globalAuthority()->q;
-}
-
-Authority::Result polkitResultToResult(PolkitAuthorizationResult *result)
-{
-    if (polkit_authorization_result_get_is_challenge(result)) {
-        return Authority::Challenge;
-    } else if (polkit_authorization_result_get_is_authorized(result)) {
-        return Authority::Yes;
-    } else {
-        return Authority::No;
-    }
+    return result;
 }
 
 ActionDescription::List actionsToListAndFree(GList *glist)
@@ -76,32 +112,321 @@ ActionDescription::List actionsToListAndFree(GList *glist)
     return result;
 }
 
+void Authority::setAsynchronousInitialization(bool enabled)
+{
+    QMutexLocker locker(&s_globalAuthority()->mutex);
+    s_globalAuthority()->asyncInit = enabled;
+}
+
+void Authority::setFakeBackend(FakeAuthorityBackend *backend)
+{
+    QMutexLocker locker(&s_globalAuthority()->mutex);
+    s_globalAuthority()->fakeBackend = backend;
+}
+
+bool isCancelledError(GError *error)
+{
+    return g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)
+           || g_error_matches(error, POLKIT_ERROR, POLKIT_ERROR_CANCELLED);
+}
+
+QString subjectToString(PolkitSubject *subject)
+{
+    gchar *str = polkit_subject_to_string(subject);
+    QString result = QString::fromUtf8(str);
+    g_free(str);
+    return result;
+}
+
+// An asynchronous operation in flight, timed for the metrics
+struct AsyncCall
+{
+    Authority *authority;
+    AuthorityMetrics::Operation operation;
+    QElapsedTimer timer;
+};
+
+struct CheckAuthorizationData : public AsyncCall
+{
+    // only set for checks started with checkAuthorizationAsync()
+    QPointer<PendingAuthorization> request;
+    QString actionId;
+    Subject subject;
+    Authority::AuthorizationFlags flags;
+    QString cacheKey;
+};
+
+struct BulkCheck : public AsyncCall
+{
+    ~BulkCheck() {
+        g_object_unref(cancellable);
+    }
+
+    QList<QByteArray> actionIds;
+    QList<Subject> subjects;
+    Authority::AuthorizationFlags flags;
+    AuthorizationMatrix matrix;
+    // cells which have to be asked to the authority, and their cache keys
+    QVector<int> cells;
+    QStringList cacheKeys;
+    int next;
+    int inFlight;
+    GCancellable *cancellable;
+    // only set for checks started with checkAuthorizations()
+    QPointer<PendingAuthorizationMatrix> request;
+    // only set for checks started with checkAuthorizationsSync(), whose cells skip the reconnection
+    // queue: nothing would start them while the thread waits
+    AuthorityBackend *backend;
+    bool async;
+    bool done;
+};
+
+struct BulkCheckCell
+{
+    BulkCheck *bulk;
+    int cell;
+};
+
+struct BulkRevoke : public AsyncCall
+{
+    ~BulkRevoke() {
+        g_object_unref(cancellable);
+    }
+
+    // either ids or subjects are revoked
+    QStringList ids;
+    QList<Subject> subjects;
+    QVector<RevocationResult> results;
+    PolkitAuthority *pkAuthority;
+    int next;
+    int inFlight;
+    GCancellable *cancellable;
+    // only cleared if the caller deleted the request
+    QPointer<PendingRevocation> request;
+    // set until the first revocation is sent, finished() then has to wait for the event loop
+    bool starting;
+};
+
+// An enumerateActionsStreamed() in flight
+struct ActionStream : public AsyncCall
+{
+    ~ActionStream() {
+        g_object_unref(cancellable);
+    }
+
+    GCancellable *cancellable;
+    // only cleared if the caller deleted the request
+    QPointer<PendingActions> request;
+};
+
+struct BulkRevokeItem
+{
+    BulkRevoke *bulk;
+    int index;
+};
+
+struct CacheEntry
+{
+    CacheEntry() : result(Authority::Unknown), expiresAt(-1) {}
+    CacheEntry(Authority::Result r, qint64 e) : result(r), expiresAt(e) {}
+
+    Authority::Result result;
+    // when the result goes stale, in msecs of the cache clock, or -1 if it only
+    // goes away with the cache
+    qint64 expiresAt;
+};
+
+// A result granted by a temporary authorization whose expiry is not known yet
+struct TemporaryResult
+{
+    QString cacheKey;
+    Subject subject;
+};
+
+// A lookup of the temporary authorizations of our session, and the results waiting for it
+struct TemporaryLookup
+{
+    Authority *authority;
+    QMultiHash<QString, TemporaryResult> results;
+};
+
+// The error state is kept per thread, so that a failure in one thread
+// does not make every other thread bail out
+struct ErrorState
+{
+    ErrorState()
+        : hasError(false)
+        , lastError(Authority::E_None)
+        , connection(0)
+        , transient(false)
+        , operation(0) {}
+
+    bool hasError;
+    Authority::ErrorCode lastError;
+    QString errorDetails;
+    // the connection to the authority the error happened with, and whether
+    // a new connection makes it go away
+    int connection;
+    bool transient;
+    // the innermost operation being timed by this thread, which setError() marks as failed
+    void *operation;
+};
+
 class Authority::Private
 {
 public:
     // Polkit will return NULL on failures, hence we use it instead of 0
     Private(Authority *qq) : q(qq)
             , pkAuthority(NULL)
-            , m_hasError(false) {}
+            , backend(NULL)
+            , m_coalescing(new CoalescingAuthorityBackend)
+            , m_scheduler(new SchedulingAuthorityBackend(&m_metrics))
+            , m_fakeBackend(NULL)
+            , m_actionCatalog(NULL)
+            , m_dbusBackend(false)
+            , m_asyncInit(false)
+            , m_ready(true)
+            , m_changeWindow(100)
+            , m_changeGeneration(0)
+            , m_cacheEnabled(false)
+            , m_cacheHits(0)
+            , m_cacheMisses(0)
+            , m_temporaryLookup(false)
+            , m_session(NULL)
+            , m_lastRequestId(0)
+            , m_bulkCheckWindow(32)
+            , m_defaultTimeout(-1)
+            , m_authorityLost(false)
+            , m_reconnectDelay(reconnectMinDelay) {
+        // created before the authority moves to its thread, so that they move along
+        m_changeTimer = new QTimer(qq);
+        m_changeTimer->setSingleShot(true);
+        QObject::connect(m_changeTimer, SIGNAL(timeout()), qq, SLOT(emitChange()));
+        m_reconnectTimer = new QTimer(qq);
+        m_reconnectTimer->setSingleShot(true);
+        QObject::connect(m_reconnectTimer, SIGNAL(timeout()), qq, SLOT(reconnect()));
+        m_cacheExpiryTimer = new QTimer(qq);
+        m_cacheExpiryTimer->setSingleShot(true);
+        QObject::connect(m_cacheExpiryTimer, SIGNAL(timeout()), qq, SLOT(cacheExpire()));
+        m_cacheClock.start();
+    }
 
     ~Private();
 
     void init();
+    /** Completes the initialization with \p authority, which may be \c NULL on failure */
+    void finishInit(PolkitAuthority *authority, const QString &errorDetails);
+    /** Completes a pending asynchronous initialization right away */
+    void waitForReady();
+    /** Waits for the initialization and sets the error of the calling thread if there is no authority */
+    bool checkBackend();
+    /** Returns \c true if the initialization is over and failed */
+    bool authorityFailed();
+    /** Sends a check to the backend, or queues it until the initialization is over */
+    void checkAuthorization(const Subject &subject, const QByteArray &actionId, Authority::AuthorizationFlags flags,
+                            GCancellable *cancellable, CheckAuthorizationCallback callback, void *userData);
+    /** Returns the backend the checks go to, \c NULL until it is created */
+    AuthorityBackend *currentBackend();
+    /** Returns the libpolkit-gobject authority, which the QtDBus backend only creates when needed */
+    PolkitAuthority *polkitAuthority();
+    /** Makes \p authority the one of this object unless another thread was faster, needs m_mutex */
+    PolkitAuthority *publishAuthority(PolkitAuthority *authority, bool watchChanges);
 
     /** Use this method to set the error message to \p message. Set recover to \c true
      * to try to reinitialize this object with init() method
      */
     void setError(Authority::ErrorCode code, const QString &details = QString(), bool recover = false);
+    /** Sets the error of a call bound by \p deadline which failed with \p error */
+    void setError(Authority::ErrorCode code, GError *error, const Deadline &deadline);
+    int defaultTimeout() const;
+    /** Returns the error state of the calling thread */
+    ErrorState &errorState();
 
     void dbusFilter(const QDBusMessage &message);
     void dbusSignalAdd(const QString &service, const QString &path, const QString &interface, const QString &name);
     void seatSignalsConnect(const QString &seat);
+    void seatSignalsDisconnect(const QString &seat);
+    void seatsListed(const QDBusMessage &message);
+    /** Starts the coalescing window of changed() unless it is already running */
+    void scheduleChange();
+    void emitChange();
+    /** Reacts to a change of the polkit configuration */
+    void polkitChanged();
+    /** Reacts to a change of the ConsoleKit seats and sessions */
+    void consoleKitChanged();
+    /** Reacts to polkitd leaving the bus, if \p owner is empty, or coming back */
+    void authorityOwnerChanged(const QString &owner);
+    /** Asks the bus whether polkitd is back, without waiting for the answer */
+    void reconnect();
+    /** Reconnects to polkitd if the answer of reconnect() says it is back, or tries again later */
+    void authorityQueried(const QDBusMessage &message);
+    /** Reconnects to polkitd, which is on the bus again */
+    void reattach();
+    /** Creates the backend of an authority whose initialization failed, returns \c false if polkitd is still away */
+    bool connectBackend();
+    /** Asks the bus to start polkitd and schedules the next attempt to reconnect */
+    void reconnectLater();
+
+    /** Cancels every operation using \p cancellable and replaces it with a fresh one,
+     * so that operations started later are not cancelled right away
+     */
+    void resetCancellable(GCancellable **cancellable);
+    /** Returns a new reference to the shared \p cancellable, safe against a concurrent reset */
+    GCancellable *refCancellable(GCancellable *const *cancellable);
+    quint64 nextRequestId();
+
+    class OperationTimer;
+    /** Returns a new AsyncCall for \p operation, started now */
+    AsyncCall *asyncCall(AuthorityMetrics::Operation operation);
+    /** Initializes \p call for \p operation and starts timing it */
+    void asyncCallStarted(AsyncCall *call, AuthorityMetrics::Operation operation);
+    void asyncCallFinished(const AsyncCall *call, AuthorityMetricsRecorder::Outcome outcome);
+
+    /** Returns the cache key for a check, or an empty string if the check must not be cached */
+    QString cacheKey(const QString &actionId, const Subject &subject, Authority::AuthorizationFlags flags) const;
+    bool cacheLookup(const QString &key, Authority::Result *result);
+    /** Caches \p result until \p expiresAt, in msecs of m_cacheClock, or for good if it is -1 */
+    void cacheInsert(const QString &key, const Subject &subject, Authority::Result result, qint64 expiresAt = -1);
+    /** Caches a Yes granted by the temporary authorization \p id, once its expiry is known */
+    void cacheInsertTemporary(const QString &key, const Subject &subject, const QString &id);
+    /** Records the answer to a check, which may be \p key or interactive, in the cache
+     * and among the temporary authorizations seen
+     */
+    void checkFinished(const QString &key, const QString &actionId, const Subject &subject,
+                       Authority::AuthorizationFlags flags, const CheckAuthorizationReply &reply);
+    /** Forgets the temporary authorizations seen and tells the watches */
+    void temporaryAuthorizationsRevoked();
+    void cacheRemove(const QString &actionId, const Subject &subject);
+    void cacheRemoveBusName(const QString &name);
+    void cacheClear();
+    /** Drops the results whose temporary authorization expired */
+    void cacheExpire();
+    /** Starts the expiry timer for the next result to go stale */
+    void scheduleCacheExpiry();
+    /** Looks up the expiry of the temporary authorizations the cached results wait for */
+    void lookupTemporaryAuthorizations();
+    void temporaryLookupEnumerate(TemporaryLookup *lookup);
+    void temporaryLookupFinished(TemporaryLookup *lookup);
+
+    /** Prepares a bulk check, answering from the cache what can be answered */
+    BulkCheck *bulkCheckCreate(const QStringList &actionIds, const QList<Subject> &subjects,
+                               Authority::AuthorizationFlags flags, GCancellable *cancellable, bool async);
+    /** Sends checks to the authority until the window is full */
+    void bulkCheckFill(BulkCheck *bulk);
+    void bulkCheckFinish(BulkCheck *bulk);
+
+    /** Starts revoking \p ids or \p subjects, whichever is not empty */
+    PendingRevocation *bulkRevoke(const QStringList &ids, const QList<Subject> &subjects, QObject *parent);
+    /** Sends revocations to the authority until the window is full */
+    void bulkRevokeFill(BulkRevoke *bulk);
+    void bulkRevokeFinish(BulkRevoke *bulk);
 
     Authority *q;
     PolkitAuthority *pkAuthority;
-    bool m_hasError;
-    Authority::ErrorCode m_lastError;
-    QString m_errorDetails;
+    AuthorityBackend *backend;
+    QThreadStorage<ErrorState> m_errorState;
+    // protects everything below as well as the shared cancellables
+    mutable QMutex m_mutex;
     QDBusConnection *m_systemBus;
     GCancellable *m_checkAuthorizationCancellable,
     *m_enumerateActionsCancellable,
@@ -112,20 +437,138 @@ public:
     *m_revokeTemporaryAuthorizationsCancellable,
     *m_revokeTemporaryAuthorizationCancellable;
 
+    // wraps the backend in use, whose checks it coalesces
+    CoalescingAuthorityBackend *m_coalescing;
+    // wraps m_coalescing, and sorts the checks in lanes
+    SchedulingAuthorityBackend *m_scheduler;
+    FakeAuthorityBackend *m_fakeBackend;
+    ActionCatalog *m_actionCatalog;
+    bool m_dbusBackend;
+    bool m_asyncInit;
+    bool m_ready;
+    QString m_initErrorDetails;
+    // checks asked for before the initialization was over
+    QList<QueuedCheckAuthorization *> m_queuedChecks;
+    AuthorityMetricsRecorder m_metrics;
+    QTimer *m_changeTimer;
+    int m_changeWindow;
+    quint64 m_changeGeneration;
+    bool m_cacheEnabled;
+    QHash<QString, CacheEntry> m_cache;
+    // system bus name -> cache keys of the results obtained for it
+    QMultiHash<QString, QString> m_cacheBusNames;
+    quint64 m_cacheHits;
+    quint64 m_cacheMisses;
+    // monotonic, unlike the expiry times polkitd gives
+    QElapsedTimer m_cacheClock;
+    // expiry -> cache keys of the results which go stale then
+    QMultiMap<qint64, QString> m_cacheExpiries;
+    QTimer *m_cacheExpiryTimer;
+    // temporary authorization id -> its expiry, in msecs of m_cacheClock
+    QHash<QString, qint64> m_temporaryExpiries;
+    // temporary authorization id -> results waiting for its expiry to be looked up
+    QMultiHash<QString, TemporaryResult> m_temporaryResults;
+    bool m_temporaryLookup;
+    // the session of this process, the only one whose temporary authorizations we may list
+    PolkitSubject *m_session;
+    // the temporary authorizations our checks were granted by
+    QSet<QString> m_temporaryIds;
+    quint64 m_lastRequestId;
+    int m_bulkCheckWindow;
+    int m_defaultTimeout;
+    // polkitd left the bus, and the checks wait for it to come back
+    bool m_authorityLost;
+    QElapsedTimer m_lostTimer;
+    QTimer *m_reconnectTimer;
+    int m_reconnectDelay;
+    // bumped whenever polkitd comes back, which clears the errors of the previous connections
+    QAtomicInt m_connection;
 
     static void pk_config_changed();
-    static void checkAuthorizationCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void authorityReadyCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void checkAuthorizationCallback(const CheckAuthorizationReply &reply, void *user_data);
+    static void pendingCheckAuthorizationCallback(const CheckAuthorizationReply &reply, void *user_data);
+    static void bulkCheckCallback(const CheckAuthorizationReply &reply, void *user_data);
+    static void bulkRevokeCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void enumerateActionsCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void enumerateActionsStreamedCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void registerAuthenticationAgentCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void unregisterAuthenticationAgentCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void authenticationAgentResponseCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void enumerateTemporaryAuthorizationsCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void revokeTemporaryAuthorizationsCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void revokeTemporaryAuthorizationCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void temporaryLookupSessionCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void temporaryLookupCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+};
+
+/**
+  * \internal
+  * \brief Times an operation for the metrics
+  *
+  * Errors set by the thread while the timer is alive count as a failure of
+  * the operation. The outcome is recorded when the timer is destroyed.
+  */
+class Authority::Private::OperationTimer
+{
+public:
+    /** Starts timing a synchronous \p operation */
+    OperationTimer(Authority::Private *d, AuthorityMetrics::Operation operation)
+            : m_d(d)
+            , m_operation(operation)
+            , m_outcome(AuthorityMetricsRecorder::Succeeded)
+            , m_callback(false) {
+        m_d->m_metrics.started(operation);
+        m_timer.start();
+        attach();
+    }
+    /** Continues timing the asynchronous \p call, from its callback */
+    explicit OperationTimer(const AsyncCall *call)
+            : m_d(call->authority->d)
+            , m_operation(call->operation)
+            , m_timer(call->timer)
+            , m_outcome(AuthorityMetricsRecorder::Succeeded)
+            , m_callback(true) {
+        POLKITQT1_TRACE1(callback__enter, AuthorityMetricsRecorder::operationName(m_operation));
+        attach();
+    }
+    ~OperationTimer() {
+        m_d->errorState().operation = m_previous;
+        const qint64 usecs = m_timer.nsecsElapsed() / 1000;
+        if (m_callback) {
+            POLKITQT1_TRACE3(callback__exit, AuthorityMetricsRecorder::operationName(m_operation), int(m_outcome),
+                             (long long) usecs);
+        }
+        m_d->m_metrics.finished(m_operation, usecs, m_outcome);
+    }
+
+    void setFailed() {
+        m_outcome = AuthorityMetricsRecorder::Failed;
+    }
+    void setCancelled() {
+        m_outcome = AuthorityMetricsRecorder::Cancelled;
+    }
+
+private:
+    void attach() {
+        ErrorState &state = m_d->errorState();
+        m_previous = state.operation;
+        state.operation = this;
+    }
+
+    Authority::Private *m_d;
+    AuthorityMetrics::Operation m_operation;
+    QElapsedTimer m_timer;
+    AuthorityMetricsRecorder::Outcome m_outcome;
+    bool m_callback;
+    void *m_previous;
 };
 
 Authority::Private::~Private()
 {
+    qDeleteAll(m_queuedChecks);
+    delete m_scheduler;
+    delete m_coalescing;
     g_object_unref(m_checkAuthorizationCancellable);
     g_object_unref(m_enumerateActionsCancellable);
     g_object_unref(m_registerAuthenticationAgentCancellable);
@@ -134,6 +577,9 @@ Authority::Private::~Private()
     g_object_unref(m_enumerateTemporaryAuthorizationsCancellable);
     g_object_unref(m_revokeTemporaryAuthorizationsCancellable);
     g_object_unref(m_revokeTemporaryAuthorizationCancellable);
+    if (m_session != NULL) {
+        g_object_unref(m_session);
+    }
 }
 
 Authority::Authority(PolkitAuthority *authority, QObject *parent)
@@ -142,15 +588,38 @@ Authority::Authority(PolkitAuthority *authority, QObject *parent)
 {
     qRegisterMetaType<PolkitQt1::Authority::Result> ();
     qRegisterMetaType<PolkitQt1::ActionDescription::List>();
+    qRegisterMetaType<PolkitQt1::AuthorizationMatrix>();
+    qRegisterMetaType<PolkitQt1::AuthorityMetrics>();
+
+    qRegisterMetaType<PolkitQt1::TemporaryAuthorization>();
+    qRegisterMetaType<PolkitQt1::TemporaryAuthorization::List>();
 
-    Q_ASSERT(!s_globalAuthority()->q);
-    s_globalAuthority()->q = this;
+    Q_ASSERT(!s_globalAuthority()->q.load());
+
+    // a child, so that it moves to the thread of the authority along with it
+    d->m_actionCatalog = new ActionCatalog(this);
+
+    // The instance may be created by any thread, but it has to live in one
+    // which stays around for the ConsoleKit and polkit change notifications
+    if (QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
 
     if (authority) {
         d->pkAuthority = authority;
     }
 
+    s_globalAuthority()->mutex.lock();
+    // the reply of the background initialization is dispatched by the main thread
+    d->m_asyncInit = s_globalAuthority()->asyncInit
+                     && (!QCoreApplication::instance() || QThread::currentThread() == thread());
+    d->m_fakeBackend = s_globalAuthority()->fakeBackend;
+    s_globalAuthority()->mutex.unlock();
+
     d->init();
+
+    // publish the instance only once it is fully set up
+    s_globalAuthority()->q.storeRelease(this);
 }
 
 Authority::~Authority()
@@ -178,33 +647,47 @@ void Authority::Private::init()
     m_revokeTemporaryAuthorizationsCancellable = g_cancellable_new();
     m_revokeTemporaryAuthorizationCancellable = g_cancellable_new();
 
+    if (m_fakeBackend != NULL) {
+        backend = m_scheduler->schedule(m_coalescing->coalesce(new InProcessAuthorityBackend(m_fakeBackend)));
+        // the fake reports the changes polkitd and ConsoleKit would report
+        QObject::connect(m_fakeBackend, SIGNAL(configChanged()), q, SLOT(polkitChanged()));
+        QObject::connect(m_fakeBackend, SIGNAL(seatAdded(QString)), q, SIGNAL(seatAdded(QString)));
+        QObject::connect(m_fakeBackend, SIGNAL(seatRemoved(QString)), q, SIGNAL(seatRemoved(QString)));
+        QObject::connect(m_fakeBackend, SIGNAL(sessionAdded(QString,QString)),
+                         q, SIGNAL(sessionAdded(QString,QString)));
+        QObject::connect(m_fakeBackend, SIGNAL(sessionRemoved(QString,QString)),
+                         q, SIGNAL(sessionRemoved(QString,QString)));
+        QObject::connect(m_fakeBackend, SIGNAL(activeSessionChanged(QString,QString)),
+                         q, SIGNAL(activeSessionChanged(QString,QString)));
+        // connected after the typed signals, so that they come first as with ConsoleKit
+        QObject::connect(m_fakeBackend, SIGNAL(seatAdded(QString)), q, SLOT(consoleKitChanged()));
+        QObject::connect(m_fakeBackend, SIGNAL(seatRemoved(QString)), q, SLOT(consoleKitChanged()));
+        QObject::connect(m_fakeBackend, SIGNAL(sessionAdded(QString,QString)), q, SLOT(consoleKitChanged()));
+        QObject::connect(m_fakeBackend, SIGNAL(sessionRemoved(QString,QString)), q, SLOT(consoleKitChanged()));
+        QObject::connect(m_fakeBackend, SIGNAL(activeSessionChanged(QString,QString)),
+                         q, SLOT(consoleKitChanged()));
+        return;
+    } else if (pkAuthority != NULL) {
+        // an authority handed to instance() is always used through libpolkit-gobject
+        g_signal_connect(G_OBJECT(pkAuthority), "changed", G_CALLBACK(pk_config_changed), NULL);
+        backend = m_scheduler->schedule(m_coalescing->coalesce(new PolkitAuthorityBackend(pkAuthority)));
+    } else if (AuthorityBackend::useDBus()) {
+        m_dbusBackend = true;
+        backend = m_scheduler->schedule(m_coalescing->coalesce(new DBusAuthorityBackend(QDBusConnection::systemBus())));
+        // polkitd tells about configuration changes with this signal
+        dbusSignalAdd("org.freedesktop.PolicyKit1", "/org/freedesktop/PolicyKit1/Authority",
+                      "org.freedesktop.PolicyKit1.Authority", "Changed");
 #ifndef POLKIT_QT_1_COMPATIBILITY_MODE
-    GError *gerror = NULL;
-#endif
-    if (pkAuthority == NULL) {
-#ifndef POLKIT_QT_1_COMPATIBILITY_MODE
-        pkAuthority = polkit_authority_get_sync(NULL, &gerror);
-        if (gerror != NULL) {
-            setError(E_GetAuthority, gerror->message);
-            g_error_free(gerror);
-            return;
-        }
-#else
-        pkAuthority = polkit_authority_get();
-#endif
-    }
-
-    if (pkAuthority == NULL) {
-#ifdef POLKIT_QT_1_COMPATIBILITY_MODE
-        (E_GetAuthority);
+    } else if (m_asyncInit) {
+        // finishInit() is called once polkitd answered
+        m_ready = false;
+        polkit_authority_get_async(NULL, authorityReadyCallback, q);
 #endif
-        return;
+    } else if (polkitAuthority() != NULL) {
+        backend = m_scheduler->schedule(m_coalescing->coalesce(new PolkitAuthorityBackend(pkAuthority)));
     }
 
-    // connect changed signal
-    g_signal_connect(G_OBJECT(pkAuthority), "changed", G_CALLBACK(pk_config_changed), NULL);
-
-    // need to listen to NameOwnerChanged
+    // need to listen to NameOwnerChanged, which also tells when polkitd is back after a failure
     dbusSignalAdd("org.freedesktop.DBus", "/", "org.freedesktop.DBus", "NameOwnerChanged");
 
     QString consoleKitService("org.freedesktop.ConsoleKit");
@@ -216,13 +699,17 @@ void Authority::Private::init()
     dbusSignalAdd(consoleKitService, consoleKitManagerPath, consoleKitManagerInterface, "SeatAdded");
     dbusSignalAdd(consoleKitService, consoleKitManagerPath, consoleKitManagerInterface, "SeatRemoved");
 
-    // then we need to extract all seats from ConsoleKit
+    // then we need to extract all seats from ConsoleKit, without waiting for it
     QDBusMessage msg = QDBusMessage::createMethodCall(consoleKitService, consoleKitManagerPath, consoleKitManagerInterface, "GetSeats");
-    msg = QDBusConnection::systemBus().call(msg);
-    if (!msg.arguments().isEmpty()) {
+    QDBusConnection::systemBus().callWithCallback(msg, q, SLOT(seatsListed(QDBusMessage)));
+}
+
+void Authority::Private::seatsListed(const QDBusMessage &message)
+{
+    if (!message.arguments().isEmpty()) {
         // this method returns a list with present seats
         QList<QString> seats;
-        qvariant_cast<QDBusArgument> (msg.arguments()[0]) >> seats;
+        qvariant_cast<QDBusArgument> (message.arguments()[0]) >> seats;
         // it can be multiple seats present so connect all their signals
         Q_FOREACH(const QString &seat, seats) {
             seatSignalsConnect(seat);
@@ -230,26 +717,352 @@ void Authority::Private::init()
     }
 }
 
+void Authority::Private::authorityReadyCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    Q_UNUSED(object);
+    Authority *authority = (Authority *) user_data;
+
+#ifndef POLKIT_QT_1_COMPATIBILITY_MODE
+    GError *error = NULL;
+    PolkitAuthority *pkAuthority = polkit_authority_get_finish(result, &error);
+    if (error != NULL) {
+        authority->d->finishInit(NULL, QString::fromUtf8(error->message));
+        g_error_free(error);
+        return;
+    }
+    authority->d->finishInit(pkAuthority, QString());
+#else
+    Q_UNUSED(result);
+    Q_UNUSED(authority);
+#endif
+}
+
+void Authority::Private::finishInit(PolkitAuthority *authority, const QString &errorDetails)
+{
+    QList<QueuedCheckAuthorization *> queued;
+    AuthorityBackend *target;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_ready) {
+            // a synchronous call did not wait for us
+            if (authority != NULL) {
+                g_object_unref(authority);
+            }
+            return;
+        }
+
+        if (authority != NULL) {
+            pkAuthority = authority;
+            // connect changed signal
+            g_signal_connect(G_OBJECT(pkAuthority), "changed", G_CALLBACK(pk_config_changed), NULL);
+            backend = m_scheduler->schedule(m_coalescing->coalesce(new PolkitAuthorityBackend(pkAuthority)));
+        } else {
+            m_initErrorDetails = errorDetails;
+        }
+        m_ready = true;
+        target = backend;
+        queued = m_queuedChecks;
+        m_queuedChecks.clear();
+    }
+
+    if (target == NULL) {
+        setError(E_GetAuthority, errorDetails);
+    }
+
+    Q_FOREACH(QueuedCheckAuthorization *check, queued) {
+        check->startLater(target);
+    }
+
+    Q_EMIT q->ready();
+}
+
+void Authority::Private::waitForReady()
+{
+    m_mutex.lock();
+    const bool ready = m_ready;
+    m_mutex.unlock();
+
+    if (ready) {
+        return;
+    }
+
+#ifndef POLKIT_QT_1_COMPATIBILITY_MODE
+    // polkit hands out the same authority, whichever call gets there first
+    GError *gerror = NULL;
+    PolkitAuthority *authority = polkit_authority_get_sync(NULL, &gerror);
+    if (gerror != NULL) {
+        finishInit(NULL, QString::fromUtf8(gerror->message));
+        g_error_free(gerror);
+        return;
+    }
+    finishInit(authority, QString());
+#endif
+}
+
+bool Authority::Private::checkBackend()
+{
+    waitForReady();
+
+    QMutexLocker locker(&m_mutex);
+    if (backend == NULL) {
+        const QString details = m_initErrorDetails;
+        locker.unlock();
+        setError(E_GetAuthority, details);
+        return false;
+    }
+    return true;
+}
+
+AuthorityBackend *Authority::Private::currentBackend()
+{
+    QMutexLocker locker(&m_mutex);
+    return backend;
+}
+
+bool Authority::Private::authorityFailed()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_ready && backend == NULL;
+}
+
+#ifdef POLKIT_QT_1_TRACEPOINTS
+static const char *subjectKind(PolkitSubject *subject)
+{
+    if (POLKIT_IS_UNIX_PROCESS(subject)) {
+        return "unix-process";
+    } else if (POLKIT_IS_UNIX_SESSION(subject)) {
+        return "unix-session";
+    } else if (POLKIT_IS_SYSTEM_BUS_NAME(subject)) {
+        return "system-bus-name";
+    }
+    return "unknown";
+}
+
+// Wraps the callback of a check to fire check__done
+struct TracedCheck
+{
+    CheckAuthorizationCallback callback;
+    void *userData;
+    QByteArray actionId;
+    const char *subjectKind;
+    QElapsedTimer timer;
+};
+
+static void tracedCheckCallback(const CheckAuthorizationReply &reply, void *user_data)
+{
+    TracedCheck *check = (TracedCheck *) user_data;
+    POLKITQT1_TRACE5(check__done, check->actionId.constData(), check->subjectKind, int(reply.result),
+                     reply.cancelled ? -1 : int(reply.error), (long long)(check->timer.nsecsElapsed() / 1000));
+    check->callback(reply, check->userData);
+    delete check;
+}
+#endif
+
+void Authority::Private::checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                                            Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                                            CheckAuthorizationCallback callback, void *userData)
+{
+#ifdef POLKIT_QT_1_TRACEPOINTS
+    // the checks are only wrapped while a tracer listens
+    if (POLKITQT1_ENABLED(check__start) || POLKITQT1_ENABLED(check__done)) {
+        TracedCheck *check = new TracedCheck;
+        check->callback = callback;
+        check->userData = userData;
+        check->actionId = actionId;
+        check->subjectKind = subjectKind(subject.subject());
+        check->timer.start();
+        POLKITQT1_TRACE3(check__start, actionId.constData(), check->subjectKind, int(flags));
+        callback = tracedCheckCallback;
+        userData = check;
+    }
+#endif
+
+    QMutexLocker locker(&m_mutex);
+    // past the grace period, the checks go to the backend and fail if polkitd is still away
+    if (!m_ready || (m_authorityLost && m_lostTimer.elapsed() < reconnectGracePeriod)) {
+        m_queuedChecks.append(new QueuedCheckAuthorization(subject, actionId, flags, cancellable, callback, userData));
+        return;
+    }
+    AuthorityBackend *target = backend;
+    locker.unlock();
+
+    if (target == NULL) {
+        // fail it from the event loop, as a real check would
+        (new QueuedCheckAuthorization(subject, actionId, flags, cancellable, callback, userData))->startLater(NULL);
+        return;
+    }
+    target->checkAuthorization(subject, actionId, flags, cancellable, callback, userData);
+}
+
+PolkitAuthority *Authority::Private::polkitAuthority()
+{
+    waitForReady();
+
+    QMutexLocker locker(&m_mutex);
+    if (pkAuthority != NULL) {
+        return pkAuthority;
+    }
+
+    if (m_fakeBackend != NULL) {
+        locker.unlock();
+        setError(E_GetAuthority, "Only authorization checks are supported by the fake backend");
+        return NULL;
+    }
+    const bool watchChanges = !m_dbusBackend;
+    // the other threads must not wait for the bus round trip
+    locker.unlock();
+
+#ifndef POLKIT_QT_1_COMPATIBILITY_MODE
+    GError *gerror = NULL;
+    PolkitAuthority *authority = polkit_authority_get_sync(NULL, &gerror);
+    if (gerror != NULL) {
+        setError(E_GetAuthority, gerror->message);
+        g_error_free(gerror);
+        return NULL;
+    }
+#else
+    PolkitAuthority *authority = polkit_authority_get();
+#endif
+
+    if (authority == NULL) {
+        setError(E_GetAuthority);
+        return NULL;
+    }
+
+    locker.relock();
+    return publishAuthority(authority, watchChanges);
+}
+
+PolkitAuthority *Authority::Private::publishAuthority(PolkitAuthority *authority, bool watchChanges)
+{
+    if (pkAuthority != NULL) {
+        // another thread got there first
+        g_object_unref(authority);
+        return pkAuthority;
+    }
+
+    pkAuthority = authority;
+    if (watchChanges) {
+        // connect changed signal
+        g_signal_connect(G_OBJECT(pkAuthority), "changed", G_CALLBACK(pk_config_changed), NULL);
+    }
+    return pkAuthority;
+}
+
 void Authority::Private::setError(Authority::ErrorCode code, const QString &details, bool recover)
 {
     if (recover) {
         init();
     }
-    m_lastError = code;
-    m_errorDetails = details;
-    m_hasError = true;
+    ErrorState &state = errorState();
+    state.lastError = code;
+    state.errorDetails = details;
+    state.hasError = true;
+    // the errors which are not the fault of the caller may be due to polkitd being away
+    state.connection = m_connection.load();
+    state.transient = code != E_WrongSubject && code != E_CookieOrIdentityEmpty;
+    if (state.operation) {
+        static_cast<OperationTimer *>(state.operation)->setFailed();
+    }
+}
+
+void Authority::Private::setError(Authority::ErrorCode code, GError *error, const Deadline &deadline)
+{
+    if (deadline.hasExpired()) {
+        setError(E_Timeout, QString::fromLatin1("The authority did not answer in time: %1").arg(error->message));
+    } else {
+        setError(code, error->message);
+    }
+}
+
+int Authority::Private::defaultTimeout() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_defaultTimeout;
+}
+
+ErrorState &Authority::Private::errorState()
+{
+    ErrorState &state = m_errorState.localData();
+    if (state.hasError && state.transient && state.connection != m_connection.load()) {
+        // polkitd came back since the error, which no longer applies
+        state.hasError = false;
+        state.lastError = E_None;
+    }
+    return state;
+}
+
+void Authority::Private::resetCancellable(GCancellable **cancellable)
+{
+    QMutexLocker locker(&m_mutex);
+    g_cancellable_cancel(*cancellable);
+    // running operations hold their own reference to the old cancellable
+    g_object_unref(*cancellable);
+    *cancellable = g_cancellable_new();
+}
+
+GCancellable *Authority::Private::refCancellable(GCancellable *const *cancellable)
+{
+    QMutexLocker locker(&m_mutex);
+    return (GCancellable *) g_object_ref(*cancellable);
+}
+
+quint64 Authority::Private::nextRequestId()
+{
+    QMutexLocker locker(&m_mutex);
+    return ++m_lastRequestId;
 }
 
+AsyncCall *Authority::Private::asyncCall(AuthorityMetrics::Operation operation)
+{
+    AsyncCall *call = new AsyncCall;
+    asyncCallStarted(call, operation);
+    return call;
+}
+
+void Authority::Private::asyncCallStarted(AsyncCall *call, AuthorityMetrics::Operation operation)
+{
+    call->authority = q;
+    call->operation = operation;
+    call->timer.start();
+    m_metrics.started(operation);
+}
+
+void Authority::Private::asyncCallFinished(const AsyncCall *call, AuthorityMetricsRecorder::Outcome outcome)
+{
+    m_metrics.finished(call->operation, call->timer.nsecsElapsed() / 1000, outcome);
+}
+
+AuthorityMetrics Authority::metrics() const
+{
+    return d->m_metrics.snapshot();
+}
+
+void Authority::resetMetrics()
+{
+    d->m_metrics.reset();
+}
+
+// The seat signals which may change authorizations; device hotplug does not
+static const char *const seatSignals[] = { "SessionAdded", "SessionRemoved", "ActiveSessionChanged" };
+
 void Authority::Private::seatSignalsConnect(const QString &seat)
 {
     QString consoleKitService("org.freedesktop.ConsoleKit");
     QString consoleKitSeatInterface("org.freedesktop.ConsoleKit.Seat");
-    // we want to connect to all slots of the seat
-    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "DeviceAdded");
-    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "DeviceRemoved");
-    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "SessionAdded");
-    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "SessionRemoved");
-    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "ActiveSessionChanged");
+    for (uint i = 0; i < sizeof(seatSignals) / sizeof(seatSignals[0]); ++i) {
+        dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, seatSignals[i]);
+    }
+}
+
+void Authority::Private::seatSignalsDisconnect(const QString &seat)
+{
+    QString consoleKitService("org.freedesktop.ConsoleKit");
+    QString consoleKitSeatInterface("org.freedesktop.ConsoleKit.Seat");
+    for (uint i = 0; i < sizeof(seatSignals) / sizeof(seatSignals[0]); ++i) {
+        QDBusConnection::systemBus().disconnect(consoleKitService, seat, consoleKitSeatInterface, seatSignals[i],
+                                                q, SLOT(dbusFilter(QDBusMessage)));
+    }
 }
 
 void Authority::Private::dbusSignalAdd(const QString &service, const QString &path, const QString &interface, const QString &name)
@@ -259,59 +1072,739 @@ void Authority::Private::dbusSignalAdd(const QString &service, const QString &pa
                                          q, SLOT(dbusFilter(QDBusMessage)));
 }
 
+// ConsoleKit passes object paths, except for ActiveSessionChanged which passes a string
+static QString objectPathArgument(const QDBusMessage &message)
+{
+    if (message.arguments().isEmpty()) {
+        return QString();
+    }
+
+    const QVariant argument = message.arguments().at(0);
+    if (argument.userType() == qMetaTypeId<QDBusObjectPath>()) {
+        return qvariant_cast<QDBusObjectPath>(argument).path();
+    }
+    return argument.toString();
+}
+
 void Authority::Private::dbusFilter(const QDBusMessage &message)
 {
-    if (message.type() == QDBusMessage::SignalMessage) {
-        Q_EMIT q->consoleKitDBChanged();
+    if (message.type() != QDBusMessage::SignalMessage) {
+        return;
+    }
 
+    const QString member = message.member();
+    if (member == "Changed" && message.interface() == "org.freedesktop.PolicyKit1.Authority") {
+        // the QtDBus backend gets the polkit configuration changes here
+        pk_config_changed();
+        return;
+    }
+
+    if (member == "NameOwnerChanged") {
+        if (message.arguments().isEmpty()) {
+            return;
+        }
+        // results obtained for a bus name are meaningless once its owner changes
+        const QString name = message.arguments()[0].toString();
+        cacheRemoveBusName(name);
+        if (name == QLatin1String(polkitService) && message.arguments().size() == 3) {
+            authorityOwnerChanged(message.arguments()[2].toString());
+            return;
+        }
+        // of all the names on the bus, only a restart of ConsoleKit affects sessions
+        if (name != "org.freedesktop.ConsoleKit") {
+            return;
+        }
+    } else if (member == "SeatAdded") {
         // TODO: Test this with the multiseat support
-        if (message.member() == "SeatAdded") {
-            seatSignalsConnect(qvariant_cast<QDBusObjectPath> (message.arguments()[0]).path());
+        const QString seat = objectPathArgument(message);
+        seatSignalsConnect(seat);
+        Q_EMIT q->seatAdded(seat);
+    } else if (member == "SeatRemoved") {
+        const QString seat = objectPathArgument(message);
+        seatSignalsDisconnect(seat);
+        Q_EMIT q->seatRemoved(seat);
+    } else if (member == "SessionAdded") {
+        Q_EMIT q->sessionAdded(message.path(), objectPathArgument(message));
+    } else if (member == "SessionRemoved") {
+        Q_EMIT q->sessionRemoved(message.path(), objectPathArgument(message));
+    } else if (member == "ActiveSessionChanged") {
+        Q_EMIT q->activeSessionChanged(message.path(), objectPathArgument(message));
+    } else {
+        return;
+    }
+
+    consoleKitChanged();
+}
+
+void Authority::Private::consoleKitChanged()
+{
+    // ConsoleKit seats and sessions changed
+    cacheClear();
+    Q_EMIT q->consoleKitDBChanged();
+    scheduleChange();
+}
+
+void Authority::Private::authorityOwnerChanged(const QString &owner)
+{
+    if (!owner.isEmpty()) {
+        // no need to ask the bus who we just heard from
+        reattach();
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_ready || m_authorityLost || backend == NULL) {
+        return;
+    }
+    // polkitd restarts during upgrades: hold the checks until it is back
+    m_authorityLost = true;
+    m_lostTimer.start();
+    m_reconnectDelay = reconnectMinDelay;
+    locker.unlock();
+    m_reconnectTimer->start(m_reconnectDelay);
+}
+
+void Authority::Private::reconnect()
+{
+    m_mutex.lock();
+    const bool lost = m_authorityLost;
+    m_mutex.unlock();
+    if (!lost) {
+        return;
+    }
+
+    // on the thread of the authority, usually the GUI one, which must not wait for the bus
+    QDBusMessage query = QDBusMessage::createMethodCall("org.freedesktop.DBus", "/org/freedesktop/DBus",
+                                                        "org.freedesktop.DBus", "NameHasOwner");
+    query << QString::fromLatin1(polkitService);
+    if (!QDBusConnection::systemBus().callWithCallback(query, q, SLOT(authorityQueried(QDBusMessage)))) {
+        reconnectLater();
+    }
+}
+
+void Authority::Private::authorityQueried(const QDBusMessage &message)
+{
+    const bool registered = message.type() == QDBusMessage::ReplyMessage && !message.arguments().isEmpty()
+                            && message.arguments().at(0).toBool();
+    if (registered) {
+        reattach();
+        return;
+    }
+
+    m_mutex.lock();
+    const bool lost = m_authorityLost;
+    m_mutex.unlock();
+    if (lost) {
+        reconnectLater();
+    }
+}
+
+void Authority::Private::reattach()
+{
+    m_mutex.lock();
+    const bool failed = m_ready && backend == NULL;
+    const bool lost = m_authorityLost;
+    m_mutex.unlock();
+    if (!lost && !failed) {
+        return;
+    }
+
+    if (failed && !connectBackend()) {
+        if (lost) {
+            reconnectLater();
+        }
+        return;
+    }
+
+    QList<QueuedCheckAuthorization *> queued;
+    AuthorityBackend *target;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_authorityLost = false;
+        m_initErrorDetails.clear();
+        target = backend;
+        queued = m_queuedChecks;
+        m_queuedChecks.clear();
+    }
+    m_reconnectTimer->stop();
+    m_connection.ref();
+
+    Q_FOREACH(QueuedCheckAuthorization *check, queued) {
+        check->startLater(target);
+    }
+
+    // the new polkitd may come with other policies
+    polkitChanged();
+}
+
+bool Authority::Private::connectBackend()
+{
+    QMutexLocker locker(&m_mutex);
+    if (pkAuthority == NULL) {
+        locker.unlock();
+#ifndef POLKIT_QT_1_COMPATIBILITY_MODE
+        GError *gerror = NULL;
+        PolkitAuthority *authority = polkit_authority_get_sync(NULL, &gerror);
+        if (gerror != NULL) {
+            g_error_free(gerror);
+            return false;
+        }
+#else
+        PolkitAuthority *authority = polkit_authority_get();
+#endif
+        if (authority == NULL) {
+            return false;
+        }
+        locker.relock();
+        publishAuthority(authority, true);
+    }
+
+    backend = m_scheduler->schedule(m_coalescing->coalesce(new PolkitAuthorityBackend(pkAuthority)));
+    return true;
+}
+
+void Authority::Private::reconnectLater()
+{
+    // polkitd is bus activated, and NameOwnerChanged tells once it is up
+    QDBusMessage start = QDBusMessage::createMethodCall("org.freedesktop.DBus", "/org/freedesktop/DBus",
+                                                        "org.freedesktop.DBus", "StartServiceByName");
+    start << QString::fromLatin1(polkitService) << 0u;
+    QDBusConnection::systemBus().call(start, QDBus::NoBlock);
+
+    QList<QueuedCheckAuthorization *> expired;
+    m_mutex.lock();
+    if (m_lostTimer.elapsed() >= reconnectGracePeriod) {
+        // the checks which waited long enough are sent, and fail if polkitd is still away
+        expired = m_queuedChecks;
+        m_queuedChecks.clear();
+    }
+    AuthorityBackend *target = backend;
+    m_mutex.unlock();
+
+    Q_FOREACH(QueuedCheckAuthorization *check, expired) {
+        check->startLater(target);
+    }
+
+    m_reconnectTimer->start(m_reconnectDelay);
+    m_reconnectDelay = qMin(2 * m_reconnectDelay, reconnectMaxDelay);
+}
+
+bool Authority::isReady() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_ready;
+}
+
+bool Authority::hasError() const
+{
+    return d->errorState().hasError;
+}
+
+Authority::ErrorCode Authority::lastError() const
+{
+    return d->errorState().lastError;
+}
+
+const QString Authority::errorDetails() const
+{
+    const ErrorState &state = d->errorState();
+    if (state.lastError == E_None) {
+        return QString();
+    } else {
+        return state.errorDetails;
+    }
+}
+
+void Authority::clearError()
+{
+    ErrorState &state = d->errorState();
+    state.hasError = false;
+    state.lastError = E_None;
+}
+
+void Authority::setCachingEnabled(bool enabled)
+{
+    QMutexLocker locker(&d->m_mutex);
+    d->m_cacheEnabled = enabled;
+    if (!enabled) {
+        d->m_cache.clear();
+        d->m_cacheBusNames.clear();
+        d->m_cacheExpiries.clear();
+        d->m_temporaryExpiries.clear();
+        d->m_temporaryResults.clear();
+    }
+}
+
+bool Authority::isCachingEnabled() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_cacheEnabled;
+}
+
+void Authority::clearCache()
+{
+    d->cacheClear();
+}
+
+quint64 Authority::cacheHits() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_cacheHits;
+}
+
+quint64 Authority::cacheMisses() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_cacheMisses;
+}
+
+void Authority::setDefaultTimeout(int msec)
+{
+    QMutexLocker locker(&d->m_mutex);
+    d->m_defaultTimeout = msec < 0 ? -1 : msec;
+}
+
+int Authority::defaultTimeout() const
+{
+    return d->defaultTimeout();
+}
+
+void Authority::setCheckCoalescingEnabled(bool enabled)
+{
+    d->m_coalescing->setEnabled(enabled);
+}
+
+bool Authority::isCheckCoalescingEnabled() const
+{
+    return d->m_coalescing->isEnabled();
+}
+
+quint64 Authority::coalescedChecks() const
+{
+    return d->m_coalescing->coalescedChecks();
+}
+
+void Authority::setInteractiveCheckLimit(int limit)
+{
+    d->m_scheduler->setLimit(AuthorityMetrics::InteractiveLane, limit);
+}
+
+int Authority::interactiveCheckLimit() const
+{
+    return d->m_scheduler->limit(AuthorityMetrics::InteractiveLane);
+}
+
+void Authority::setBackgroundCheckLimit(int limit)
+{
+    d->m_scheduler->setLimit(AuthorityMetrics::BackgroundLane, limit);
+}
+
+int Authority::backgroundCheckLimit() const
+{
+    return d->m_scheduler->limit(AuthorityMetrics::BackgroundLane);
+}
+
+QString Authority::Private::cacheKey(const QString &actionId, const Subject &subject, Authority::AuthorizationFlags flags) const
+{
+    if (flags & AllowUserInteraction) {
+        return QString();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_cacheEnabled) {
+            return QString();
+        }
+    }
+
+    return actionId + QLatin1Char('\n') + subjectToString(subject.subject())
+           + QLatin1Char('\n') + QString::number(int(flags));
+}
+
+bool Authority::Private::cacheLookup(const QString &key, Authority::Result *result)
+{
+    QMutexLocker locker(&m_mutex);
+    QHash<QString, CacheEntry>::iterator it = m_cache.find(key);
+    if (it != m_cache.end() && it->expiresAt >= 0 && it->expiresAt <= m_cacheClock.elapsed()) {
+        // stale already, the expiry timer just did not run yet
+        m_cache.erase(it);
+        it = m_cache.end();
+    }
+    if (it == m_cache.end()) {
+        ++m_cacheMisses;
+        return false;
+    }
+
+    ++m_cacheHits;
+    *result = it->result;
+    return true;
+}
+
+void Authority::Private::cacheInsert(const QString &key, const Subject &subject, Authority::Result result, qint64 expiresAt)
+{
+    if (key.isEmpty() || result == Unknown) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_cacheEnabled) {
+        return;
+    }
+
+    m_cache.insert(key, CacheEntry(result, expiresAt));
+    if (POLKIT_IS_SYSTEM_BUS_NAME(subject.subject())) {
+        m_cacheBusNames.insert(QString::fromUtf8(polkit_system_bus_name_get_name(POLKIT_SYSTEM_BUS_NAME(subject.subject()))), key);
+    }
+    if (expiresAt >= 0) {
+        const bool first = m_cacheExpiries.isEmpty() || expiresAt < m_cacheExpiries.firstKey();
+        m_cacheExpiries.insert(expiresAt, key);
+        if (first) {
+            // the timer belongs to the authority thread
+            QMetaObject::invokeMethod(q, "scheduleCacheExpiry", Qt::QueuedConnection);
+        }
+    }
+}
+
+void Authority::Private::cacheInsertTemporary(const QString &key, const Subject &subject, const QString &id)
+{
+    if (key.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    // the fake backend makes up its ids, polkitd would not know them
+    if (!m_cacheEnabled || m_fakeBackend != NULL) {
+        return;
+    }
+
+    QHash<QString, qint64>::const_iterator known = m_temporaryExpiries.constFind(id);
+    if (known != m_temporaryExpiries.constEnd()) {
+        const qint64 expiresAt = known.value();
+        locker.unlock();
+        cacheInsert(key, subject, Yes, expiresAt);
+        return;
+    }
+
+    TemporaryResult waiting;
+    waiting.cacheKey = key;
+    waiting.subject = subject;
+    m_temporaryResults.insert(id, waiting);
+    if (!m_temporaryLookup) {
+        m_temporaryLookup = true;
+        QMetaObject::invokeMethod(q, "lookupTemporaryAuthorizations", Qt::QueuedConnection);
+    }
+}
+
+void Authority::Private::checkFinished(const QString &key, const QString &actionId, const Subject &subject,
+                                       Authority::AuthorizationFlags flags, const CheckAuthorizationReply &reply)
+{
+    if (!reply.temporaryAuthorizationId.isEmpty()) {
+        bool seen;
+        {
+            QMutexLocker locker(&m_mutex);
+            seen = m_temporaryIds.contains(reply.temporaryAuthorizationId);
+            m_temporaryIds.insert(reply.temporaryAuthorizationId);
+        }
+        if (!seen) {
+            Q_EMIT q->temporaryAuthorizationsChanged();
+        }
+    }
+
+    if (!(flags & AllowUserInteraction)) {
+        if (reply.temporaryAuthorizationId.isEmpty()) {
+            cacheInsert(key, subject, reply.result);
+        } else if (reply.result == Yes) {
+            // only good until the temporary authorization expires
+            cacheInsertTemporary(key, subject, reply.temporaryAuthorizationId);
+        }
+        return;
+    }
+
+    cacheRemove(actionId, subject);
+    if (reply.result == Yes && !reply.temporaryAuthorizationId.isEmpty()) {
+        // the authorization obtained interactively answers the non-interactive checks to come
+        cacheInsertTemporary(cacheKey(actionId, subject, None), subject, reply.temporaryAuthorizationId);
+    }
+}
+
+void Authority::Private::cacheRemove(const QString &actionId, const Subject &subject)
+{
+    // The interactive check may have granted a temporary authorization, so the
+    // non-interactive result we remember for the same action is stale now
+    const QString key = actionId + QLatin1Char('\n') + subjectToString(subject.subject())
+                        + QLatin1Char('\n') + QString::number(int(None));
+
+    QMutexLocker locker(&m_mutex);
+    m_cache.remove(key);
+}
+
+void Authority::Private::cacheRemoveBusName(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    QMultiHash<QString, QString>::iterator it = m_cacheBusNames.find(name);
+    while (it != m_cacheBusNames.end() && it.key() == name) {
+        m_cache.remove(it.value());
+        it = m_cacheBusNames.erase(it);
+    }
+}
+
+void Authority::Private::cacheClear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+    m_cacheBusNames.clear();
+    m_cacheExpiries.clear();
+    // a temporary authorization may have been revoked
+    m_temporaryExpiries.clear();
+    m_temporaryResults.clear();
+}
+
+void Authority::Private::temporaryAuthorizationsRevoked()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_temporaryIds.clear();
+    }
+    Q_EMIT q->temporaryAuthorizationsChanged();
+}
+
+void Authority::Private::cacheExpire()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        const qint64 now = m_cacheClock.elapsed();
+        QMultiMap<qint64, QString>::iterator it = m_cacheExpiries.begin();
+        while (it != m_cacheExpiries.end() && it.key() <= now) {
+            // the result may have been replaced since
+            QHash<QString, CacheEntry>::iterator entry = m_cache.find(it.value());
+            if (entry != m_cache.end() && entry->expiresAt == it.key()) {
+                m_cache.erase(entry);
+            }
+            it = m_cacheExpiries.erase(it);
+        }
+
+        QHash<QString, qint64>::iterator temporary = m_temporaryExpiries.begin();
+        while (temporary != m_temporaryExpiries.end()) {
+            if (temporary.value() <= now) {
+                temporary = m_temporaryExpiries.erase(temporary);
+            } else {
+                ++temporary;
+            }
         }
     }
+
+    scheduleCacheExpiry();
+}
+
+void Authority::Private::scheduleCacheExpiry()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_cacheExpiries.isEmpty()) {
+        m_cacheExpiryTimer->stop();
+        return;
+    }
+
+    m_cacheExpiryTimer->start(int(qMax<qint64>(0, m_cacheExpiries.firstKey() - m_cacheClock.elapsed())));
+}
+
+void Authority::Private::lookupTemporaryAuthorizations()
+{
+    TemporaryLookup *lookup = new TemporaryLookup;
+    lookup->authority = q;
+    {
+        QMutexLocker locker(&m_mutex);
+        lookup->results = m_temporaryResults;
+        m_temporaryResults.clear();
+    }
+
+    if (lookup->results.isEmpty()) {
+        temporaryLookupFinished(lookup);
+    } else if (m_session == NULL) {
+        // polkitd only lists the temporary authorizations of the caller's own session
+        polkit_unix_session_new_for_process(QCoreApplication::applicationPid(), NULL,
+                                            temporaryLookupSessionCallback, lookup);
+    } else {
+        temporaryLookupEnumerate(lookup);
+    }
+}
+
+void Authority::Private::temporaryLookupSessionCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    Q_UNUSED(object);
+    TemporaryLookup *lookup = (TemporaryLookup *) user_data;
+    Authority::Private *d = lookup->authority->d;
+
+    GError *error = NULL;
+    PolkitSubject *session = polkit_unix_session_new_for_process_finish(result, &error);
+    if (session == NULL) {
+        // no session, e.g. a system service: its results are simply not cached
+        if (error != NULL) {
+            g_error_free(error);
+        }
+        d->temporaryLookupFinished(lookup);
+        return;
+    }
+
+    if (d->m_session == NULL) {
+        d->m_session = session;
+    } else {
+        g_object_unref(session);
+    }
+    d->temporaryLookupEnumerate(lookup);
+}
+
+void Authority::Private::temporaryLookupEnumerate(TemporaryLookup *lookup)
+{
+    PolkitAuthority *authority = polkitAuthority();
+    if (authority == NULL) {
+        temporaryLookupFinished(lookup);
+        return;
+    }
+
+    polkit_authority_enumerate_temporary_authorizations(authority, m_session, NULL,
+                                                        temporaryLookupCallback, lookup);
+}
+
+void Authority::Private::temporaryLookupCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    TemporaryLookup *lookup = (TemporaryLookup *) user_data;
+    Authority::Private *d = lookup->authority->d;
+
+    GError *error = NULL;
+    GList *glist = polkit_authority_enumerate_temporary_authorizations_finish((PolkitAuthority *) object, result, &error);
+    if (error != NULL) {
+        g_error_free(error);
+        d->temporaryLookupFinished(lookup);
+        return;
+    }
+
+    {
+        QMutexLocker locker(&d->m_mutex);
+        const qint64 now = d->m_cacheClock.elapsed();
+        const qint64 wallNow = QDateTime::currentMSecsSinceEpoch();
+        for (GList *glist2 = glist; glist2 != NULL; glist2 = g_list_next(glist2)) {
+            PolkitTemporaryAuthorization *authorization = (PolkitTemporaryAuthorization *) glist2->data;
+            // polkitd truncates to the second, so this never outlives the authorization
+            const qint64 expiresAt = now + qint64(polkit_temporary_authorization_get_time_expires(authorization)) * 1000 - wallNow;
+            if (expiresAt > now) {
+                d->m_temporaryExpiries.insert(QString::fromUtf8(polkit_temporary_authorization_get_id(authorization)), expiresAt);
+            }
+            g_object_unref(authorization);
+        }
+    }
+    g_list_free(glist);
+
+    d->temporaryLookupFinished(lookup);
+}
+
+void Authority::Private::temporaryLookupFinished(TemporaryLookup *lookup)
+{
+    QMultiHash<QString, TemporaryResult>::const_iterator it = lookup->results.constBegin();
+    for (; it != lookup->results.constEnd(); ++it) {
+        qint64 expiresAt;
+        {
+            QMutexLocker locker(&m_mutex);
+            // unknown ids have expired, were revoked, or belong to another session
+            if (!m_temporaryExpiries.contains(it.key())) {
+                continue;
+            }
+            expiresAt = m_temporaryExpiries.value(it.key());
+        }
+        cacheInsert(it->cacheKey, it->subject, Yes, expiresAt);
+    }
+    delete lookup;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_temporaryResults.isEmpty()) {
+        m_temporaryLookup = false;
+    } else {
+        // more results came in meanwhile, which this lookup may have missed
+        QMetaObject::invokeMethod(q, "lookupTemporaryAuthorizations", Qt::QueuedConnection);
+    }
+}
+
+void Authority::Private::pk_config_changed()
+{
+    Authority::instance()->d->polkitChanged();
+}
+
+void Authority::Private::polkitChanged()
+{
+    q->clearCache();
+    Q_EMIT q->configChanged();
+    // polkit may report from another thread than the timer's
+    QMetaObject::invokeMethod(q, "scheduleChange");
+}
+
+void Authority::Private::scheduleChange()
+{
+    if (m_changeTimer->isActive()) {
+        return;
+    }
+
+    m_mutex.lock();
+    const int window = m_changeWindow;
+    m_mutex.unlock();
+    m_changeTimer->start(window);
 }
 
-bool Authority::hasError() const
+void Authority::Private::emitChange()
 {
-    return d->m_hasError;
+    m_mutex.lock();
+    const quint64 generation = ++m_changeGeneration;
+    m_mutex.unlock();
+    Q_EMIT q->changed(generation);
 }
 
-Authority::ErrorCode Authority::lastError() const
+void Authority::setChangeCoalescingWindow(int msec)
 {
-    return d->m_lastError;
+    QMutexLocker locker(&d->m_mutex);
+    d->m_changeWindow = qMax(0, msec);
 }
 
-const QString Authority::errorDetails() const
+int Authority::changeCoalescingWindow() const
 {
-    if (d->m_lastError == E_None) {
-        return QString();
-    } else {
-        return d->m_errorDetails;
-    }
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_changeWindow;
 }
 
-void Authority::clearError()
+quint64 Authority::changeGeneration() const
 {
-    d->m_hasError = false;
-    d->m_lastError = E_None;
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_changeGeneration;
 }
 
-void Authority::Private::pk_config_changed()
+PolkitAuthority *Authority::polkitAuthority() const
 {
-    Q_EMIT Authority::instance()->configChanged();
+    return d->polkitAuthority();
 }
 
-PolkitAuthority *Authority::polkitAuthority() const
+// Result of a check run by checkAuthorizationSync()
+struct SyncCheck
+{
+    CheckAuthorizationReply reply;
+    bool done;
+};
+
+static void syncCheckCallback(const CheckAuthorizationReply &reply, void *user_data)
 {
-    return d->pkAuthority;
+    SyncCheck *check = (SyncCheck *) user_data;
+    check->reply = reply;
+    check->done = true;
 }
 
 Authority::Result Authority::checkAuthorizationSync(const QString &actionId, const Subject &subject, AuthorizationFlags flags)
 {
-    PolkitAuthorizationResult *pk_result;
-    GError *error = NULL;
+    return checkAuthorizationSync(actionId, subject, flags, d->defaultTimeout());
+}
 
+Authority::Result Authority::checkAuthorizationSync(const QString &actionId, const Subject &subject,
+                                                    AuthorizationFlags flags, int timeout)
+{
+    Private::OperationTimer timer(d, AuthorityMetrics::CheckAuthorizationSync);
     if (Authority::instance()->hasError()) {
+        // refused without asking polkitd, which still counts as a failure
+        timer.setFailed();
         return Unknown;
     }
 
@@ -320,28 +1813,37 @@ Authority::Result Authority::checkAuthorizationSync(const QString &actionId, con
         return Unknown;
     }
 
-    pk_result = polkit_authority_check_authorization_sync(d->pkAuthority,
-                subject.subject(),
-                actionId.toLatin1().data(),
-                NULL,
-                (PolkitCheckAuthorizationFlags)(int)flags,
-                NULL,
-                &error);
+    if (!d->checkBackend()) {
+        return Unknown;
+    }
 
-    if (error != NULL) {
-        d->setError(E_CheckFailed, error->message);
-        g_error_free(error);
+    const QString key = d->cacheKey(actionId, subject, flags);
+    Authority::Result cached;
+    if (!key.isEmpty() && d->cacheLookup(key, &cached)) {
+        return cached;
+    }
+
+    SyncCheck check;
+    check.done = false;
+    Deadline deadline(timeout);
+    AuthorityBackend *backend = d->currentBackend();
+    backend->beginBlocking();
+    backend->checkAuthorization(subject, actionId.toLatin1(), flags, deadline.cancellable(), syncCheckCallback, &check);
+    backend->waitForCompletion(&check.done);
+    backend->endBlocking();
+
+    if ((check.reply.cancelled || check.reply.error != E_None) && deadline.hasExpired()) {
+        d->setError(E_Timeout, QString::fromLatin1("The authority did not answer within %1 ms").arg(timeout));
         return Unknown;
     }
 
-    if (!pk_result) {
-        d->setError(E_UnknownResult);
+    if (check.reply.error != E_None) {
+        d->setError(check.reply.error, check.reply.errorDetails);
         return Unknown;
-    } else {
-        Authority::Result res = polkitResultToResult(pk_result);
-        g_object_unref(pk_result);
-        return res;
     }
+
+    d->checkFinished(key, actionId, subject, flags, check.reply);
+    return check.reply.result;
 }
 
 void Authority::checkAuthorization(const QString &actionId, const Subject &subject, AuthorizationFlags flags)
@@ -355,61 +1857,359 @@ void Authority::checkAuthorization(const QString &actionId, const Subject &subje
         return;
     }
 
-    polkit_authority_check_authorization(d->pkAuthority,
-                                         subject.subject(),
-                                         actionId.toLatin1().data(),
-                                         NULL,
-                                         (PolkitCheckAuthorizationFlags)(int)flags,
-                                         d->m_checkAuthorizationCancellable,
-                                         d->checkAuthorizationCallback, this);
+    CheckAuthorizationData *data = new CheckAuthorizationData;
+    d->asyncCallStarted(data, AuthorityMetrics::CheckAuthorization);
+    data->actionId = actionId;
+    data->subject = subject;
+    data->flags = flags;
+    data->cacheKey = d->cacheKey(actionId, subject, flags);
+
+    Authority::Result cached;
+    if (!data->cacheKey.isEmpty() && d->cacheLookup(data->cacheKey, &cached)) {
+        d->asyncCallFinished(data, AuthorityMetricsRecorder::Succeeded);
+        delete data;
+        // keep the signal asynchronous, as callers expect
+        QMetaObject::invokeMethod(this, "checkAuthorizationFinished", Qt::QueuedConnection,
+                                  Q_ARG(PolkitQt1::Authority::Result, cached));
+        return;
+    }
+
+    GCancellable *cancellable = d->refCancellable(&d->m_checkAuthorizationCancellable);
+    d->checkAuthorization(subject, actionId.toLatin1(), flags, cancellable,
+                          d->checkAuthorizationCallback, data);
+    g_object_unref(cancellable);
 }
 
-void Authority::Private::checkAuthorizationCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+void Authority::Private::checkAuthorizationCallback(const CheckAuthorizationReply &reply, void *user_data)
 {
-    Authority *authority = (Authority *) user_data;
+    CheckAuthorizationData *data = (CheckAuthorizationData *) user_data;
+    Authority *authority = data->authority;
 
     Q_ASSERT(authority != NULL);
+    OperationTimer timer(data);
 
-    GError *error = NULL;
-    PolkitAuthorizationResult *pkResult = polkit_authority_check_authorization_finish((PolkitAuthority *) object, result, &error);
+    // We don't want to set error if this is cancellation of some action
+    if (reply.cancelled) {
+        timer.setCancelled();
+        delete data;
+        return;
+    }
 
-    if (error != NULL) {
-        // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
-            authority->d->setError(E_CheckFailed, error->message);
+    if (reply.error != E_None) {
+        authority->d->setError(reply.error, reply.errorDetails);
+    } else {
+        authority->d->checkFinished(data->cacheKey, data->actionId, data->subject, data->flags, reply);
+        Q_EMIT authority->checkAuthorizationFinished(reply.result);
+    }
+    delete data;
+}
+
+PendingAuthorization *Authority::checkAuthorizationAsync(const QString &actionId, const Subject &subject,
+                                                        AuthorizationFlags flags, QObject *parent)
+{
+    PendingAuthorization *request = new PendingAuthorization(d->nextRequestId(), actionId, subject, flags, parent);
+
+    CheckAuthorizationData *data = new CheckAuthorizationData;
+    d->asyncCallStarted(data, AuthorityMetrics::CheckAuthorizationAsync);
+    data->request = request;
+    data->actionId = actionId;
+    data->subject = subject;
+    data->flags = flags;
+
+    if (!subject.isValid() || d->authorityFailed()) {
+        d->asyncCallFinished(data, AuthorityMetricsRecorder::Failed);
+        delete data;
+        request->d->finishLater(Unknown, subject.isValid() ? E_GetAuthority : E_WrongSubject);
+        return request;
+    }
+
+    data->cacheKey = d->cacheKey(actionId, subject, flags);
+
+    Authority::Result cached;
+    if (!data->cacheKey.isEmpty() && d->cacheLookup(data->cacheKey, &cached)) {
+        d->asyncCallFinished(data, AuthorityMetricsRecorder::Succeeded);
+        delete data;
+        request->d->finishLater(cached);
+        return request;
+    }
+
+    d->checkAuthorization(subject, actionId.toLatin1(), flags, request->d->cancellable,
+                          d->pendingCheckAuthorizationCallback, data);
+    return request;
+}
+
+void Authority::Private::pendingCheckAuthorizationCallback(const CheckAuthorizationReply &reply, void *user_data)
+{
+    CheckAuthorizationData *data = (CheckAuthorizationData *) user_data;
+    Authority *authority = data->authority;
+    // the request is gone if the caller deleted it while we were waiting
+    PendingAuthorization *request = data->request;
+    OperationTimer timer(data);
+
+    if (reply.cancelled) {
+        timer.setCancelled();
+        if (request) {
+            request->d->cancelled = true;
+            request->d->finish(Unknown);
         }
-        g_error_free(error);
+        delete data;
         return;
     }
-    if (pkResult != NULL) {
-        Q_EMIT authority->checkAuthorizationFinished(polkitResultToResult(pkResult));
-        g_object_unref(pkResult);
+
+    if (reply.error == E_None) {
+        authority->d->checkFinished(data->cacheKey, data->actionId, data->subject, data->flags, reply);
     } else {
-        authority->d->setError(E_UnknownResult);
+        timer.setFailed();
+    }
+    if (request) {
+        request->d->finish(reply.result, reply.error, reply.errorDetails);
     }
+    delete data;
 }
 
-void Authority::checkAuthorizationCancel()
+void Authority::setBulkCheckWindow(int window)
+{
+    QMutexLocker locker(&d->m_mutex);
+    d->m_bulkCheckWindow = qMax(1, window);
+}
+
+int Authority::bulkCheckWindow() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_bulkCheckWindow;
+}
+
+BulkCheck *Authority::Private::bulkCheckCreate(const QStringList &actionIds, const QList<Subject> &subjects,
+                                               Authority::AuthorizationFlags flags, GCancellable *cancellable, bool async)
+{
+    BulkCheck *bulk = new BulkCheck;
+    asyncCallStarted(bulk, async ? AuthorityMetrics::CheckAuthorizations : AuthorityMetrics::CheckAuthorizationsSync);
+    bulk->subjects = subjects;
+    bulk->flags = flags;
+    bulk->matrix = AuthorizationMatrix(actionIds, subjects);
+    bulk->next = 0;
+    bulk->inFlight = 0;
+    // the request owning the cancellable may be deleted before all the replies are in
+    bulk->cancellable = (GCancellable *) g_object_ref(cancellable);
+    bulk->backend = NULL;
+    bulk->async = async;
+    bulk->done = false;
+
+    Q_FOREACH(const QString &actionId, actionIds) {
+        bulk->actionIds.append(actionId.toLatin1());
+    }
+
+    for (int row = 0; row < actionIds.size(); ++row) {
+        for (int column = 0; column < subjects.size(); ++column) {
+            const Subject &subject = subjects.at(column);
+            if (!subject.isValid()) {
+                bulk->matrix.setError(row, column, E_WrongSubject);
+                continue;
+            }
+            if (authorityFailed()) {
+                bulk->matrix.setError(row, column, E_GetAuthority);
+                continue;
+            }
+
+            const QString key = cacheKey(actionIds.at(row), subject, flags);
+            Authority::Result cached;
+            if (!key.isEmpty() && cacheLookup(key, &cached)) {
+                bulk->matrix.setResult(row, column, cached);
+                continue;
+            }
+
+            bulk->cells.append(row * subjects.size() + column);
+            bulk->cacheKeys.append(key);
+        }
+    }
+
+    return bulk;
+}
+
+void Authority::Private::bulkCheckFill(BulkCheck *bulk)
+{
+    m_mutex.lock();
+    const int window = m_bulkCheckWindow;
+    m_mutex.unlock();
+
+    while (bulk->inFlight < window && bulk->next < bulk->cells.size()
+            && !g_cancellable_is_cancelled(bulk->cancellable)) {
+        BulkCheckCell *cell = new BulkCheckCell;
+        cell->bulk = bulk;
+        cell->cell = bulk->next++;
+
+        const int index = bulk->cells.at(cell->cell);
+        const int columns = bulk->subjects.size();
+        ++bulk->inFlight;
+        if (bulk->backend != NULL) {
+            bulk->backend->checkAuthorization(bulk->subjects.at(index % columns), bulk->actionIds.at(index / columns),
+                                              bulk->flags, bulk->cancellable, bulkCheckCallback, cell);
+        } else {
+            checkAuthorization(bulk->subjects.at(index % columns), bulk->actionIds.at(index / columns),
+                               bulk->flags, bulk->cancellable, bulkCheckCallback, cell);
+        }
+    }
+
+    if (bulk->inFlight == 0) {
+        bulkCheckFinish(bulk);
+    }
+}
+
+static AuthorityMetricsRecorder::Outcome bulkCheckOutcome(const BulkCheck *bulk)
+{
+    if (g_cancellable_is_cancelled(bulk->cancellable)) {
+        return AuthorityMetricsRecorder::Cancelled;
+    } else if (bulk->matrix.errorCount() > 0) {
+        return AuthorityMetricsRecorder::Failed;
+    }
+    return AuthorityMetricsRecorder::Succeeded;
+}
+
+void Authority::Private::bulkCheckFinish(BulkCheck *bulk)
+{
+    bulk->done = true;
+    bulk->matrix.setElapsed(bulk->timer.elapsed());
+    asyncCallFinished(bulk, bulkCheckOutcome(bulk));
+
+    if (!bulk->async) {
+        // checkAuthorizationsSync() picks up the result and frees the check
+        return;
+    }
+
+    if (bulk->request) {
+        bulk->request->d->finish(bulk->matrix);
+    }
+    delete bulk;
+}
+
+void Authority::Private::bulkCheckCallback(const CheckAuthorizationReply &reply, void *user_data)
+{
+    BulkCheckCell *cell = (BulkCheckCell *) user_data;
+    BulkCheck *bulk = cell->bulk;
+    Authority *authority = bulk->authority;
+    const int index = bulk->cells.at(cell->cell);
+    const int row = index / bulk->subjects.size();
+    const int column = index % bulk->subjects.size();
+
+    if (reply.cancelled) {
+        // cancelled cells simply stay unknown
+    } else if (reply.error != E_None) {
+        bulk->matrix.setError(row, column, reply.error, reply.errorDetails);
+    } else {
+        bulk->matrix.setResult(row, column, reply.result);
+        authority->d->checkFinished(bulk->cacheKeys.at(cell->cell), QString::fromLatin1(bulk->actionIds.at(row)),
+                                    bulk->subjects.at(column), bulk->flags, reply);
+    }
+
+    delete cell;
+    --bulk->inFlight;
+    authority->d->bulkCheckFill(bulk);
+}
+
+AuthorizationMatrix Authority::checkAuthorizationsSync(const QStringList &actionIds, const QList<Subject> &subjects,
+                                                       AuthorizationFlags flags)
+{
+    return checkAuthorizationsSync(actionIds, subjects, flags, d->defaultTimeout());
+}
+
+AuthorizationMatrix Authority::checkAuthorizationsSync(const QStringList &actionIds, const QList<Subject> &subjects,
+                                                       AuthorizationFlags flags, int timeout)
+{
+    d->waitForReady();
+
+    Deadline deadline(timeout);
+    BulkCheck *bulk = d->bulkCheckCreate(actionIds, subjects, flags, deadline.cancellable(), false);
+
+    AuthorityBackend *backend = d->currentBackend();
+    if (backend == NULL) {
+        // every cell already carries E_GetAuthority
+        d->bulkCheckFinish(bulk);
+    } else {
+        // like checkAuthorizationSync(), it asks a lost authority right away instead of waiting for it
+        bulk->backend = backend;
+        backend->beginBlocking();
+        d->bulkCheckFill(bulk);
+        backend->waitForCompletion(&bulk->done);
+        backend->endBlocking();
+    }
+
+    if (deadline.hasExpired()) {
+        // the cells which were cancelled or never asked
+        Q_FOREACH(int index, bulk->cells) {
+            const int row = index / subjects.size();
+            const int column = index % subjects.size();
+            if (bulk->matrix.result(row, column) == Unknown && !bulk->matrix.hasError(row, column)) {
+                bulk->matrix.setError(row, column, E_Timeout);
+            }
+        }
+    }
+
+    AuthorizationMatrix matrix = bulk->matrix;
+    delete bulk;
+    return matrix;
+}
+
+PendingAuthorizationMatrix *Authority::checkAuthorizations(const QStringList &actionIds, const QList<Subject> &subjects,
+                                                           AuthorizationFlags flags, QObject *parent)
 {
-    if (!g_cancellable_is_cancelled(d->m_checkAuthorizationCancellable)) {
-        g_cancellable_cancel(d->m_checkAuthorizationCancellable);
+    PendingAuthorizationMatrix *request = new PendingAuthorizationMatrix(d->nextRequestId(),
+                                                                        AuthorizationMatrix(actionIds, subjects),
+                                                                        parent);
+
+    BulkCheck *bulk = d->bulkCheckCreate(actionIds, subjects, flags, request->d->cancellable, true);
+    bulk->request = request;
+
+    if (bulk->cells.isEmpty()) {
+        // everything was answered from the cache, or nothing could be asked
+        bulk->matrix.setElapsed(bulk->timer.elapsed());
+        d->asyncCallFinished(bulk, bulkCheckOutcome(bulk));
+        request->d->finishLater(bulk->matrix);
+        delete bulk;
+        return request;
     }
+
+    d->bulkCheckFill(bulk);
+    return request;
+}
+
+AuthorizationWatch *Authority::watchAuthorizations(const QStringList &actionIds, const QList<Subject> &subjects,
+                                                   QObject *parent)
+{
+    return new AuthorizationWatch(this, actionIds, subjects, parent);
+}
+
+TemporaryAuthorizationWatch *Authority::watchTemporaryAuthorizations(const Subject &subject, QObject *parent)
+{
+    return new TemporaryAuthorizationWatch(this, subject, parent);
+}
+
+void Authority::checkAuthorizationCancel()
+{
+    d->resetCancellable(&d->m_checkAuthorizationCancellable);
 }
 
 ActionDescription::List Authority::enumerateActionsSync()
 {
+    Private::OperationTimer timer(d, AuthorityMetrics::EnumerateActionsSync);
     if (Authority::instance()->hasError()) {
+        timer.setFailed();
+        return ActionDescription::List();
+    }
+
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
         return ActionDescription::List();
     }
 
     GError *error = NULL;
 
-    GList *glist = polkit_authority_enumerate_actions_sync(d->pkAuthority,
-                   NULL,
+    Deadline deadline(d->defaultTimeout());
+    GList *glist = polkit_authority_enumerate_actions_sync(pkAuthority,
+                   deadline.cancellable(),
                    &error);
 
     if (error != NULL) {
-        d->setError(E_EnumFailed, error->message);
+        d->setError(E_EnumFailed, error, deadline);
         g_error_free(error);
         return ActionDescription::List();
     }
@@ -423,22 +2223,34 @@ void Authority::enumerateActions()
         return;
     }
 
-    polkit_authority_enumerate_actions(d->pkAuthority,
-                                       d->m_enumerateActionsCancellable,
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        Q_EMIT enumerateActionsFinished(ActionDescription::List());
+        return;
+    }
+
+    GCancellable *cancellable = d->refCancellable(&d->m_enumerateActionsCancellable);
+    polkit_authority_enumerate_actions(pkAuthority,
+                                       cancellable,
                                        d->enumerateActionsCallback,
-                                       Authority::instance());
+                                       d->asyncCall(AuthorityMetrics::EnumerateActions));
+    g_object_unref(cancellable);
 }
 
 void Authority::Private::enumerateActionsCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
+    QScopedPointer<AsyncCall> call((AsyncCall *) user_data);
+    Authority *authority = call->authority;
     Q_ASSERT(authority != NULL);
+    OperationTimer timer(call.data());
     GError *error = NULL;
     GList *list = polkit_authority_enumerate_actions_finish((PolkitAuthority *) object, result, &error);
     if (error != NULL) {
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
+        if (!isCancelledError(error)) {
             authority->d->setError(E_EnumFailed, error->message);
+        } else {
+            timer.setCancelled();
         }
         g_error_free(error);
         return;
@@ -449,14 +2261,78 @@ void Authority::Private::enumerateActionsCallback(GObject *object, GAsyncResult
 
 void Authority::enumerateActionsCancel()
 {
-    if (!g_cancellable_is_cancelled(d->m_enumerateActionsCancellable)) {
-        g_cancellable_cancel(d->m_enumerateActionsCancellable);
+    d->resetCancellable(&d->m_enumerateActionsCancellable);
+}
+
+PendingActions *Authority::enumerateActionsStreamed(int chunkSize, QObject *parent)
+{
+    PendingActions *request = new PendingActions(d->nextRequestId(), chunkSize, parent);
+
+    // errors belong to the request, not to the calling thread
+    const bool hadError = hasError();
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        request->d->failLater(E_GetAuthority, errorDetails());
+        if (!hadError) {
+            clearError();
+        }
+        return request;
+    }
+
+    ActionStream *stream = new ActionStream;
+    d->asyncCallStarted(stream, AuthorityMetrics::EnumerateActionsStreamed);
+    // the request owning the cancellable may be deleted before the reply is in
+    stream->cancellable = (GCancellable *) g_object_ref(request->d->cancellable);
+    stream->request = request;
+    polkit_authority_enumerate_actions(pkAuthority,
+                                       stream->cancellable,
+                                       d->enumerateActionsStreamedCallback,
+                                       stream);
+    return request;
+}
+
+void Authority::Private::enumerateActionsStreamedCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    QScopedPointer<ActionStream> stream((ActionStream *) user_data);
+    Authority *authority = stream->authority;
+    GError *error = NULL;
+    GList *list = polkit_authority_enumerate_actions_finish((PolkitAuthority *) object, result, &error);
+
+    if (error != NULL) {
+        const bool cancelled = isCancelledError(error);
+        authority->d->asyncCallFinished(stream.data(), cancelled ? AuthorityMetricsRecorder::Cancelled
+                                                                 : AuthorityMetricsRecorder::Failed);
+        if (stream->request) {
+            // a cancelled enumeration is not an error
+            stream->request->d->failLater(cancelled ? E_None : E_EnumFailed,
+                                          cancelled ? QString() : QString::fromUtf8(error->message));
+        }
+        g_error_free(error);
+        return;
+    }
+
+    authority->d->asyncCallFinished(stream.data(), AuthorityMetricsRecorder::Succeeded);
+    if (stream->request) {
+        // converted chunk by chunk in the thread of the request
+        stream->request->d->deliver(list);
+    } else {
+        for (GList *glist = list; glist != NULL; glist = g_list_next(glist)) {
+            g_object_unref(glist->data);
+        }
+        g_list_free(list);
     }
 }
 
+ActionCatalog *Authority::actionCatalog() const
+{
+    return d->m_actionCatalog;
+}
+
 bool Authority::registerAuthenticationAgentSync(const Subject &subject, const QString &locale, const QString &objectPath)
 {
+    Private::OperationTimer timer(d, AuthorityMetrics::RegisterAuthenticationAgentSync);
     if (Authority::instance()->hasError()) {
+        timer.setFailed();
         return false;
     }
 
@@ -468,12 +2344,18 @@ bool Authority::registerAuthenticationAgentSync(const Subject &subject, const QS
         return false;
     }
 
-    result = polkit_authority_register_authentication_agent_sync(d->pkAuthority,
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        return false;
+    }
+
+    Deadline deadline(d->defaultTimeout());
+    result = polkit_authority_register_authentication_agent_sync(pkAuthority,
              subject.subject(), locale.toLatin1().data(),
-             objectPath.toLatin1().data(), NULL, &error);
+             objectPath.toLatin1().data(), deadline.cancellable(), &error);
 
     if (error) {
-        d->setError(E_RegisterFailed, error->message);
+        d->setError(E_RegisterFailed, error, deadline);
         g_error_free(error);
         return false;
     }
@@ -492,25 +2374,37 @@ void Authority::registerAuthenticationAgent(const Subject &subject, const QStrin
         return;
     }
 
-    polkit_authority_register_authentication_agent(d->pkAuthority,
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        Q_EMIT registerAuthenticationAgentFinished(false);
+        return;
+    }
+
+    GCancellable *cancellable = d->refCancellable(&d->m_registerAuthenticationAgentCancellable);
+    polkit_authority_register_authentication_agent(pkAuthority,
             subject.subject(),
             locale.toLatin1().data(),
             objectPath.toLatin1().data(),
-            d->m_registerAuthenticationAgentCancellable,
+            cancellable,
             d->registerAuthenticationAgentCallback,
-            this);
+            d->asyncCall(AuthorityMetrics::RegisterAuthenticationAgent));
+    g_object_unref(cancellable);
 }
 
 void Authority::Private::registerAuthenticationAgentCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
+    QScopedPointer<AsyncCall> call((AsyncCall *) user_data);
+    Authority *authority = call->authority;
     Q_ASSERT(authority != NULL);
+    OperationTimer timer(call.data());
     GError *error = NULL;
     bool res = polkit_authority_register_authentication_agent_finish((PolkitAuthority *) object, result, &error);
     if (error != NULL) {
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
+        if (!isCancelledError(error)) {
             authority->d->setError(E_EnumFailed , error->message);
+        } else {
+            timer.setCancelled();
         }
         g_error_free(error);
         return;
@@ -521,14 +2415,14 @@ void Authority::Private::registerAuthenticationAgentCallback(GObject *object, GA
 
 void Authority::registerAuthenticationAgentCancel()
 {
-    if (!g_cancellable_is_cancelled(d->m_registerAuthenticationAgentCancellable)) {
-        g_cancellable_cancel(d->m_registerAuthenticationAgentCancellable);
-    }
+    d->resetCancellable(&d->m_registerAuthenticationAgentCancellable);
 }
 
 bool Authority::unregisterAuthenticationAgentSync(const Subject &subject, const QString &objectPath)
 {
-    if (d->pkAuthority) {
+    Private::OperationTimer timer(d, AuthorityMetrics::UnregisterAuthenticationAgentSync);
+    if (Authority::instance()->hasError()) {
+        timer.setFailed();
         return false;
     }
 
@@ -537,16 +2431,22 @@ bool Authority::unregisterAuthenticationAgentSync(const Subject &subject, const
         return false;
     }
 
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        return false;
+    }
+
     GError *error = NULL;
 
-    bool result = polkit_authority_unregister_authentication_agent_sync(d->pkAuthority,
+    Deadline deadline(d->defaultTimeout());
+    bool result = polkit_authority_unregister_authentication_agent_sync(pkAuthority,
                   subject.subject(),
                   objectPath.toUtf8().data(),
-                  NULL,
+                  deadline.cancellable(),
                   &error);
 
     if (error != NULL) {
-        d->setError(E_UnregisterFailed, error->message);
+        d->setError(E_UnregisterFailed, error, deadline);
         g_error_free(error);
         return false;
     }
@@ -565,24 +2465,36 @@ void Authority::unregisterAuthenticationAgent(const Subject &subject, const QStr
         return;
     }
 
-    polkit_authority_unregister_authentication_agent(d->pkAuthority,
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        Q_EMIT unregisterAuthenticationAgentFinished(false);
+        return;
+    }
+
+    GCancellable *cancellable = d->refCancellable(&d->m_unregisterAuthenticationAgentCancellable);
+    polkit_authority_unregister_authentication_agent(pkAuthority,
             subject.subject(),
             objectPath.toUtf8().data(),
-            d->m_unregisterAuthenticationAgentCancellable,
+            cancellable,
             d->unregisterAuthenticationAgentCallback,
-            this);
+            d->asyncCall(AuthorityMetrics::UnregisterAuthenticationAgent));
+    g_object_unref(cancellable);
 }
 
 void Authority::Private::unregisterAuthenticationAgentCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
-    Q_ASSERT(authority);
+    QScopedPointer<AsyncCall> call((AsyncCall *) user_data);
+    Authority *authority = call->authority;
+    Q_ASSERT(authority != NULL);
+    OperationTimer timer(call.data());
     GError *error = NULL;
     bool res = polkit_authority_unregister_authentication_agent_finish((PolkitAuthority *) object, result, &error);
     if (error != NULL) {
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
+        if (!isCancelledError(error)) {
             authority->d->setError(E_UnregisterFailed, error->message);
+        } else {
+            timer.setCancelled();
         }
         g_error_free(error);
         return;
@@ -593,14 +2505,14 @@ void Authority::Private::unregisterAuthenticationAgentCallback(GObject *object,
 
 void Authority::unregisterAuthenticationAgentCancel()
 {
-    if (!g_cancellable_is_cancelled(d->m_unregisterAuthenticationAgentCancellable)) {
-        g_cancellable_cancel(d->m_unregisterAuthenticationAgentCancellable);
-    }
+    d->resetCancellable(&d->m_unregisterAuthenticationAgentCancellable);
 }
 
 bool Authority::authenticationAgentResponseSync(const QString &cookie, const Identity &identity)
 {
+    Private::OperationTimer timer(d, AuthorityMetrics::AuthenticationAgentResponseSync);
     if (Authority::instance()->hasError()) {
+        timer.setFailed();
         return false;
     }
 
@@ -609,15 +2521,21 @@ bool Authority::authenticationAgentResponseSync(const QString &cookie, const Ide
         return false;
     }
 
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        return false;
+    }
+
     GError *error = NULL;
 
-    bool result = polkit_authority_authentication_agent_response_sync(d->pkAuthority,
+    Deadline deadline(d->defaultTimeout());
+    bool result = polkit_authority_authentication_agent_response_sync(pkAuthority,
                   cookie.toUtf8().data(),
                   identity.identity(),
-                  NULL,
+                  deadline.cancellable(),
                   &error);
     if (error != NULL) {
-        d->setError(E_AgentResponseFailed, error->message);
+        d->setError(E_AgentResponseFailed, error, deadline);
         g_error_free(error);
         return false;
     }
@@ -636,24 +2554,36 @@ void Authority::authenticationAgentResponse(const QString &cookie, const Identit
         return;
     }
 
-    polkit_authority_authentication_agent_response(d->pkAuthority,
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        Q_EMIT authenticationAgentResponseFinished(false);
+        return;
+    }
+
+    GCancellable *cancellable = d->refCancellable(&d->m_authenticationAgentResponseCancellable);
+    polkit_authority_authentication_agent_response(pkAuthority,
             cookie.toUtf8().data(),
             identity.identity(),
-            d->m_authenticationAgentResponseCancellable,
+            cancellable,
             d->authenticationAgentResponseCallback,
-            this);
+            d->asyncCall(AuthorityMetrics::AuthenticationAgentResponse));
+    g_object_unref(cancellable);
 }
 
 void Authority::Private::authenticationAgentResponseCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
-    Q_ASSERT(authority);
+    QScopedPointer<AsyncCall> call((AsyncCall *) user_data);
+    Authority *authority = call->authority;
+    Q_ASSERT(authority != NULL);
+    OperationTimer timer(call.data());
     GError *error = NULL;
     bool res = polkit_authority_authentication_agent_response_finish((PolkitAuthority *) object, result, &error);
     if (error != NULL) {
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
+        if (!isCancelledError(error)) {
             authority->d->setError(E_AgentResponseFailed, error->message);
+        } else {
+            timer.setCancelled();
         }
         g_error_free(error);
         return;
@@ -664,22 +2594,27 @@ void Authority::Private::authenticationAgentResponseCallback(GObject *object, GA
 
 void Authority::authenticationAgentResponseCancel()
 {
-    if (!g_cancellable_is_cancelled(d->m_authenticationAgentResponseCancellable)) {
-        g_cancellable_cancel(d->m_authenticationAgentResponseCancellable);
-    }
+    d->resetCancellable(&d->m_authenticationAgentResponseCancellable);
 }
 
 TemporaryAuthorization::List Authority::enumerateTemporaryAuthorizationsSync(const Subject &subject)
 {
+    Private::OperationTimer timer(d, AuthorityMetrics::EnumerateTemporaryAuthorizationsSync);
     TemporaryAuthorization::List result;
 
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        return result;
+    }
+
     GError *error = NULL;
-    GList *glist = polkit_authority_enumerate_temporary_authorizations_sync(d->pkAuthority,
+    Deadline deadline(d->defaultTimeout());
+    GList *glist = polkit_authority_enumerate_temporary_authorizations_sync(pkAuthority,
                    subject.subject(),
-                   NULL,
+                   deadline.cancellable(),
                    &error);
     if (error != NULL) {
-        d->setError(E_EnumFailed, error->message);
+        d->setError(E_EnumFailed, error, deadline);
         g_error_free(error);
         return result;
     }
@@ -697,16 +2632,20 @@ TemporaryAuthorization::List Authority::enumerateTemporaryAuthorizationsSync(con
 
 void Authority::Private::enumerateTemporaryAuthorizationsCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
-    Q_ASSERT(authority);
+    QScopedPointer<AsyncCall> call((AsyncCall *) user_data);
+    Authority *authority = call->authority;
+    Q_ASSERT(authority != NULL);
+    OperationTimer timer(call.data());
     GError *error = NULL;
 
     GList *glist = polkit_authority_enumerate_temporary_authorizations_finish((PolkitAuthority *) object, result, &error);
 
     if (error != NULL) {
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
+        if (!isCancelledError(error)) {
             authority->d->setError(E_EnumFailed, error->message);
+        } else {
+            timer.setCancelled();
         }
         g_error_free(error);
         return;
@@ -725,28 +2664,36 @@ void Authority::Private::enumerateTemporaryAuthorizationsCallback(GObject *objec
 
 void Authority::enumerateTemporaryAuthorizationsCancel()
 {
-    if (!g_cancellable_is_cancelled(d->m_enumerateTemporaryAuthorizationsCancellable)) {
-        g_cancellable_cancel(d->m_enumerateTemporaryAuthorizationsCancellable);
-    }
+    d->resetCancellable(&d->m_enumerateTemporaryAuthorizationsCancellable);
 }
 
 bool Authority::revokeTemporaryAuthorizationsSync(const Subject &subject)
 {
+    Private::OperationTimer timer(d, AuthorityMetrics::RevokeTemporaryAuthorizationsSync);
     bool result;
     if (Authority::instance()->hasError()) {
+        timer.setFailed();
+        return false;
+    }
+
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
         return false;
     }
 
     GError *error = NULL;
-    result = polkit_authority_revoke_temporary_authorizations_sync(d->pkAuthority,
+    Deadline deadline(d->defaultTimeout());
+    result = polkit_authority_revoke_temporary_authorizations_sync(pkAuthority,
              subject.subject(),
-             NULL,
+             deadline.cancellable(),
              &error);
     if (error != NULL) {
-        d->setError(E_RevokeFailed, error->message);
+        d->setError(E_RevokeFailed, error, deadline);
         g_error_free(error);
         return false;
     }
+    clearCache();
+    d->temporaryAuthorizationsRevoked();
     return result;
 }
 
@@ -756,57 +2703,79 @@ void Authority::revokeTemporaryAuthorizations(const Subject &subject)
         return;
     }
 
-    polkit_authority_revoke_temporary_authorizations(d->pkAuthority,
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        Q_EMIT revokeTemporaryAuthorizationsFinished(false);
+        return;
+    }
+
+    GCancellable *cancellable = d->refCancellable(&d->m_revokeTemporaryAuthorizationsCancellable);
+    polkit_authority_revoke_temporary_authorizations(pkAuthority,
             subject.subject(),
-            d->m_revokeTemporaryAuthorizationsCancellable,
+            cancellable,
             d->revokeTemporaryAuthorizationsCallback,
-            this);
+            d->asyncCall(AuthorityMetrics::RevokeTemporaryAuthorizations));
+    g_object_unref(cancellable);
 }
 
 void Authority::Private::revokeTemporaryAuthorizationsCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
+    QScopedPointer<AsyncCall> call((AsyncCall *) user_data);
+    Authority *authority = call->authority;
     Q_ASSERT(authority != NULL);
+    OperationTimer timer(call.data());
     GError *error = NULL;
 
     bool res = polkit_authority_revoke_temporary_authorizations_finish((PolkitAuthority *) object, result, &error);
 
     if (error != NULL) {
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
+        if (!isCancelledError(error)) {
             authority->d->setError(E_RevokeFailed, error->message);
+        } else {
+            timer.setCancelled();
         }
         g_error_free(error);
         return;
     }
 
+    authority->clearCache();
+    authority->d->temporaryAuthorizationsRevoked();
     Q_EMIT authority->revokeTemporaryAuthorizationsFinished(res);
 }
 
 void Authority::revokeTemporaryAuthorizationsCancel()
 {
-    if (!g_cancellable_is_cancelled(d->m_revokeTemporaryAuthorizationsCancellable)) {
-        g_cancellable_cancel(d->m_revokeTemporaryAuthorizationsCancellable);
-    }
+    d->resetCancellable(&d->m_revokeTemporaryAuthorizationsCancellable);
 }
 
 bool Authority::revokeTemporaryAuthorizationSync(const QString &id)
 {
+    Private::OperationTimer timer(d, AuthorityMetrics::RevokeTemporaryAuthorizationSync);
     bool result;
     if (Authority::instance()->hasError()) {
+        timer.setFailed();
+        return false;
+    }
+
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
         return false;
     }
 
     GError *error = NULL;
-    result =  polkit_authority_revoke_temporary_authorization_by_id_sync(d->pkAuthority,
+    Deadline deadline(d->defaultTimeout());
+    result =  polkit_authority_revoke_temporary_authorization_by_id_sync(pkAuthority,
               id.toUtf8().data(),
-              NULL,
+              deadline.cancellable(),
               &error);
     if (error != NULL) {
-        d->setError(E_RevokeFailed, error->message);
+        d->setError(E_RevokeFailed, error, deadline);
         g_error_free(error);
         return false;
     }
+    clearCache();
+    d->temporaryAuthorizationsRevoked();
     return result;
 }
 
@@ -816,38 +2785,199 @@ void Authority::revokeTemporaryAuthorization(const QString &id)
         return;
     }
 
-    polkit_authority_revoke_temporary_authorization_by_id(d->pkAuthority,
+    PolkitAuthority *pkAuthority = d->polkitAuthority();
+    if (pkAuthority == NULL) {
+        Q_EMIT revokeTemporaryAuthorizationFinished(false);
+        return;
+    }
+
+    GCancellable *cancellable = d->refCancellable(&d->m_revokeTemporaryAuthorizationCancellable);
+    polkit_authority_revoke_temporary_authorization_by_id(pkAuthority,
             id.toUtf8().data(),
-            d->m_revokeTemporaryAuthorizationCancellable,
+            cancellable,
             d->revokeTemporaryAuthorizationCallback,
-            this);
+            d->asyncCall(AuthorityMetrics::RevokeTemporaryAuthorization));
+    g_object_unref(cancellable);
 }
 
 void Authority::Private::revokeTemporaryAuthorizationCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
+    QScopedPointer<AsyncCall> call((AsyncCall *) user_data);
+    Authority *authority = call->authority;
     Q_ASSERT(authority != NULL);
+    OperationTimer timer(call.data());
     GError *error = NULL;
 
     bool res = polkit_authority_revoke_temporary_authorization_by_id_finish((PolkitAuthority *) object, result, &error);
 
     if (error != NULL) {
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
+        if (!isCancelledError(error)) {
             authority->d->setError(E_RevokeFailed, error->message);
+        } else {
+            timer.setCancelled();
         }
         g_error_free(error);
         return;
     }
 
+    authority->clearCache();
+    authority->d->temporaryAuthorizationsRevoked();
     Q_EMIT authority->revokeTemporaryAuthorizationFinished(res);
 }
 
 void Authority::revokeTemporaryAuthorizationCancel()
 {
-    if (!g_cancellable_is_cancelled(d->m_revokeTemporaryAuthorizationCancellable)) {
-        g_cancellable_cancel(d->m_revokeTemporaryAuthorizationCancellable);
+    d->resetCancellable(&d->m_revokeTemporaryAuthorizationCancellable);
+}
+
+PendingRevocation *Authority::revokeTemporaryAuthorizationsById(const QStringList &ids, QObject *parent)
+{
+    return d->bulkRevoke(ids, QList<Subject>(), parent);
+}
+
+PendingRevocation *Authority::revokeTemporaryAuthorizations(const QList<Subject> &subjects, QObject *parent)
+{
+    return d->bulkRevoke(QStringList(), subjects, parent);
+}
+
+PendingRevocation *Authority::Private::bulkRevoke(const QStringList &ids, const QList<Subject> &subjects,
+                                                  QObject *parent)
+{
+    PendingRevocation *request = new PendingRevocation(nextRequestId(), ids, subjects, parent);
+
+    BulkRevoke *bulk = new BulkRevoke;
+    asyncCallStarted(bulk, AuthorityMetrics::RevokeTemporaryAuthorizationsBulk);
+    bulk->ids = ids;
+    bulk->subjects = subjects;
+    bulk->results.resize(ids.size() + subjects.size());
+    bulk->next = 0;
+    bulk->inFlight = 0;
+    // the request owning the cancellable may be deleted before all the replies are in
+    bulk->cancellable = (GCancellable *) g_object_ref(request->d->cancellable);
+    bulk->request = request;
+    bulk->starting = true;
+
+    // errors belong to the request, not to the calling thread
+    const bool hadError = q->hasError();
+    bulk->pkAuthority = polkitAuthority();
+    if (bulk->pkAuthority == NULL) {
+        const QString details = q->errorDetails();
+        if (!hadError) {
+            q->clearError();
+        }
+        for (int i = 0; i < bulk->results.size(); ++i) {
+            bulk->results[i].error = E_GetAuthority;
+            bulk->results[i].errorDetails = details;
+        }
+        bulkRevokeFinish(bulk);
+        return request;
+    }
+
+    bulkRevokeFill(bulk);
+    return request;
+}
+
+void Authority::Private::bulkRevokeFill(BulkRevoke *bulk)
+{
+    m_mutex.lock();
+    const int window = m_bulkCheckWindow;
+    m_mutex.unlock();
+
+    while (bulk->inFlight < window && bulk->next < bulk->results.size()
+            && !g_cancellable_is_cancelled(bulk->cancellable)) {
+        const int index = bulk->next++;
+        if (bulk->ids.isEmpty() && !bulk->subjects.at(index).isValid()) {
+            bulk->results[index].error = E_WrongSubject;
+            continue;
+        }
+
+        BulkRevokeItem *item = new BulkRevokeItem;
+        item->bulk = bulk;
+        item->index = index;
+        ++bulk->inFlight;
+        if (!bulk->ids.isEmpty()) {
+            polkit_authority_revoke_temporary_authorization_by_id(bulk->pkAuthority,
+                    bulk->ids.at(index).toUtf8().data(),
+                    bulk->cancellable,
+                    bulkRevokeCallback,
+                    item);
+        } else {
+            polkit_authority_revoke_temporary_authorizations(bulk->pkAuthority,
+                    bulk->subjects.at(index).subject(),
+                    bulk->cancellable,
+                    bulkRevokeCallback,
+                    item);
+        }
+    }
+
+    if (bulk->inFlight == 0) {
+        bulkRevokeFinish(bulk);
+    } else {
+        bulk->starting = false;
+    }
+}
+
+void Authority::Private::bulkRevokeFinish(BulkRevoke *bulk)
+{
+    bool revoked = false;
+    bool failed = false;
+    Q_FOREACH(const RevocationResult &result, bulk->results) {
+        revoked = revoked || result.revoked;
+        failed = failed || result.error != E_None;
+    }
+
+    if (g_cancellable_is_cancelled(bulk->cancellable)) {
+        asyncCallFinished(bulk, AuthorityMetricsRecorder::Cancelled);
+    } else {
+        asyncCallFinished(bulk, failed ? AuthorityMetricsRecorder::Failed : AuthorityMetricsRecorder::Succeeded);
+    }
+
+    if (revoked) {
+        cacheClear();
+        temporaryAuthorizationsRevoked();
+    }
+
+    if (bulk->request) {
+        if (bulk->starting) {
+            // nothing was sent, the caller did not get the request yet
+            bulk->request->d->finishLater(bulk->results);
+        } else {
+            bulk->request->d->finish(bulk->results);
+        }
+    }
+    delete bulk;
+}
+
+void Authority::Private::bulkRevokeCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    BulkRevokeItem *item = (BulkRevokeItem *) user_data;
+    BulkRevoke *bulk = item->bulk;
+    Authority *authority = bulk->authority;
+    RevocationResult &res = bulk->results[item->index];
+
+    GError *error = NULL;
+    bool revoked;
+    if (!bulk->ids.isEmpty()) {
+        revoked = polkit_authority_revoke_temporary_authorization_by_id_finish((PolkitAuthority *) object, result, &error);
+    } else {
+        revoked = polkit_authority_revoke_temporary_authorizations_finish((PolkitAuthority *) object, result, &error);
+    }
+
+    if (error != NULL) {
+        // cancelled items are simply not revoked
+        if (!isCancelledError(error)) {
+            res.error = E_RevokeFailed;
+            res.errorDetails = QString::fromUtf8(error->message);
+        }
+        g_error_free(error);
+    } else {
+        res.revoked = revoked;
     }
+
+    delete item;
+    --bulk->inFlight;
+    authority->d->bulkRevokeFill(bulk);
 }
 
 }
@@ -30,6 +30,7 @@
 #include "polkitqt1-temporaryauthorization.h"
 #include "polkitqt1-actiondescription.h"
 
+#include <QtCore/QList>
 #include <QtCore/QObject>
 #include <QtCore/QMetaType>
 #include <QtDBus/QDBusMessage>
@@ -47,6 +48,17 @@ class QStringList;
 namespace PolkitQt1
 {
 
+class ActionCatalog;
+class AuthorityMetrics;
+class AuthorizationMatrix;
+class AuthorizationWatch;
+class TemporaryAuthorizationWatch;
+class FakeAuthorityBackend;
+class PendingAuthorization;
+class PendingAuthorizationMatrix;
+class PendingRevocation;
+class PendingActions;
+
 /**
  * \class Authority polkitqt1-authority.h Authority
  * \author Daniel Nicoletti <dantti85-pk@yahoo.com.br>
@@ -63,6 +75,19 @@ namespace PolkitQt1
  * \note This class is a singleton, its constructor is private.
  * Call Authority::instance() to get an instance of the Authority object.
  * Do not delete Authority::instance(), cleanup will be done automatically.
+ *
+ * \note Authority can be used from any thread. The error state returned by
+ * hasError(), lastError() and errorDetails() is kept separately for every
+ * thread. Asynchronous operations complete in the thread which started them,
+ * provided that thread runs an event loop: PendingAuthorization and
+ * PendingAuthorizationMatrix handles emit their signals there, while the
+ * signals of Authority itself are delivered according to the usual rules
+ * for cross-thread connections.
+ *
+ * \note Authorization checks can be sent to polkitd directly over QtDBus
+ * instead of through libpolkit-gobject-1, either by building with
+ * USE_QTDBUS_BACKEND or by setting POLKIT_QT_1_BACKEND=qtdbus in the
+ * environment (POLKIT_QT_1_BACKEND=polkit selects libpolkit-gobject-1).
  */
 class POLKITQT1_EXPORT Authority : public QObject
 {
@@ -117,7 +142,9 @@ public:
         /** Response of auth agent failed **/
         E_AgentResponseFailed = 0x09,
         /** Revoke temporary authorizations failed **/
-        E_RevokeFailed = 0x0A
+        E_RevokeFailed = 0x0A,
+        /** The authority did not answer before the timeout **/
+        E_Timeout = 0x0B
     };
 
     /**
@@ -139,12 +166,60 @@ public:
      */
     static Authority *instance(PolkitAuthority *authority = 0);
 
+    /**
+     * Makes instance() return right away and connect to the authority in the
+     * background, instead of blocking until polkitd answers. ready() is emitted
+     * once the authority can be used.
+     *
+     * Authorization checks started before that are queued and sent once the
+     * authority is ready, while synchronous calls wait for it.
+     *
+     * \note This has to be called before the first call to instance(), from the
+     * thread the application runs its event loop in.
+     *
+     * \param enabled \c true to initialize the authority asynchronously
+     */
+    static void setAsynchronousInitialization(bool enabled);
+
+    /**
+     * Makes the authority answer every authorization check from \p backend,
+     * in process, instead of asking polkitd. Neither polkitd nor ConsoleKit
+     * are contacted at all: configuration and session changes come from
+     * \p backend too. Pass \c 0 to talk to polkitd again.
+     *
+     * This is meant for tests and benchmarks of the code built on Authority.
+     *
+     * \note This has to be called before the first call to instance(). \p backend
+     * has to outlive the authority.
+     *
+     * \see FakeAuthorityBackend
+     *
+     * \param backend the fake polkitd to use
+     */
+    static void setFakeBackend(FakeAuthorityBackend *backend);
+
     ~Authority();
 
+    /**
+     * \return \c true once the authority has been initialized, successfully or not
+     *
+     * \see ready()
+     */
+    bool isReady() const;
+
     /**
      * You should always call this method after every action. No action will be allowed
      * if the object is in error state. Use clearError() to clear the error message.
      *
+     * The error state is per thread: an error raised in a worker thread does not
+     * affect calls made from other threads.
+     *
+     * When polkitd leaves the system bus, for instance while it is upgraded,
+     * the authority reconnects to it as soon as it is back, and the checks
+     * asked for in the meantime wait for it for a few seconds. The errors
+     * reported by the authority before it came back are cleared then, only
+     * the ones caused by the arguments of a call stay until clearError().
+     *
      * \see lastError
      * \see clearError
      *
@@ -169,6 +244,138 @@ public:
      */
     void clearError();
 
+    /**
+     * Enables or disables caching of authorization results.
+     *
+     * When caching is enabled, the results of checkAuthorization() and
+     * checkAuthorizationSync() are remembered for each combination of action id,
+     * subject and flags, and an identical check is answered without a round trip
+     * to the authority. Only \c Yes, \c No and \c Challenge results are cached.
+     *
+     * The cache is flushed whenever the polkit configuration changes or ConsoleKit
+     * reports a seat or session change. Results cached for a SystemBusNameSubject
+     * are dropped as soon as the owner of that bus name changes.
+     *
+     * Checks using \c AllowUserInteraction always go to the authority, and they
+     * invalidate the cached results for the same action and subject, since the user
+     * may have obtained a temporary authorization in the meantime.
+     *
+     * A \c Yes granted by a temporary authorization is only cached once the
+     * expiry of that authorization is known, and it is dropped as soon as the
+     * authorization expires. This includes the authorization obtained by an
+     * interactive check, which then answers the non-interactive checks for the same
+     * action and subject. Since polkitd only lists the temporary authorizations of
+     * the caller's own session, such results are not cached in processes which do
+     * not run in a session.
+     *
+     * Caching is disabled by default.
+     *
+     * \param enabled \c true to enable the cache, \c false to disable and flush it
+     */
+    void setCachingEnabled(bool enabled);
+
+    /**
+     * \return \c true if authorization results are being cached
+     *
+     * \see setCachingEnabled
+     */
+    bool isCachingEnabled() const;
+
+    /**
+     * Drops every cached authorization result.
+     */
+    void clearCache();
+
+    /**
+     * \return the number of authorization checks answered from the cache
+     */
+    quint64 cacheHits() const;
+
+    /**
+     * \return the number of cacheable authorization checks which had to be
+     *         forwarded to the authority
+     */
+    quint64 cacheMisses() const;
+
+    /**
+     * Enables or disables the coalescing of identical concurrent checks.
+     *
+     * When a check is started while an identical one, with the same action id,
+     * subject and flags, is still waiting for the authority, no new request is
+     * sent: the new caller waits for the running one and gets the same result.
+     * Nothing is remembered once the check completes, so unlike the cache this
+     * never returns a stale result.
+     *
+     * Cancelling one of the callers only cancels that caller; the request sent
+     * to the authority is cancelled once all of them gave up. Checks using
+     * \c AllowUserInteraction are never coalesced, and synchronous checks never
+     * wait for a request started by somebody else, although other checks may
+     * wait for theirs.
+     *
+     * Coalescing is enabled by default.
+     *
+     * \param enabled \c true to coalesce identical concurrent checks
+     */
+    void setCheckCoalescingEnabled(bool enabled);
+
+    /**
+     * \return \c true if identical concurrent checks are coalesced
+     *
+     * \see setCheckCoalescingEnabled
+     */
+    bool isCheckCoalescingEnabled() const;
+
+    /**
+     * \return the number of checks which waited for an identical running check
+     *         instead of asking the authority
+     */
+    quint64 coalescedChecks() const;
+
+    /**
+     * Sets how many checks using \c AllowUserInteraction may wait for the
+     * authority at the same time. The checks over the limit are queued, and
+     * sent in order as the running ones complete.
+     *
+     * Interactive checks last as long as the user takes to authenticate, so
+     * they are scheduled apart from the other checks: a dialog left open does
+     * not delay the background checks, which have their own limit. Synchronous
+     * checks are never queued, but they count against the limit.
+     *
+     * The default is 4.
+     *
+     * \param limit the number of interactive checks in flight, at least 1
+     *
+     * \see AuthorityMetrics::queueDepth
+     */
+    void setInteractiveCheckLimit(int limit);
+
+    /**
+     * \return the number of interactive checks which may be in flight at the same time
+     *
+     * \see setInteractiveCheckLimit
+     */
+    int interactiveCheckLimit() const;
+
+    /**
+     * Sets how many checks without \c AllowUserInteraction may wait for the
+     * authority at the same time. The checks over the limit are queued, and
+     * sent in order as the running ones complete.
+     *
+     * The default is 64.
+     *
+     * \param limit the number of background checks in flight, at least 1
+     *
+     * \see setInteractiveCheckLimit
+     */
+    void setBackgroundCheckLimit(int limit);
+
+    /**
+     * \return the number of background checks which may be in flight at the same time
+     *
+     * \see setBackgroundCheckLimit
+     */
+    int backgroundCheckLimit() const;
+
     /**
      * Returns the current instance of PolkitAuthority. If you are handling
      * it through Polkit-qt (which is quite likely, since you are calling
@@ -176,6 +383,8 @@ public:
      * modifies the instance on it, unless you're completely aware of what you're doing and
      * of the possible consequencies. Use this instance only to gather information.
      *
+     * With the QtDBus backend the instance is created by the first call.
+     *
      * \return the current PolkitAuthority instance
      */
     PolkitAuthority *polkitAuthority() const;
@@ -223,11 +432,192 @@ public:
     Result checkAuthorizationSync(const QString &actionId, const Subject &subject,
                                   AuthorizationFlags flags);
 
+    /**
+     * Synchronous version of the checkAuthorization method, which gives up
+     * after \p timeout milliseconds.
+     *
+     * When the authority does not answer in time, the request is cancelled,
+     * \c Unknown is returned and lastError() is \c E_Timeout.
+     *
+     * \param actionId the Id of the action in question
+     * \param subject subject that the action is authorized for (e.g. unix process)
+     * \param flags flags that influences the authorization checking
+     * \param timeout the time limit in milliseconds, or -1 to wait as long as needed
+     *
+     * \see setDefaultTimeout
+     */
+    Result checkAuthorizationSync(const QString &actionId, const Subject &subject,
+                                  AuthorizationFlags flags, int timeout);
+
+    /**
+     * Sets the time limit of the synchronous methods which are not given one,
+     * like checkAuthorizationSync() or enumerateActionsSync(). The operations
+     * still running when it expires are cancelled and fail with \c E_Timeout.
+     *
+     * The default of -1 waits as long as the authority needs.
+     *
+     * \note Interactive checks last as long as the user takes to authenticate,
+     * so they are bounded by the timeout as well.
+     *
+     * \param msec the time limit in milliseconds, or -1 for none
+     */
+    void setDefaultTimeout(int msec);
+
+    /**
+     * \return the time limit of the synchronous methods, in milliseconds, or -1 for none
+     *
+     * \see setDefaultTimeout
+     */
+    int defaultTimeout() const;
+
     /**
      * This method can be used to cancel last authorization check.
+     *
+     * \note This cancels every check started with checkAuthorization() which has
+     *       not finished yet. Use checkAuthorizationAsync() and
+     *       PendingAuthorization::cancel() to cancel a single check.
      */
     void checkAuthorizationCancel();
 
+    /**
+     * Asynchronously checks whether \p subject is authorized for \p actionId and
+     * returns a handle to the running check.
+     *
+     * Unlike checkAuthorization(), every call gets its own PendingAuthorization
+     * carrying its own cancellable, result, error and timing. Any number of checks
+     * can be in flight at the same time, and cancelling one of them does not affect
+     * the others. Errors are reported on the handle only and never put the
+     * Authority in error state.
+     *
+     * \see PendingAuthorization
+     *
+     * \param actionId the Id of the action in question
+     * \param subject subject that the action is authorized for (e.g. unix process)
+     * \param flags flags that influences the authorization checking
+     * \param parent the parent of the returned object
+     *
+     * \return a new PendingAuthorization which is owned by the caller
+     */
+    PendingAuthorization *checkAuthorizationAsync(const QString &actionId, const Subject &subject,
+                                                  AuthorizationFlags flags, QObject *parent = 0);
+
+    /**
+     * Checks every action in \p actionIds for every subject in \p subjects and
+     * blocks until all the results are known.
+     *
+     * The individual checks are pipelined: up to bulkCheckWindow() of them are sent
+     * to the authority at the same time, so the whole matrix costs roughly one round
+     * trip plus the processing time of the authority instead of one round trip per
+     * cell. Results already in the cache (see setCachingEnabled()) are not asked again.
+     *
+     * Failures are reported per cell in the returned matrix and never put the
+     * Authority in error state.
+     *
+     * \see checkAuthorizations Asynchronous version of this method.
+     *
+     * \param actionIds the Ids of the actions in question, i.e. the rows of the matrix
+     * \param subjects the subjects to check the actions for, i.e. the columns of the matrix
+     * \param flags flags that influences the authorization checking
+     *
+     * \return the results of all the checks
+     */
+    AuthorizationMatrix checkAuthorizationsSync(const QStringList &actionIds, const QList<Subject> &subjects,
+                                                AuthorizationFlags flags);
+
+    /**
+     * Same as the method above, but gives up after \p timeout milliseconds:
+     * the cells which are not known by then carry \c E_Timeout.
+     *
+     * \param actionIds the Ids of the actions in question, i.e. the rows of the matrix
+     * \param subjects the subjects to check the actions for, i.e. the columns of the matrix
+     * \param flags flags that influences the authorization checking
+     * \param timeout the time limit in milliseconds, or -1 to wait as long as needed
+     *
+     * \return the results of all the checks
+     */
+    AuthorizationMatrix checkAuthorizationsSync(const QStringList &actionIds, const QList<Subject> &subjects,
+                                                AuthorizationFlags flags, int timeout);
+
+    /**
+     * Asynchronous version of checkAuthorizationsSync().
+     *
+     * \param actionIds the Ids of the actions in question, i.e. the rows of the matrix
+     * \param subjects the subjects to check the actions for, i.e. the columns of the matrix
+     * \param flags flags that influences the authorization checking
+     * \param parent the parent of the returned object
+     *
+     * \return a new PendingAuthorizationMatrix which is owned by the caller
+     */
+    PendingAuthorizationMatrix *checkAuthorizations(const QStringList &actionIds, const QList<Subject> &subjects,
+                                                    AuthorizationFlags flags, QObject *parent = 0);
+
+    /**
+     * Watches the results of every action in \p actionIds for every subject
+     * in \p subjects. They are checked right away, and checked again in one
+     * batch whenever changed() is emitted; the returned watch only reports the
+     * results which actually changed.
+     *
+     * The checks never allow user interaction.
+     *
+     * \param actionIds the Ids of the actions to watch, i.e. the rows of the matrix
+     * \param subjects the subjects to watch the actions for, i.e. the columns of the matrix
+     * \param parent the parent of the returned object
+     *
+     * \return a new AuthorizationWatch which is owned by the caller
+     */
+    AuthorizationWatch *watchAuthorizations(const QStringList &actionIds, const QList<Subject> &subjects,
+                                            QObject *parent = 0);
+
+    /**
+     * Sets how many checks of a bulk check may be waiting for the authority at the
+     * same time. The default is 32. Bulk revocations use the same window.
+     *
+     * \param window the maximum number of checks in flight per bulk check, at least 1
+     */
+    void setBulkCheckWindow(int window);
+
+    /**
+     * \return the maximum number of checks in flight per bulk check
+     */
+    int bulkCheckWindow() const;
+
+    /**
+     * Sets how long change notifications are collected before changed() is
+     * emitted. All the configChanged() and consoleKitDBChanged() notifications
+     * arriving within \p msec of the first one result in a single changed()
+     * signal. The default is 100 milliseconds.
+     *
+     * \param msec the coalescing window in milliseconds, 0 to only coalesce the
+     *             notifications handled in the same event loop iteration
+     */
+    void setChangeCoalescingWindow(int msec);
+
+    /**
+     * \return the coalescing window of changed(), in milliseconds
+     */
+    int changeCoalescingWindow() const;
+
+    /**
+     * \return the generation of the last changed() signal, 0 if it was never emitted
+     */
+    quint64 changeGeneration() const;
+
+    /**
+     * Returns a snapshot of the statistics kept about every operation of
+     * Authority: number of calls, errors and cancellations, and latencies.
+     * Recording them is cheap and always enabled.
+     *
+     * \see AuthorityMetrics::toPrometheusText()
+     *
+     * \return the metrics collected since the start or the last resetMetrics()
+     */
+    AuthorityMetrics metrics() const;
+
+    /**
+     * Sets every counter and histogram of the metrics back to zero.
+     */
+    void resetMetrics();
+
     /**
      * Asynchronously retrieves all registered actions.
      *
@@ -254,6 +644,33 @@ public:
      */
     void enumerateActionsCancel();
 
+    /**
+     * Asynchronously retrieves all registered actions, like enumerateActions(),
+     * but delivers them through the returned handle in chunks of at most
+     * \p chunkSize actions, one chunk per iteration of the event loop, instead
+     * of converting and emitting the whole list at once.
+     *
+     * Errors are reported by the handle, and never put the Authority in error state.
+     *
+     * \param chunkSize the maximum number of actions delivered at a time
+     * \param parent the parent of the returned object
+     *
+     * \return a new PendingActions which is owned by the caller
+     */
+    PendingActions *enumerateActionsStreamed(int chunkSize = 64, QObject *parent = 0);
+
+    /**
+     * Returns the catalog of the registered actions, which answers lookups by
+     * action id, prefix, vendor and implicit authorizations from an index
+     * instead of enumerating the actions every time.
+     *
+     * The catalog enumerates the actions on the first lookup, and again only
+     * when configChanged() is emitted.
+     *
+     * \return the catalog, which is owned by the Authority
+     */
+    ActionCatalog *actionCatalog() const;
+
     /**
      * Registers an authentication agent.
      *
@@ -376,6 +793,19 @@ public:
     */
     TemporaryAuthorization::List enumerateTemporaryAuthorizationsSync(const Subject &subject);
 
+    /**
+     * Watches the temporary authorizations that apply to \p subject. They are
+     * listed right away, and listed again whenever changed() or
+     * temporaryAuthorizationsChanged() is emitted; the returned watch reports
+     * the authorizations added and removed, and drops each one when it expires.
+     *
+     * \param subject the subject to watch temporary authorizations for
+     * \param parent the parent of the returned object
+     *
+     * \return a new TemporaryAuthorizationWatch which is owned by the caller
+     */
+    TemporaryAuthorizationWatch *watchTemporaryAuthorizations(const Subject &subject, QObject *parent = 0);
+
     /**
      * This method can be used to cancel the enumerateTemporaryAuthorizationsAsync method.
      */
@@ -437,7 +867,42 @@ public:
      */
     void revokeTemporaryAuthorizationCancel();
 
+    /**
+     * Revokes every temporary authorization in \p ids, sending up to
+     * bulkCheckWindow() calls to the authority at the same time instead of one
+     * after the other.
+     *
+     * Every id gets its own result on the returned handle, and errors never put
+     * the Authority in error state.
+     *
+     * \param ids the identifiers of the temporary authorizations
+     * \param parent the parent of the returned object
+     *
+     * \return a new PendingRevocation which is owned by the caller
+     */
+    PendingRevocation *revokeTemporaryAuthorizationsById(const QStringList &ids, QObject *parent = 0);
+
+    /**
+     * Revokes all the temporary authorizations of every subject in \p subjects,
+     * like revokeTemporaryAuthorizationsById() does for ids.
+     *
+     * \param subjects the subjects to revoke temporary authorizations from
+     * \param parent the parent of the returned object
+     *
+     * \return a new PendingRevocation which is owned by the caller
+     */
+    PendingRevocation *revokeTemporaryAuthorizations(const QList<Subject> &subjects, QObject *parent = 0);
+
 Q_SIGNALS:
+    /**
+     * This signal is emitted once the asynchronous initialization requested with
+     * setAsynchronousInitialization() is over. Check hasError() to know whether
+     * the authority could be reached.
+     *
+     * It is not emitted if isReady() already returned \c true.
+     */
+    void ready();
+
     /**
      * This signal will be emitted when a configuration
      * file gets changed (e.g. /etc/PolicyKit/PolicyKit.conf or
@@ -458,9 +923,74 @@ Q_SIGNALS:
      *
      * \note If you use Action you'll probably prefer to
      * use the dataChanged() signal to track Action changes.
+     *
+     * \note It is emitted along with the more specific seatAdded(), seatRemoved(),
+     * sessionAdded(), sessionRemoved() and activeSessionChanged() signals.
      */
     void consoleKitDBChanged();
 
+    /**
+     * This signal is emitted when ConsoleKit reports a new seat.
+     *
+     * \param seat the object path of the seat
+     */
+    void seatAdded(const QString &seat);
+
+    /**
+     * This signal is emitted when ConsoleKit reports that a seat went away.
+     *
+     * \param seat the object path of the seat
+     */
+    void seatRemoved(const QString &seat);
+
+    /**
+     * This signal is emitted when a session is opened on \p seat.
+     *
+     * \param seat the object path of the seat
+     * \param session the object path of the session
+     */
+    void sessionAdded(const QString &seat, const QString &session);
+
+    /**
+     * This signal is emitted when a session on \p seat is closed.
+     *
+     * \param seat the object path of the seat
+     * \param session the object path of the session
+     */
+    void sessionRemoved(const QString &seat, const QString &session);
+
+    /**
+     * This signal is emitted when another session becomes the active one on
+     * \p seat, which changes the authorizations of the sessions of that seat.
+     *
+     * \param seat the object path of the seat
+     * \param session the object path of the newly active session, empty if there is none
+     */
+    void activeSessionChanged(const QString &seat, const QString &session);
+
+    /**
+     * This signal is emitted once for a burst of configChanged() and
+     * consoleKitDBChanged() notifications, at most once per
+     * changeCoalescingWindow(). Connect to it rather than to both of them when
+     * changes trigger expensive work, like checking authorizations again.
+     *
+     * \param generation a counter incremented for every emission
+     */
+    void changed(quint64 generation);
+
+    /**
+     * This signal is emitted when this process learns that temporary
+     * authorizations may have changed: a check was granted by a temporary
+     * authorization it had not seen yet, or temporary authorizations were
+     * revoked through this Authority.
+     *
+     * polkitd does not announce temporary authorizations, so changes made by
+     * other processes go unnoticed.
+     *
+     * \see watchTemporaryAuthorizations
+     */
+    void temporaryAuthorizationsChanged();
+
     /**
      * This signal is emitted when asynchronous method checkAuthorization finishes.
      *
@@ -530,6 +1060,16 @@ private:
     Private * const d;
 
     Q_PRIVATE_SLOT(d, void dbusFilter(const QDBusMessage &message))
+    Q_PRIVATE_SLOT(d, void seatsListed(const QDBusMessage &message))
+    Q_PRIVATE_SLOT(d, void scheduleChange())
+    Q_PRIVATE_SLOT(d, void emitChange())
+    Q_PRIVATE_SLOT(d, void polkitChanged())
+    Q_PRIVATE_SLOT(d, void consoleKitChanged())
+    Q_PRIVATE_SLOT(d, void reconnect())
+    Q_PRIVATE_SLOT(d, void authorityQueried(const QDBusMessage &message))
+    Q_PRIVATE_SLOT(d, void cacheExpire())
+    Q_PRIVATE_SLOT(d, void scheduleCacheExpiry())
+    Q_PRIVATE_SLOT(d, void lookupTemporaryAuthorizations())
 };
 
 }
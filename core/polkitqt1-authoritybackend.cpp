@@ -0,0 +1,1137 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "polkitqt1-authoritybackend_p.h"
+#include "polkitqt1-authoritymetrics_p.h"
+#include "polkitqt1-deadline_p.h"
+#include "polkitqt1-fakeauthoritybackend_p.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QThread>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QTimer>
+#include <QtDBus/QDBusArgument>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusPendingCallWatcher>
+
+#include <climits>
+
+#include <polkit/polkit.h>
+
+namespace PolkitQt1
+{
+
+static const char polkitService[] = "org.freedesktop.PolicyKit1";
+static const char authorityPath[] = "/org/freedesktop/PolicyKit1/Authority";
+static const char authorityInterface[] = "org.freedesktop.PolicyKit1.Authority";
+// polkitd names in the details the temporary authorization a check was granted by
+static const char temporaryAuthorizationKey[] = "polkit.temporary_authorization_id";
+
+bool AuthorityBackend::useDBus()
+{
+    const QByteArray backend = qgetenv("POLKIT_QT_1_BACKEND");
+    if (backend == "qtdbus") {
+        return true;
+    } else if (backend == "polkit") {
+        return false;
+    }
+
+#ifdef POLKIT_QT_1_DBUS_BACKEND
+    return true;
+#else
+    return false;
+#endif
+}
+
+static Authority::Result polkitResultToResult(PolkitAuthorizationResult *result)
+{
+    if (polkit_authorization_result_get_is_challenge(result)) {
+        return Authority::Challenge;
+    } else if (polkit_authorization_result_get_is_authorized(result)) {
+        return Authority::Yes;
+    } else {
+        return Authority::No;
+    }
+}
+
+struct PolkitCheckData
+{
+    CheckAuthorizationCallback callback;
+    void *userData;
+};
+
+static void polkitCheckAuthorizationCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    PolkitCheckData *data = (PolkitCheckData *) user_data;
+    CheckAuthorizationReply reply;
+
+    GError *error = NULL;
+    PolkitAuthorizationResult *pkResult = polkit_authority_check_authorization_finish((PolkitAuthority *) object, result, &error);
+
+    if (error != NULL) {
+        if (isCancelledError(error)) {
+            reply.cancelled = true;
+        } else {
+            reply.error = Authority::E_CheckFailed;
+            reply.errorDetails = QString::fromUtf8(error->message);
+        }
+        g_error_free(error);
+    } else if (pkResult != NULL) {
+        reply.result = polkitResultToResult(pkResult);
+        PolkitDetails *details = polkit_authorization_result_get_details(pkResult);
+        if (details != NULL) {
+            reply.temporaryAuthorizationId = QString::fromUtf8(polkit_details_lookup(details, temporaryAuthorizationKey));
+        }
+        g_object_unref(pkResult);
+    } else {
+        reply.error = Authority::E_UnknownResult;
+    }
+
+    data->callback(reply, data->userData);
+    delete data;
+}
+
+PolkitAuthorityBackend::PolkitAuthorityBackend(PolkitAuthority *authority)
+        : m_authority((PolkitAuthority *) g_object_ref(authority))
+{
+}
+
+PolkitAuthorityBackend::~PolkitAuthorityBackend()
+{
+    g_object_unref(m_authority);
+}
+
+void PolkitAuthorityBackend::checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                                                Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                                                CheckAuthorizationCallback callback, void *userData)
+{
+    PolkitCheckData *data = new PolkitCheckData;
+    data->callback = callback;
+    data->userData = userData;
+
+    polkit_authority_check_authorization(m_authority,
+                                         subject.subject(),
+                                         actionId.constData(),
+                                         NULL,
+                                         (PolkitCheckAuthorizationFlags)(int)flags,
+                                         cancellable,
+                                         polkitCheckAuthorizationCallback, data);
+}
+
+void PolkitAuthorityBackend::beginBlocking()
+{
+    // Replies to calls started now are dispatched on a private context, so that
+    // only they are handled while we wait, like the polkit *_sync functions do
+    GMainContext *context = g_main_context_new();
+    g_main_context_push_thread_default(context);
+}
+
+void PolkitAuthorityBackend::waitForCompletion(const bool *done)
+{
+    GMainContext *context = g_main_context_get_thread_default();
+    while (!*done) {
+        g_main_context_iteration(context, TRUE);
+    }
+}
+
+void PolkitAuthorityBackend::endBlocking()
+{
+    GMainContext *context = g_main_context_get_thread_default();
+    g_main_context_pop_thread_default(context);
+    g_main_context_unref(context);
+}
+
+// Calls started by a thread in blocking mode, in the order they were sent
+struct DBusBlockingState
+{
+    DBusBlockingState() : depth(0) {}
+
+    int depth;
+    QList<DBusCheckAuthorizationCall *> calls;
+};
+
+static QThreadStorage<DBusBlockingState *> s_blockingState;
+static QAtomicInt s_lastCancellationId;
+
+static bool marshallSubject(QDBusArgument &argument, PolkitSubject *subject)
+{
+    QString kind;
+    QVariantMap details;
+
+    if (POLKIT_IS_UNIX_PROCESS(subject)) {
+        PolkitUnixProcess *process = POLKIT_UNIX_PROCESS(subject);
+        kind = QLatin1String("unix-process");
+        details.insert(QLatin1String("pid"), QVariant::fromValue<uint>(polkit_unix_process_get_pid(process)));
+        details.insert(QLatin1String("start-time"),
+                       QVariant::fromValue<qulonglong>(polkit_unix_process_get_start_time(process)));
+    } else if (POLKIT_IS_UNIX_SESSION(subject)) {
+        kind = QLatin1String("unix-session");
+        details.insert(QLatin1String("session-id"),
+                       QString::fromUtf8(polkit_unix_session_get_session_id(POLKIT_UNIX_SESSION(subject))));
+    } else if (POLKIT_IS_SYSTEM_BUS_NAME(subject)) {
+        kind = QLatin1String("system-bus-name");
+        details.insert(QLatin1String("name"),
+                       QString::fromUtf8(polkit_system_bus_name_get_name(POLKIT_SYSTEM_BUS_NAME(subject))));
+    } else {
+        return false;
+    }
+
+    argument.beginStructure();
+    argument << kind << details;
+    argument.endStructure();
+    return true;
+}
+
+static CheckAuthorizationReply replyFromMessage(const QDBusMessage &message)
+{
+    CheckAuthorizationReply reply;
+
+    if (message.type() == QDBusMessage::ErrorMessage) {
+        if (message.errorName() == QLatin1String("org.freedesktop.PolicyKit1.Error.Cancelled")) {
+            reply.cancelled = true;
+        } else {
+            reply.error = Authority::E_CheckFailed;
+            reply.errorDetails = message.errorMessage();
+        }
+        return reply;
+    }
+
+    if (message.arguments().isEmpty()) {
+        reply.error = Authority::E_UnknownResult;
+        return reply;
+    }
+
+    // (bba{ss}): is_authorized, is_challenge, details
+    bool authorized = false;
+    bool challenge = false;
+    QMap<QString, QString> details;
+    const QDBusArgument argument = message.arguments().at(0).value<QDBusArgument>();
+    argument.beginStructure();
+    argument >> authorized >> challenge >> details;
+    argument.endStructure();
+
+    if (challenge) {
+        reply.result = Authority::Challenge;
+    } else if (authorized) {
+        reply.result = Authority::Yes;
+    } else {
+        reply.result = Authority::No;
+    }
+    reply.temporaryAuthorizationId = details.value(QLatin1String(temporaryAuthorizationKey));
+    return reply;
+}
+
+DBusAuthorityBackend::DBusAuthorityBackend(const QDBusConnection &connection)
+        : m_connection(connection)
+{
+}
+
+DBusAuthorityBackend::~DBusAuthorityBackend()
+{
+}
+
+void DBusAuthorityBackend::checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                                              Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                                              CheckAuthorizationCallback callback, void *userData)
+{
+    QDBusPendingCall call = QDBusPendingCall::fromError(QDBusError(QDBusError::InvalidArgs,
+                                                                   QLatin1String("Unsupported subject")));
+    QString cancellationId;
+
+    QDBusArgument subjectArgument;
+    if (marshallSubject(subjectArgument, subject.subject())) {
+        // only interactive checks can be cancelled on the polkitd side
+        if (flags & Authority::AllowUserInteraction) {
+            cancellationId = QString::fromLatin1("polkit-qt-1-%1").arg(s_lastCancellationId.fetchAndAddRelaxed(1) + 1);
+        }
+
+        QDBusArgument detailsArgument;
+        detailsArgument.beginMap(QVariant::String, QVariant::String);
+        detailsArgument.endMap();
+
+        QDBusMessage message = QDBusMessage::createMethodCall(QLatin1String(polkitService),
+                                                              QLatin1String(authorityPath),
+                                                              QLatin1String(authorityInterface),
+                                                              QLatin1String("CheckAuthorization"));
+        message << QVariant::fromValue(subjectArgument)
+                << QString::fromLatin1(actionId)
+                << QVariant::fromValue(detailsArgument)
+                << uint(flags)
+                << cancellationId;
+
+        // as with libpolkit-gobject, a check waits for polkitd as long as it takes, an interactive
+        // one lasts as long as the user needs to authenticate
+        int timeout = INT_MAX;
+        // a blocking wait for the reply cannot be cancelled, so it has to time out by itself
+        const Deadline *deadline = Deadline::current();
+        if (deadline != NULL) {
+            timeout = qMax(1, deadline->remaining());
+        }
+        call = m_connection.asyncCall(message, timeout);
+    }
+
+    DBusCheckAuthorizationCall *pending = new DBusCheckAuthorizationCall(this, call, cancellationId, cancellable,
+                                                                         callback, userData);
+    if (s_blockingState.hasLocalData() && s_blockingState.localData()->depth > 0) {
+        s_blockingState.localData()->calls.append(pending);
+    } else {
+        pending->watch();
+    }
+}
+
+void DBusAuthorityBackend::beginBlocking()
+{
+    if (!s_blockingState.hasLocalData()) {
+        s_blockingState.setLocalData(new DBusBlockingState);
+    }
+    ++s_blockingState.localData()->depth;
+}
+
+void DBusAuthorityBackend::waitForCompletion(const bool *done)
+{
+    DBusBlockingState *state = s_blockingState.localData();
+    while (!*done && !state->calls.isEmpty()) {
+        DBusCheckAuthorizationCall *call = state->calls.takeFirst();
+        call->waitForFinished();
+        // the callback may have started further calls
+        delete call;
+    }
+}
+
+void DBusAuthorityBackend::endBlocking()
+{
+    DBusBlockingState *state = s_blockingState.localData();
+    if (--state->depth == 0) {
+        // calls the caller did not wait for complete from the event loop
+        Q_FOREACH(DBusCheckAuthorizationCall *call, state->calls) {
+            call->watch();
+        }
+        state->calls.clear();
+    }
+}
+
+DBusCheckAuthorizationCall::DBusCheckAuthorizationCall(DBusAuthorityBackend *backend, const QDBusPendingCall &call,
+                                                       const QString &cancellationId, GCancellable *cancellable,
+                                                       CheckAuthorizationCallback callback, void *userData)
+        : QObject(0)
+        , m_backend(backend)
+        , m_call(call)
+        , m_watcher(0)
+        , m_cancellationId(cancellationId)
+        , m_cancellable((GCancellable *) g_object_ref(cancellable))
+        , m_cancelledHandler(0)
+        , m_callback(callback)
+        , m_userData(userData)
+        , m_completed(false)
+{
+    // runs right away if the cancellable is already cancelled
+    m_cancelledHandler = g_cancellable_connect(m_cancellable, G_CALLBACK(cancelledCallback), this, NULL);
+}
+
+DBusCheckAuthorizationCall::~DBusCheckAuthorizationCall()
+{
+    if (m_cancelledHandler != 0) {
+        g_cancellable_disconnect(m_cancellable, m_cancelledHandler);
+    }
+    g_object_unref(m_cancellable);
+}
+
+void DBusCheckAuthorizationCall::watch()
+{
+    m_watcher = new QDBusPendingCallWatcher(m_call, this);
+    connect(m_watcher, SIGNAL(finished(QDBusPendingCallWatcher*)), this, SLOT(callFinished()));
+}
+
+void DBusCheckAuthorizationCall::waitForFinished()
+{
+    if (!g_cancellable_is_cancelled(m_cancellable)) {
+        m_call.waitForFinished();
+    }
+
+    if (g_cancellable_is_cancelled(m_cancellable)) {
+        cancel();
+    } else {
+        complete(replyFromMessage(m_call.reply()));
+    }
+}
+
+void DBusCheckAuthorizationCall::callFinished()
+{
+    complete(replyFromMessage(m_call.reply()));
+    deleteLater();
+}
+
+void DBusCheckAuthorizationCall::cancel()
+{
+    if (m_completed) {
+        return;
+    }
+
+    if (!m_cancellationId.isEmpty()) {
+        // make polkitd dismiss the authentication dialog
+        QDBusMessage message = QDBusMessage::createMethodCall(QLatin1String(polkitService),
+                                                              QLatin1String(authorityPath),
+                                                              QLatin1String(authorityInterface),
+                                                              QLatin1String("CancelCheckAuthorization"));
+        message << m_cancellationId;
+        m_backend->m_connection.send(message);
+    }
+
+    CheckAuthorizationReply reply;
+    reply.cancelled = true;
+    complete(reply);
+    if (m_watcher) {
+        deleteLater();
+    }
+}
+
+void DBusCheckAuthorizationCall::complete(const CheckAuthorizationReply &reply)
+{
+    if (m_completed) {
+        return;
+    }
+    m_completed = true;
+
+    if (m_cancelledHandler != 0) {
+        g_cancellable_disconnect(m_cancellable, m_cancelledHandler);
+        m_cancelledHandler = 0;
+    }
+
+    m_callback(reply, m_userData);
+}
+
+void DBusCheckAuthorizationCall::cancelledCallback(GCancellable *cancellable, void *user_data)
+{
+    Q_UNUSED(cancellable);
+    // we may be called from any thread: complete the call from the one it belongs to
+    QMetaObject::invokeMethod((DBusCheckAuthorizationCall *) user_data, "cancel", Qt::QueuedConnection);
+}
+
+// Calls started by a thread in blocking mode, in the order they were started
+struct InProcessBlockingState
+{
+    InProcessBlockingState() : depth(0) {}
+
+    int depth;
+    QList<FakeCheckAuthorizationCall *> calls;
+};
+
+static QThreadStorage<InProcessBlockingState *> s_inProcessBlockingState;
+
+InProcessAuthorityBackend::InProcessAuthorityBackend(FakeAuthorityBackend *fake)
+        : m_fake(fake)
+{
+}
+
+InProcessAuthorityBackend::~InProcessAuthorityBackend()
+{
+}
+
+void InProcessAuthorityBackend::checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                                                   Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                                                   CheckAuthorizationCallback callback, void *userData)
+{
+    Q_UNUSED(subject);
+    Q_UNUSED(flags);
+
+    const CheckAuthorizationReply reply = m_fake->d->answer(QString::fromLatin1(actionId));
+    FakeCheckAuthorizationCall *call = new FakeCheckAuthorizationCall(reply, m_fake->latency(), cancellable,
+                                                                      callback, userData);
+    if (s_inProcessBlockingState.hasLocalData() && s_inProcessBlockingState.localData()->depth > 0) {
+        s_inProcessBlockingState.localData()->calls.append(call);
+    } else {
+        call->start();
+    }
+}
+
+void InProcessAuthorityBackend::beginBlocking()
+{
+    if (!s_inProcessBlockingState.hasLocalData()) {
+        s_inProcessBlockingState.setLocalData(new InProcessBlockingState);
+    }
+    ++s_inProcessBlockingState.localData()->depth;
+}
+
+void InProcessAuthorityBackend::waitForCompletion(const bool *done)
+{
+    InProcessBlockingState *state = s_inProcessBlockingState.localData();
+    while (!*done && !state->calls.isEmpty()) {
+        FakeCheckAuthorizationCall *call = state->calls.takeFirst();
+        call->waitForFinished();
+        // the callback may have started further calls
+        delete call;
+    }
+}
+
+void InProcessAuthorityBackend::endBlocking()
+{
+    InProcessBlockingState *state = s_inProcessBlockingState.localData();
+    if (--state->depth == 0) {
+        // calls the caller did not wait for complete from the event loop
+        Q_FOREACH(FakeCheckAuthorizationCall *call, state->calls) {
+            call->start();
+        }
+        state->calls.clear();
+    }
+}
+
+FakeCheckAuthorizationCall::FakeCheckAuthorizationCall(const CheckAuthorizationReply &reply, int latency,
+                                                       GCancellable *cancellable,
+                                                       CheckAuthorizationCallback callback, void *userData)
+        : QObject(0)
+        , m_reply(reply)
+        , m_latency(latency)
+        , m_cancellable((GCancellable *) g_object_ref(cancellable))
+        , m_cancelledHandler(0)
+        , m_callback(callback)
+        , m_userData(userData)
+        , m_started(false)
+        , m_completed(false)
+{
+    m_timer.start();
+    // runs right away if the cancellable is already cancelled
+    m_cancelledHandler = g_cancellable_connect(m_cancellable, G_CALLBACK(cancelledCallback), this, NULL);
+}
+
+FakeCheckAuthorizationCall::~FakeCheckAuthorizationCall()
+{
+    if (m_cancelledHandler != 0) {
+        g_cancellable_disconnect(m_cancellable, m_cancelledHandler);
+    }
+    g_object_unref(m_cancellable);
+}
+
+qint64 FakeCheckAuthorizationCall::remaining() const
+{
+    return qMax<qint64>(0, m_latency - m_timer.elapsed());
+}
+
+void FakeCheckAuthorizationCall::start()
+{
+    m_started = true;
+    QTimer::singleShot(remaining(), this, SLOT(finish()));
+}
+
+void FakeCheckAuthorizationCall::waitForFinished()
+{
+    // in slices, so that a cancellation by a deadline is noticed
+    qint64 msecs = remaining();
+    while (msecs > 0 && !g_cancellable_is_cancelled(m_cancellable)) {
+        QThread::msleep(qMin<qint64>(msecs, 5));
+        msecs = remaining();
+    }
+
+    if (g_cancellable_is_cancelled(m_cancellable)) {
+        cancel();
+    } else {
+        complete(m_reply);
+    }
+}
+
+void FakeCheckAuthorizationCall::finish()
+{
+    complete(m_reply);
+    deleteLater();
+}
+
+void FakeCheckAuthorizationCall::cancel()
+{
+    if (m_completed) {
+        return;
+    }
+
+    CheckAuthorizationReply reply;
+    reply.cancelled = true;
+    complete(reply);
+    if (m_started) {
+        deleteLater();
+    }
+}
+
+void FakeCheckAuthorizationCall::complete(const CheckAuthorizationReply &reply)
+{
+    if (m_completed) {
+        return;
+    }
+    m_completed = true;
+
+    if (m_cancelledHandler != 0) {
+        g_cancellable_disconnect(m_cancellable, m_cancelledHandler);
+        m_cancelledHandler = 0;
+    }
+
+    m_callback(reply, m_userData);
+}
+
+void FakeCheckAuthorizationCall::cancelledCallback(GCancellable *cancellable, void *user_data)
+{
+    Q_UNUSED(cancellable);
+    // we may be called from any thread: complete the call from the one it belongs to
+    QMetaObject::invokeMethod((FakeCheckAuthorizationCall *) user_data, "cancel", Qt::QueuedConnection);
+}
+
+// A check sent to the authority, and the callers waiting for it
+struct CheckFlight
+{
+    CoalescingAuthorityBackend *backend;
+    // kept alive until the check completed
+    QSharedPointer<AuthorityBackend> target;
+    QString key;
+    // cancelled once every waiter gave up
+    GCancellable *cancellable;
+    QList<CheckFlightWaiter *> waiters;
+};
+
+// A check forwarded as is, and the backend it has to keep alive
+struct ForwardedCheck
+{
+    QSharedPointer<AuthorityBackend> backend;
+    CheckAuthorizationCallback callback;
+    void *userData;
+};
+
+CoalescingAuthorityBackend::CoalescingAuthorityBackend()
+        : m_enabled(true)
+        , m_coalescedChecks(0)
+{
+}
+
+CoalescingAuthorityBackend::~CoalescingAuthorityBackend()
+{
+}
+
+AuthorityBackend *CoalescingAuthorityBackend::coalesce(AuthorityBackend *backend)
+{
+    QMutexLocker locker(&m_mutex);
+    // the checks in flight hold the previous one
+    m_backend = BackendPointer(backend);
+    return this;
+}
+
+void CoalescingAuthorityBackend::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_enabled = enabled;
+}
+
+bool CoalescingAuthorityBackend::isEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_enabled;
+}
+
+quint64 CoalescingAuthorityBackend::coalescedChecks() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_coalescedChecks;
+}
+
+bool CoalescingAuthorityBackend::isBlocking()
+{
+    return m_blocking.hasLocalData() && m_blocking.localData().depth > 0;
+}
+
+CoalescingAuthorityBackend::BackendPointer CoalescingAuthorityBackend::target()
+{
+    if (isBlocking()) {
+        return m_blocking.localData().backend;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    return m_backend;
+}
+
+void CoalescingAuthorityBackend::forward(const BackendPointer &backend, const Subject &subject,
+                                         const QByteArray &actionId, Authority::AuthorizationFlags flags,
+                                         GCancellable *cancellable, CheckAuthorizationCallback callback,
+                                         void *userData)
+{
+    ForwardedCheck *check = new ForwardedCheck;
+    check->backend = backend;
+    check->callback = callback;
+    check->userData = userData;
+    backend->checkAuthorization(subject, actionId, flags, cancellable, forwardCallback, check);
+}
+
+void CoalescingAuthorityBackend::forwardCallback(const CheckAuthorizationReply &reply, void *user_data)
+{
+    // the backends never touch themselves once the callback is called,
+    // so the last check of a replaced one may delete it
+    QScopedPointer<ForwardedCheck> check((ForwardedCheck *) user_data);
+    check->callback(reply, check->userData);
+}
+
+void CoalescingAuthorityBackend::checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                                                    Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                                                    CheckAuthorizationCallback callback, void *userData)
+{
+    const BackendPointer backend = target();
+
+    // every interactive check is a dialog of its own
+    if (!isEnabled() || (flags & Authority::AllowUserInteraction) || !subject.isValid()) {
+        forward(backend, subject, actionId, flags, cancellable, callback, userData);
+        return;
+    }
+
+    const QString key = QString::fromLatin1(actionId) + QLatin1Char('\n') + subjectToString(subject.subject())
+                        + QLatin1Char('\n') + QString::number(int(flags));
+    const bool blocking = isBlocking();
+    if (blocking && Deadline::current() != NULL) {
+        // the flight would not be cancelled when the deadline expires, as other callers may need it
+        forward(backend, subject, actionId, flags, cancellable, callback, userData);
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    CheckFlight *flight = m_flights.value(key);
+    if (flight != NULL) {
+        if (blocking) {
+            locker.unlock();
+            forward(backend, subject, actionId, flags, cancellable, callback, userData);
+            return;
+        }
+        ++m_coalescedChecks;
+        flight->waiters.append(new CheckFlightWaiter(this, key, cancellable, callback, userData));
+        return;
+    }
+
+    flight = new CheckFlight;
+    flight->backend = this;
+    flight->target = backend;
+    flight->key = key;
+    flight->cancellable = g_cancellable_new();
+    flight->waiters.append(new CheckFlightWaiter(this, key, cancellable, callback, userData));
+    m_flights.insert(key, flight);
+    locker.unlock();
+
+    backend->checkAuthorization(subject, actionId, flags, flight->cancellable, flightCallback, flight);
+}
+
+void CoalescingAuthorityBackend::beginBlocking()
+{
+    BlockingState &state = m_blocking.localData();
+    if (state.depth++ == 0) {
+        QMutexLocker locker(&m_mutex);
+        state.backend = m_backend;
+    }
+    state.backend->beginBlocking();
+}
+
+void CoalescingAuthorityBackend::waitForCompletion(const bool *done)
+{
+    m_blocking.localData().backend->waitForCompletion(done);
+}
+
+void CoalescingAuthorityBackend::endBlocking()
+{
+    BlockingState &state = m_blocking.localData();
+    state.backend->endBlocking();
+    if (--state.depth == 0) {
+        state.backend.clear();
+    }
+}
+
+void CoalescingAuthorityBackend::flightCallback(const CheckAuthorizationReply &reply, void *user_data)
+{
+    CheckFlight *flight = (CheckFlight *) user_data;
+    CoalescingAuthorityBackend *backend = flight->backend;
+
+    backend->m_mutex.lock();
+    if (backend->m_flights.value(flight->key) == flight) {
+        backend->m_flights.remove(flight->key);
+    }
+    const QList<CheckFlightWaiter *> waiters = flight->waiters;
+    flight->waiters.clear();
+    backend->m_mutex.unlock();
+
+    g_object_unref(flight->cancellable);
+    delete flight;
+
+    Q_FOREACH(CheckFlightWaiter *waiter, waiters) {
+        waiter->deliver(reply);
+    }
+}
+
+bool CoalescingAuthorityBackend::detach(CheckFlightWaiter *waiter, const QString &key)
+{
+    QMutexLocker locker(&m_mutex);
+    // the flight of the waiter may be over and deleted already
+    CheckFlight *flight = m_flights.value(key);
+    if (flight == NULL || !flight->waiters.removeOne(waiter)) {
+        return false;
+    }
+
+    if (flight->waiters.isEmpty()) {
+        // nobody is interested anymore: a new check must not wait for this one
+        m_flights.remove(flight->key);
+        GCancellable *cancellable = (GCancellable *) g_object_ref(flight->cancellable);
+        locker.unlock();
+        g_cancellable_cancel(cancellable);
+        g_object_unref(cancellable);
+    }
+    return true;
+}
+
+CheckFlightWaiter::CheckFlightWaiter(CoalescingAuthorityBackend *backend, const QString &key,
+                                     GCancellable *cancellable, CheckAuthorizationCallback callback,
+                                     void *userData)
+        : QObject(0)
+        , m_backend(backend)
+        , m_key(key)
+        , m_cancellable((GCancellable *) g_object_ref(cancellable))
+        , m_cancelledHandler(0)
+        , m_callback(callback)
+        , m_userData(userData)
+{
+    // runs right away if the cancellable is already cancelled
+    m_cancelledHandler = g_cancellable_connect(m_cancellable, G_CALLBACK(cancelledCallback), this, NULL);
+}
+
+CheckFlightWaiter::~CheckFlightWaiter()
+{
+    disconnectCancellable();
+    g_object_unref(m_cancellable);
+}
+
+void CheckFlightWaiter::disconnectCancellable()
+{
+    if (m_cancelledHandler != 0) {
+        g_cancellable_disconnect(m_cancellable, m_cancelledHandler);
+        m_cancelledHandler = 0;
+    }
+}
+
+void CheckFlightWaiter::deliver(const CheckAuthorizationReply &reply)
+{
+    disconnectCancellable();
+    m_reply = reply;
+    if (thread() == QThread::currentThread()) {
+        deliverQueued();
+    } else {
+        QMetaObject::invokeMethod(this, "deliverQueued", Qt::QueuedConnection);
+    }
+}
+
+void CheckFlightWaiter::deliverQueued()
+{
+    m_callback(m_reply, m_userData);
+    // also drops a pending cancel()
+    delete this;
+}
+
+void CheckFlightWaiter::cancel()
+{
+    if (!m_backend->detach(this, m_key)) {
+        // the reply is already on its way
+        return;
+    }
+
+    disconnectCancellable();
+    CheckAuthorizationReply reply;
+    reply.cancelled = true;
+    m_callback(reply, m_userData);
+    delete this;
+}
+
+void CheckFlightWaiter::cancelledCallback(GCancellable *cancellable, void *user_data)
+{
+    Q_UNUSED(cancellable);
+    // we may be called from any thread: complete the waiter from the one it belongs to
+    QMetaObject::invokeMethod((CheckFlightWaiter *) user_data, "cancel", Qt::QueuedConnection);
+}
+
+// A check sent to the authority in a slot of a lane, which it gives back when done
+struct LaneSlot
+{
+    SchedulingAuthorityBackend *backend;
+    AuthorityMetrics::Lane lane;
+    CheckAuthorizationCallback callback;
+    void *userData;
+};
+
+SchedulingAuthorityBackend::SchedulingAuthorityBackend(AuthorityMetricsRecorder *metrics)
+        : m_backend(0)
+        , m_metrics(metrics)
+{
+    // polkit agents show one dialog at a time anyway
+    m_lanes[AuthorityMetrics::InteractiveLane].limit = 4;
+    m_lanes[AuthorityMetrics::BackgroundLane].limit = 64;
+}
+
+SchedulingAuthorityBackend::~SchedulingAuthorityBackend()
+{
+    for (int i = 0; i < AuthorityMetrics::LaneCount; ++i) {
+        qDeleteAll(m_lanes[i].queue);
+    }
+}
+
+AuthorityBackend *SchedulingAuthorityBackend::schedule(AuthorityBackend *backend)
+{
+    m_backend = backend;
+    return this;
+}
+
+void SchedulingAuthorityBackend::setLimit(AuthorityMetrics::Lane lane, int limit)
+{
+    m_mutex.lock();
+    m_lanes[lane].limit = qMax(1, limit);
+    // a higher limit lets some of the waiting checks go
+    const QList<ScheduledCheck *> ready = takeReady(lane);
+    m_mutex.unlock();
+
+    Q_FOREACH(ScheduledCheck *check, ready) {
+        check->startLater();
+    }
+}
+
+int SchedulingAuthorityBackend::limit(AuthorityMetrics::Lane lane) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lanes[lane].limit;
+}
+
+void SchedulingAuthorityBackend::checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                                                    Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                                                    CheckAuthorizationCallback callback, void *userData)
+{
+    const AuthorityMetrics::Lane lane = (flags & Authority::AllowUserInteraction)
+                                        ? AuthorityMetrics::InteractiveLane : AuthorityMetrics::BackgroundLane;
+    const bool blocking = m_blockingDepth.hasLocalData() && m_blockingDepth.localData() > 0;
+
+    QMutexLocker locker(&m_mutex);
+    LaneState &state = m_lanes[lane];
+    // checks which are already waiting go first
+    if (blocking || (state.inFlight < state.limit && state.queue.isEmpty())) {
+        ++state.inFlight;
+        m_metrics->laneInFlight(lane, state.inFlight);
+        locker.unlock();
+        forward(lane, subject, actionId, flags, cancellable, callback, userData);
+        return;
+    }
+
+    state.queue.append(new ScheduledCheck(this, lane, subject, actionId, flags, cancellable, callback, userData));
+    m_metrics->laneQueued(lane, state.queue.size());
+}
+
+void SchedulingAuthorityBackend::beginBlocking()
+{
+    m_blockingDepth.setLocalData(m_blockingDepth.localData() + 1);
+    m_backend->beginBlocking();
+}
+
+void SchedulingAuthorityBackend::waitForCompletion(const bool *done)
+{
+    m_backend->waitForCompletion(done);
+}
+
+void SchedulingAuthorityBackend::endBlocking()
+{
+    m_backend->endBlocking();
+    m_blockingDepth.setLocalData(m_blockingDepth.localData() - 1);
+}
+
+void SchedulingAuthorityBackend::forward(AuthorityMetrics::Lane lane, const Subject &subject, const QByteArray &actionId,
+                                         Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                                         CheckAuthorizationCallback callback, void *userData)
+{
+    LaneSlot *slot = new LaneSlot;
+    slot->backend = this;
+    slot->lane = lane;
+    slot->callback = callback;
+    slot->userData = userData;
+    m_backend->checkAuthorization(subject, actionId, flags, cancellable, slotCallback, slot);
+}
+
+void SchedulingAuthorityBackend::release(AuthorityMetrics::Lane lane)
+{
+    m_mutex.lock();
+    --m_lanes[lane].inFlight;
+    const QList<ScheduledCheck *> ready = takeReady(lane);
+    m_mutex.unlock();
+
+    Q_FOREACH(ScheduledCheck *check, ready) {
+        check->startLater();
+    }
+}
+
+QList<ScheduledCheck *> SchedulingAuthorityBackend::takeReady(AuthorityMetrics::Lane lane)
+{
+    LaneState &state = m_lanes[lane];
+    QList<ScheduledCheck *> ready;
+    while (state.inFlight < state.limit && !state.queue.isEmpty()) {
+        ScheduledCheck *check = state.queue.takeFirst();
+        ++state.inFlight;
+        m_metrics->laneDequeued(lane, state.queue.size(), check->waited());
+        ready.append(check);
+    }
+    m_metrics->laneInFlight(lane, state.inFlight);
+    return ready;
+}
+
+bool SchedulingAuthorityBackend::dequeue(ScheduledCheck *check)
+{
+    QMutexLocker locker(&m_mutex);
+    QList<ScheduledCheck *> &queue = m_lanes[check->lane()].queue;
+    if (!queue.removeOne(check)) {
+        return false;
+    }
+    m_metrics->laneDequeued(check->lane(), queue.size(), check->waited());
+    return true;
+}
+
+void SchedulingAuthorityBackend::slotCallback(const CheckAuthorizationReply &reply, void *user_data)
+{
+    LaneSlot *slot = (LaneSlot *) user_data;
+    const CheckAuthorizationCallback callback = slot->callback;
+    void *userData = slot->userData;
+    // the next check of the lane can go before the caller handles the reply
+    slot->backend->release(slot->lane);
+    delete slot;
+
+    callback(reply, userData);
+}
+
+ScheduledCheck::ScheduledCheck(SchedulingAuthorityBackend *backend, AuthorityMetrics::Lane lane, const Subject &subject,
+                               const QByteArray &actionId, Authority::AuthorizationFlags flags,
+                               GCancellable *cancellable, CheckAuthorizationCallback callback, void *userData)
+        : QObject(0)
+        , m_backend(backend)
+        , m_lane(lane)
+        , m_subject(subject)
+        , m_actionId(actionId)
+        , m_flags(flags)
+        , m_cancellable((GCancellable *) g_object_ref(cancellable))
+        , m_cancelledHandler(0)
+        , m_callback(callback)
+        , m_userData(userData)
+{
+    m_timer.start();
+    // a check which is cancelled while waiting must not wait for a slot to say so
+    m_cancelledHandler = g_cancellable_connect(m_cancellable, G_CALLBACK(cancelledCallback), this, NULL);
+}
+
+ScheduledCheck::~ScheduledCheck()
+{
+    disconnectCancellable();
+    g_object_unref(m_cancellable);
+}
+
+AuthorityMetrics::Lane ScheduledCheck::lane() const
+{
+    return m_lane;
+}
+
+qint64 ScheduledCheck::waited() const
+{
+    return m_timer.nsecsElapsed() / 1000;
+}
+
+void ScheduledCheck::startLater()
+{
+    QMetaObject::invokeMethod(this, "start", Qt::QueuedConnection);
+}
+
+void ScheduledCheck::disconnectCancellable()
+{
+    if (m_cancelledHandler != 0) {
+        g_cancellable_disconnect(m_cancellable, m_cancelledHandler);
+        m_cancelledHandler = 0;
+    }
+}
+
+void ScheduledCheck::start()
+{
+    disconnectCancellable();
+    if (g_cancellable_is_cancelled(m_cancellable)) {
+        m_backend->release(m_lane);
+        CheckAuthorizationReply reply;
+        reply.cancelled = true;
+        m_callback(reply, m_userData);
+    } else {
+        m_backend->forward(m_lane, m_subject, m_actionId, m_flags, m_cancellable, m_callback, m_userData);
+    }
+    // also drops a pending cancel()
+    delete this;
+}
+
+void ScheduledCheck::cancel()
+{
+    if (!m_backend->dequeue(this)) {
+        // it got a slot, start() takes care of it
+        return;
+    }
+
+    disconnectCancellable();
+    CheckAuthorizationReply reply;
+    reply.cancelled = true;
+    m_callback(reply, m_userData);
+    delete this;
+}
+
+void ScheduledCheck::cancelledCallback(GCancellable *cancellable, void *user_data)
+{
+    Q_UNUSED(cancellable);
+    // we may be called from any thread: complete the check from the one it belongs to
+    QMetaObject::invokeMethod((ScheduledCheck *) user_data, "cancel", Qt::QueuedConnection);
+}
+
+QueuedCheckAuthorization::QueuedCheckAuthorization(const Subject &subject, const QByteArray &actionId,
+                                                   Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                                                   CheckAuthorizationCallback callback, void *userData)
+        : QObject(0)
+        , m_backend(0)
+        , m_subject(subject)
+        , m_actionId(actionId)
+        , m_flags(flags)
+        , m_cancellable((GCancellable *) g_object_ref(cancellable))
+        , m_callback(callback)
+        , m_userData(userData)
+{
+}
+
+QueuedCheckAuthorization::~QueuedCheckAuthorization()
+{
+    g_object_unref(m_cancellable);
+}
+
+void QueuedCheckAuthorization::startLater(AuthorityBackend *backend)
+{
+    m_backend = backend;
+    QMetaObject::invokeMethod(this, "start", Qt::QueuedConnection);
+}
+
+void QueuedCheckAuthorization::start()
+{
+    if (m_backend != NULL && !g_cancellable_is_cancelled(m_cancellable)) {
+        m_backend->checkAuthorization(m_subject, m_actionId, m_flags, m_cancellable, m_callback, m_userData);
+    } else {
+        CheckAuthorizationReply reply;
+        if (m_backend == NULL) {
+            reply.error = Authority::E_GetAuthority;
+        } else {
+            reply.cancelled = true;
+        }
+        m_callback(reply, m_userData);
+    }
+    deleteLater();
+}
+
+}
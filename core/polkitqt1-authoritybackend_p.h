@@ -0,0 +1,509 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_AUTHORITYBACKEND_P_H
+#define POLKITQT1_AUTHORITYBACKEND_P_H
+
+#include "polkitqt1-authority.h"
+#include "polkitqt1-authoritymetrics.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadStorage>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusPendingCall>
+
+typedef struct _GCancellable GCancellable;
+typedef struct _GError GError;
+typedef struct _PolkitAuthority PolkitAuthority;
+
+class QDBusPendingCallWatcher;
+
+namespace PolkitQt1
+{
+
+class AuthorityMetricsRecorder;
+
+/**
+  * \internal
+  * \brief Outcome of a single authorization check, as reported by an AuthorityBackend
+  */
+struct CheckAuthorizationReply
+{
+    CheckAuthorizationReply()
+        : result(Authority::Unknown)
+        , error(Authority::E_None)
+        , cancelled(false) {}
+
+    Authority::Result result;
+    Authority::ErrorCode error;
+    QString errorDetails;
+    bool cancelled;
+    // the temporary authorization the result is due to, if any
+    QString temporaryAuthorizationId;
+};
+
+/** Returns \c true if \p error tells that the operation was cancelled */
+bool isCancelledError(GError *error);
+/** Returns the serialization of \p subject polkit uses */
+QString subjectToString(PolkitSubject *subject);
+
+typedef void (*CheckAuthorizationCallback)(const CheckAuthorizationReply &reply, void *userData);
+
+/**
+  * \internal
+  * \brief Transport used by Authority to talk to the polkit authority
+  *
+  * The backend carries the authorization checks, which are the hot path of
+  * the library. Callbacks are invoked from the thread which started the check.
+  *
+  * A thread can enter blocking mode with beginBlocking(): checks started until
+  * the matching endBlocking() are only completed by waitForCompletion(), which
+  * is how the synchronous API is built on top of the asynchronous calls.
+  */
+class AuthorityBackend
+{
+public:
+    virtual ~AuthorityBackend() {}
+
+    /** Returns \c true if the QtDBus backend is selected, by the build or
+     * by the POLKIT_QT_1_BACKEND environment variable ("qtdbus" or "polkit")
+     */
+    static bool useDBus();
+
+    /** Checks \p actionId for \p subject and calls \p callback with \p userData when done.
+     * \p cancellable is never \c NULL
+     */
+    virtual void checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                                    Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                                    CheckAuthorizationCallback callback, void *userData) = 0;
+
+    virtual void beginBlocking() = 0;
+    /** Dispatches completions of the checks started in blocking mode until \p done becomes \c true */
+    virtual void waitForCompletion(const bool *done) = 0;
+    virtual void endBlocking() = 0;
+};
+
+/**
+  * \internal
+  * \brief Backend talking to polkitd through libpolkit-gobject-1
+  */
+class PolkitAuthorityBackend : public AuthorityBackend
+{
+public:
+    explicit PolkitAuthorityBackend(PolkitAuthority *authority);
+    ~PolkitAuthorityBackend();
+
+    void checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                            Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                            CheckAuthorizationCallback callback, void *userData);
+
+    void beginBlocking();
+    void waitForCompletion(const bool *done);
+    void endBlocking();
+
+private:
+    PolkitAuthority *m_authority;
+};
+
+class DBusCheckAuthorizationCall;
+
+/**
+  * \internal
+  * \brief Backend talking to polkitd directly over the Qt system bus connection
+  *
+  * It avoids the GObject marshalling and the GLib main context hops of
+  * libpolkit-gobject-1 for every check.
+  */
+class DBusAuthorityBackend : public AuthorityBackend
+{
+public:
+    explicit DBusAuthorityBackend(const QDBusConnection &connection);
+    ~DBusAuthorityBackend();
+
+    void checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                            Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                            CheckAuthorizationCallback callback, void *userData);
+
+    void beginBlocking();
+    void waitForCompletion(const bool *done);
+    void endBlocking();
+
+private:
+    QDBusConnection m_connection;
+
+    friend class DBusCheckAuthorizationCall;
+};
+
+/**
+  * \internal
+  * \brief A CheckAuthorization call in flight on the QtDBus backend
+  *
+  * It lives in the thread which started the check, so that the callback is
+  * invoked there.
+  */
+class DBusCheckAuthorizationCall : public QObject
+{
+    Q_OBJECT
+public:
+    DBusCheckAuthorizationCall(DBusAuthorityBackend *backend, const QDBusPendingCall &call,
+                               const QString &cancellationId, GCancellable *cancellable,
+                               CheckAuthorizationCallback callback, void *userData);
+    ~DBusCheckAuthorizationCall();
+
+    /** Blocks until the reply arrives and completes the call */
+    void waitForFinished();
+    void watch();
+
+private Q_SLOTS:
+    void callFinished();
+    void cancel();
+
+private:
+    void complete(const CheckAuthorizationReply &reply);
+    static void cancelledCallback(GCancellable *cancellable, void *user_data);
+
+    DBusAuthorityBackend *m_backend;
+    QDBusPendingCall m_call;
+    QDBusPendingCallWatcher *m_watcher;
+    QString m_cancellationId;
+    GCancellable *m_cancellable;
+    unsigned long m_cancelledHandler;
+    CheckAuthorizationCallback m_callback;
+    void *m_userData;
+    bool m_completed;
+};
+
+class FakeAuthorityBackend;
+class FakeCheckAuthorizationCall;
+
+/**
+  * \internal
+  * \brief Backend answering from a FakeAuthorityBackend, without any IPC
+  */
+class InProcessAuthorityBackend : public AuthorityBackend
+{
+public:
+    explicit InProcessAuthorityBackend(FakeAuthorityBackend *fake);
+    ~InProcessAuthorityBackend();
+
+    void checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                            Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                            CheckAuthorizationCallback callback, void *userData);
+
+    void beginBlocking();
+    void waitForCompletion(const bool *done);
+    void endBlocking();
+
+private:
+    FakeAuthorityBackend *m_fake;
+};
+
+/**
+  * \internal
+  * \brief A check answered by a FakeAuthorityBackend, waiting for its latency to expire
+  *
+  * It lives in the thread which started the check, so that the callback is
+  * invoked there.
+  */
+class FakeCheckAuthorizationCall : public QObject
+{
+    Q_OBJECT
+public:
+    FakeCheckAuthorizationCall(const CheckAuthorizationReply &reply, int latency, GCancellable *cancellable,
+                               CheckAuthorizationCallback callback, void *userData);
+    ~FakeCheckAuthorizationCall();
+
+    /** Sleeps until the latency expired and completes the call */
+    void waitForFinished();
+    /** Completes the call from the event loop once the latency expired */
+    void start();
+
+private Q_SLOTS:
+    void finish();
+    void cancel();
+
+private:
+    void complete(const CheckAuthorizationReply &reply);
+    qint64 remaining() const;
+    static void cancelledCallback(GCancellable *cancellable, void *user_data);
+
+    CheckAuthorizationReply m_reply;
+    int m_latency;
+    QElapsedTimer m_timer;
+    GCancellable *m_cancellable;
+    unsigned long m_cancelledHandler;
+    CheckAuthorizationCallback m_callback;
+    void *m_userData;
+    bool m_started;
+    bool m_completed;
+};
+
+class CheckFlightWaiter;
+struct CheckFlight;
+
+/**
+  * \internal
+  * \brief Backend sending identical concurrent checks to the authority only once
+  *
+  * A check whose twin is already in flight waits for it instead of being
+  * forwarded. Checks started in blocking mode are always forwarded, since they
+  * cannot wait for a call dispatched by another thread or by the event loop,
+  * but the ones started after them may still wait for them, unless they run
+  * under a Deadline.
+  */
+class CoalescingAuthorityBackend : public AuthorityBackend
+{
+public:
+    CoalescingAuthorityBackend();
+    ~CoalescingAuthorityBackend();
+
+    /** Forwards the checks to \p backend, which it takes ownership of, and returns this backend.
+     * The previous backend is deleted once the checks it carries completed.
+     */
+    AuthorityBackend *coalesce(AuthorityBackend *backend);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    quint64 coalescedChecks() const;
+
+    void checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                            Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                            CheckAuthorizationCallback callback, void *userData);
+
+    void beginBlocking();
+    void waitForCompletion(const bool *done);
+    void endBlocking();
+
+private:
+    typedef QSharedPointer<AuthorityBackend> BackendPointer;
+
+    // A thread in blocking mode waits on the backend it started with
+    struct BlockingState
+    {
+        BlockingState() : depth(0) {}
+
+        int depth;
+        BackendPointer backend;
+    };
+
+    /** Returns the backend the checks of the calling thread go to */
+    BackendPointer target();
+    bool isBlocking();
+    /** Sends a check to \p backend, which stays alive until the check completes */
+    static void forward(const BackendPointer &backend, const Subject &subject, const QByteArray &actionId,
+                        Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                        CheckAuthorizationCallback callback, void *userData);
+    static void forwardCallback(const CheckAuthorizationReply &reply, void *user_data);
+    static void flightCallback(const CheckAuthorizationReply &reply, void *user_data);
+    /** Detaches \p waiter from the flight of \p key, returns \c false if that flight already completed */
+    bool detach(CheckFlightWaiter *waiter, const QString &key);
+
+    mutable QMutex m_mutex;
+    // replaced when polkitd comes back, while other threads may be using it
+    BackendPointer m_backend;
+    bool m_enabled;
+    quint64 m_coalescedChecks;
+    QHash<QString, CheckFlight *> m_flights;
+    QThreadStorage<BlockingState> m_blocking;
+
+    friend class CheckFlightWaiter;
+};
+
+/**
+  * \internal
+  * \brief A caller waiting for a check in flight on the CoalescingAuthorityBackend
+  *
+  * It lives in the thread of the caller, so that the callback is invoked there.
+  */
+class CheckFlightWaiter : public QObject
+{
+    Q_OBJECT
+public:
+    CheckFlightWaiter(CoalescingAuthorityBackend *backend, const QString &key, GCancellable *cancellable,
+                      CheckAuthorizationCallback callback, void *userData);
+    ~CheckFlightWaiter();
+
+    /** Completes the caller with \p reply, from its own thread. The waiter deletes itself */
+    void deliver(const CheckAuthorizationReply &reply);
+
+private Q_SLOTS:
+    void deliverQueued();
+    void cancel();
+
+private:
+    void disconnectCancellable();
+    static void cancelledCallback(GCancellable *cancellable, void *user_data);
+
+    CoalescingAuthorityBackend *m_backend;
+    QString m_key;
+    GCancellable *m_cancellable;
+    unsigned long m_cancelledHandler;
+    CheckAuthorizationCallback m_callback;
+    void *m_userData;
+    CheckAuthorizationReply m_reply;
+};
+
+class ScheduledCheck;
+
+/**
+  * \internal
+  * \brief Backend limiting the checks in flight, in separate lanes for interactive and background checks
+  *
+  * An interactive check lasts as long as the user takes to authenticate, so
+  * each lane has its own limit and its own queue: a pile of dialogs never
+  * delays the cheap background checks, and the other way around. Checks over
+  * the limit wait in the queue of their lane, in order, until a check of the
+  * same lane completes. Checks started in blocking mode never wait, since
+  * nothing would start them, but they count against the limit.
+  */
+class SchedulingAuthorityBackend : public AuthorityBackend
+{
+public:
+    explicit SchedulingAuthorityBackend(AuthorityMetricsRecorder *metrics);
+    ~SchedulingAuthorityBackend();
+
+    /** Forwards the checks to \p backend, which it does not take ownership of, and returns this backend */
+    AuthorityBackend *schedule(AuthorityBackend *backend);
+
+    void setLimit(AuthorityMetrics::Lane lane, int limit);
+    int limit(AuthorityMetrics::Lane lane) const;
+
+    void checkAuthorization(const Subject &subject, const QByteArray &actionId,
+                            Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                            CheckAuthorizationCallback callback, void *userData);
+
+    void beginBlocking();
+    void waitForCompletion(const bool *done);
+    void endBlocking();
+
+private:
+    struct LaneState
+    {
+        LaneState() : limit(1), inFlight(0) {}
+
+        int limit;
+        int inFlight;
+        QList<ScheduledCheck *> queue;
+    };
+
+    /** Sends a check to the backend in a slot of \p lane, which the caller already took */
+    void forward(AuthorityMetrics::Lane lane, const Subject &subject, const QByteArray &actionId,
+                 Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                 CheckAuthorizationCallback callback, void *userData);
+    /** Gives back a slot of \p lane, and hands the free slots to the checks waiting */
+    void release(AuthorityMetrics::Lane lane);
+    /** Hands the free slots of \p lane to the checks waiting, the mutex being locked */
+    QList<ScheduledCheck *> takeReady(AuthorityMetrics::Lane lane);
+    /** Removes \p check from its queue, returns \p false if it already got a slot */
+    bool dequeue(ScheduledCheck *check);
+    static void slotCallback(const CheckAuthorizationReply &reply, void *user_data);
+
+    AuthorityBackend *m_backend;
+    AuthorityMetricsRecorder *m_metrics;
+    mutable QMutex m_mutex;
+    LaneState m_lanes[AuthorityMetrics::LaneCount];
+    QThreadStorage<int> m_blockingDepth;
+
+    friend class ScheduledCheck;
+};
+
+/**
+  * \internal
+  * \brief A check waiting in a lane of the SchedulingAuthorityBackend
+  *
+  * It lives in the thread which asked for the check, so that the check is
+  * sent from there once it gets a slot.
+  */
+class ScheduledCheck : public QObject
+{
+    Q_OBJECT
+public:
+    ScheduledCheck(SchedulingAuthorityBackend *backend, AuthorityMetrics::Lane lane, const Subject &subject,
+                   const QByteArray &actionId, Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                   CheckAuthorizationCallback callback, void *userData);
+    ~ScheduledCheck();
+
+    AuthorityMetrics::Lane lane() const;
+    /** Returns the microseconds the check has been waiting */
+    qint64 waited() const;
+    /** Sends the check in the slot it got. Safe to call from any thread, the check deletes itself */
+    void startLater();
+
+private Q_SLOTS:
+    void start();
+    void cancel();
+
+private:
+    void disconnectCancellable();
+    static void cancelledCallback(GCancellable *cancellable, void *user_data);
+
+    SchedulingAuthorityBackend *m_backend;
+    AuthorityMetrics::Lane m_lane;
+    Subject m_subject;
+    QByteArray m_actionId;
+    Authority::AuthorizationFlags m_flags;
+    GCancellable *m_cancellable;
+    unsigned long m_cancelledHandler;
+    CheckAuthorizationCallback m_callback;
+    void *m_userData;
+    QElapsedTimer m_timer;
+};
+
+/**
+  * \internal
+  * \brief A check asked for while the authority is still being initialized
+  *
+  * It lives in the thread which asked for the check, so that the check is
+  * sent from there once the backend is known.
+  */
+class QueuedCheckAuthorization : public QObject
+{
+    Q_OBJECT
+public:
+    QueuedCheckAuthorization(const Subject &subject, const QByteArray &actionId,
+                             Authority::AuthorizationFlags flags, GCancellable *cancellable,
+                             CheckAuthorizationCallback callback, void *userData);
+    ~QueuedCheckAuthorization();
+
+    /** Sends the check to \p backend, or fails it if \p backend is \c NULL. Safe to call from any thread */
+    void startLater(AuthorityBackend *backend);
+
+private Q_SLOTS:
+    void start();
+
+private:
+    AuthorityBackend *m_backend;
+    Subject m_subject;
+    QByteArray m_actionId;
+    Authority::AuthorizationFlags m_flags;
+    GCancellable *m_cancellable;
+    CheckAuthorizationCallback m_callback;
+    void *m_userData;
+};
+
+}
+
+#endif
@@ -0,0 +1,461 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "polkitqt1-authoritymetrics_p.h"
+#include "polkitqt1-tracing_p.h"
+
+#include <QtCore/QTextStream>
+#include <QtCore/QVector>
+
+#include <math.h>
+
+POLKITQT1_SEMAPHORE(operation__start)
+POLKITQT1_SEMAPHORE(operation__done)
+
+namespace PolkitQt1
+{
+
+static const char *const operationNames[AuthorityMetrics::OperationCount] = {
+    "checkAuthorization",
+    "checkAuthorizationSync",
+    "checkAuthorizationAsync",
+    "checkAuthorizations",
+    "checkAuthorizationsSync",
+    "enumerateActions",
+    "enumerateActionsSync",
+    "registerAuthenticationAgent",
+    "registerAuthenticationAgentSync",
+    "unregisterAuthenticationAgent",
+    "unregisterAuthenticationAgentSync",
+    "authenticationAgentResponse",
+    "authenticationAgentResponseSync",
+    "enumerateTemporaryAuthorizations",
+    "enumerateTemporaryAuthorizationsSync",
+    "revokeTemporaryAuthorizations",
+    "revokeTemporaryAuthorizationsSync",
+    "revokeTemporaryAuthorization",
+    "revokeTemporaryAuthorizationSync",
+    "revokeTemporaryAuthorizationsBulk",
+    "enumerateActionsStreamed"
+};
+
+static const char *const laneNames[AuthorityMetrics::LaneCount] = {
+    "interactive",
+    "background"
+};
+
+struct OperationData
+{
+    OperationData()
+        : calls(0)
+        , errors(0)
+        , cancellations(0)
+        , latency(0)
+        , buckets(AuthorityMetrics::BucketCount, 0) {}
+
+    quint64 completed() const {
+        quint64 result = 0;
+        Q_FOREACH(quint64 count, buckets) {
+            result += count;
+        }
+        return result;
+    }
+
+    quint64 calls;
+    quint64 errors;
+    quint64 cancellations;
+    quint64 latency;
+    QVector<quint64> buckets;
+};
+
+struct LaneData
+{
+    LaneData()
+        : depth(0)
+        , maxDepth(0)
+        , inFlight(0)
+        , queued(0)
+        , queueTime(0) {}
+
+    quint64 depth;
+    quint64 maxDepth;
+    quint64 inFlight;
+    quint64 queued;
+    quint64 queueTime;
+};
+
+class AuthorityMetrics::Data : public QSharedData
+{
+public:
+    Data()
+        : operations(AuthorityMetrics::OperationCount)
+        , lanes(AuthorityMetrics::LaneCount) {}
+    Data(const Data &other)
+        : QSharedData(other)
+        , operations(other.operations)
+        , lanes(other.lanes)
+    {
+    }
+    ~Data() {}
+
+    QVector<OperationData> operations;
+    QVector<LaneData> lanes;
+};
+
+AuthorityMetrics::AuthorityMetrics()
+        : d(new Data)
+{
+}
+
+AuthorityMetrics::AuthorityMetrics(const AuthorityMetrics &other)
+        : d(other.d)
+{
+}
+
+AuthorityMetrics::~AuthorityMetrics()
+{
+}
+
+AuthorityMetrics &AuthorityMetrics::operator=(const AuthorityMetrics &other)
+{
+    d = other.d;
+    return *this;
+}
+
+QString AuthorityMetrics::operationName(Operation operation)
+{
+    if (operation < 0 || operation >= OperationCount) {
+        return QString();
+    }
+    return QString::fromLatin1(operationNames[operation]);
+}
+
+quint64 AuthorityMetrics::calls(Operation operation) const
+{
+    return d->operations.at(operation).calls;
+}
+
+quint64 AuthorityMetrics::completed(Operation operation) const
+{
+    return d->operations.at(operation).completed();
+}
+
+quint64 AuthorityMetrics::errors(Operation operation) const
+{
+    return d->operations.at(operation).errors;
+}
+
+quint64 AuthorityMetrics::cancellations(Operation operation) const
+{
+    return d->operations.at(operation).cancellations;
+}
+
+quint64 AuthorityMetrics::totalLatency(Operation operation) const
+{
+    return d->operations.at(operation).latency;
+}
+
+quint64 AuthorityMetrics::bucket(Operation operation, int index) const
+{
+    return d->operations.at(operation).buckets.at(index);
+}
+
+quint64 AuthorityMetrics::bucketUpperBound(int index)
+{
+    // buckets 0 to 3 hold one value each, then every power of two is split in four
+    if (index < 4) {
+        return index + 1;
+    }
+    const int exponent = index / 4 + 1;
+    return quint64(5 + index % 4) << (exponent - 2);
+}
+
+quint64 AuthorityMetrics::percentile(Operation operation, double quantile) const
+{
+    const OperationData &data = d->operations.at(operation);
+    const quint64 count = data.completed();
+    if (count == 0) {
+        return 0;
+    }
+
+    const quint64 rank = qMax(quint64(1), quint64(ceil(qBound(0.0, quantile, 1.0) * count)));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += data.buckets.at(i);
+        if (seen >= rank) {
+            return bucketUpperBound(i);
+        }
+    }
+    return bucketUpperBound(BucketCount - 1);
+}
+
+quint64 AuthorityMetrics::p50(Operation operation) const
+{
+    return percentile(operation, 0.5);
+}
+
+quint64 AuthorityMetrics::p99(Operation operation) const
+{
+    return percentile(operation, 0.99);
+}
+
+quint64 AuthorityMetrics::p999(Operation operation) const
+{
+    return percentile(operation, 0.999);
+}
+
+QString AuthorityMetrics::laneName(Lane lane)
+{
+    if (lane < 0 || lane >= LaneCount) {
+        return QString();
+    }
+    return QString::fromLatin1(laneNames[lane]);
+}
+
+quint64 AuthorityMetrics::queueDepth(Lane lane) const
+{
+    return d->lanes.at(lane).depth;
+}
+
+quint64 AuthorityMetrics::maxQueueDepth(Lane lane) const
+{
+    return d->lanes.at(lane).maxDepth;
+}
+
+quint64 AuthorityMetrics::checksInFlight(Lane lane) const
+{
+    return d->lanes.at(lane).inFlight;
+}
+
+quint64 AuthorityMetrics::queuedChecks(Lane lane) const
+{
+    return d->lanes.at(lane).queued;
+}
+
+quint64 AuthorityMetrics::totalQueueTime(Lane lane) const
+{
+    return d->lanes.at(lane).queueTime;
+}
+
+static QString seconds(quint64 usecs)
+{
+    return QString::number(usecs / 1000000.0, 'g', 12);
+}
+
+QString AuthorityMetrics::toPrometheusText() const
+{
+    QString result;
+    QTextStream stream(&result);
+
+    static const struct {
+        const char *name;
+        const char *help;
+        quint64 OperationData::*counter;
+    } counters[] = {
+        { "polkitqt1_operation_calls_total", "Operations started", &OperationData::calls },
+        { "polkitqt1_operation_errors_total", "Operations which failed", &OperationData::errors },
+        { "polkitqt1_operation_cancellations_total", "Operations which were cancelled", &OperationData::cancellations }
+    };
+
+    for (uint c = 0; c < sizeof(counters) / sizeof(counters[0]); ++c) {
+        stream << "# HELP " << counters[c].name << ' ' << counters[c].help << '\n';
+        stream << "# TYPE " << counters[c].name << " counter\n";
+        for (int i = 0; i < OperationCount; ++i) {
+            stream << counters[c].name << "{operation=\"" << operationNames[i] << "\"} "
+                   << d->operations.at(i).*counters[c].counter << '\n';
+        }
+    }
+
+    // only the power of two boundaries are exported, that is enough for a histogram
+    stream << "# HELP polkitqt1_operation_duration_seconds Latency of the finished operations\n";
+    stream << "# TYPE polkitqt1_operation_duration_seconds histogram\n";
+    for (int i = 0; i < OperationCount; ++i) {
+        const OperationData &data = d->operations.at(i);
+        quint64 cumulative = 0;
+        for (int b = 0; b < BucketCount; ++b) {
+            cumulative += data.buckets.at(b);
+            if (b % 4 == 3 && b != BucketCount - 1) {
+                // le is inclusive while our bounds are not, the latencies are whole microseconds
+                stream << "polkitqt1_operation_duration_seconds_bucket{operation=\"" << operationNames[i]
+                       << "\",le=\"" << seconds(bucketUpperBound(b) - 1) << "\"} " << cumulative << '\n';
+            }
+        }
+        stream << "polkitqt1_operation_duration_seconds_bucket{operation=\"" << operationNames[i]
+               << "\",le=\"+Inf\"} " << cumulative << '\n';
+        stream << "polkitqt1_operation_duration_seconds_sum{operation=\"" << operationNames[i]
+               << "\"} " << seconds(data.latency) << '\n';
+        stream << "polkitqt1_operation_duration_seconds_count{operation=\"" << operationNames[i]
+               << "\"} " << cumulative << '\n';
+    }
+
+    static const double quantiles[] = { 0.5, 0.99, 0.999 };
+    stream << "# HELP polkitqt1_operation_duration_quantile_seconds Latency percentiles of the finished operations\n";
+    stream << "# TYPE polkitqt1_operation_duration_quantile_seconds gauge\n";
+    for (int i = 0; i < OperationCount; ++i) {
+        for (uint q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); ++q) {
+            stream << "polkitqt1_operation_duration_quantile_seconds{operation=\"" << operationNames[i]
+                   << "\",quantile=\"" << quantiles[q] << "\"} "
+                   << seconds(percentile(Operation(i), quantiles[q])) << '\n';
+        }
+    }
+
+    static const struct {
+        const char *name;
+        const char *help;
+        const char *type;
+        quint64 LaneData::*value;
+    } lanes[] = {
+        { "polkitqt1_lane_queue_depth", "Checks waiting for a free slot", "gauge", &LaneData::depth },
+        { "polkitqt1_lane_queue_depth_max", "Most checks which waited for a free slot at the same time", "gauge",
+          &LaneData::maxDepth },
+        { "polkitqt1_lane_in_flight", "Checks sent to the authority and not answered yet", "gauge", &LaneData::inFlight },
+        { "polkitqt1_lane_queued_total", "Checks which had to wait for a free slot", "counter", &LaneData::queued }
+    };
+
+    for (uint l = 0; l < sizeof(lanes) / sizeof(lanes[0]); ++l) {
+        stream << "# HELP " << lanes[l].name << ' ' << lanes[l].help << '\n';
+        stream << "# TYPE " << lanes[l].name << ' ' << lanes[l].type << '\n';
+        for (int i = 0; i < LaneCount; ++i) {
+            stream << lanes[l].name << "{lane=\"" << laneNames[i] << "\"} " << d->lanes.at(i).*lanes[l].value << '\n';
+        }
+    }
+    stream << "# HELP polkitqt1_lane_queue_wait_seconds_total Time the checks spent waiting for a free slot\n";
+    stream << "# TYPE polkitqt1_lane_queue_wait_seconds_total counter\n";
+    for (int i = 0; i < LaneCount; ++i) {
+        stream << "polkitqt1_lane_queue_wait_seconds_total{lane=\"" << laneNames[i] << "\"} "
+               << seconds(d->lanes.at(i).queueTime) << '\n';
+    }
+
+    stream.flush();
+    return result;
+}
+
+int AuthorityMetricsRecorder::bucketIndex(quint64 usecs)
+{
+    if (usecs < 4) {
+        return int(usecs);
+    }
+
+    int exponent = 2;
+    while (exponent < 63 && (usecs >> (exponent + 1)) != 0) {
+        ++exponent;
+    }
+    const int index = 4 * (exponent - 1) + int((usecs >> (exponent - 2)) & 3);
+    return qMin(index, int(AuthorityMetrics::BucketCount) - 1);
+}
+
+const char *AuthorityMetricsRecorder::operationName(AuthorityMetrics::Operation operation)
+{
+    return operationNames[operation];
+}
+
+void AuthorityMetricsRecorder::started(AuthorityMetrics::Operation operation)
+{
+    POLKITQT1_TRACE1(operation__start, operationNames[operation]);
+    m_counters[operation].calls.fetchAndAddRelaxed(1);
+}
+
+void AuthorityMetricsRecorder::finished(AuthorityMetrics::Operation operation, qint64 usecs, Outcome outcome)
+{
+    Counters &counters = m_counters[operation];
+    const quint64 latency = usecs < 0 ? 0 : quint64(usecs);
+    POLKITQT1_TRACE3(operation__done, operationNames[operation], int(outcome), (long long) latency);
+
+    counters.latency.fetchAndAddRelaxed(latency);
+    counters.buckets[bucketIndex(latency)].fetchAndAddRelaxed(1);
+    if (outcome == Failed) {
+        counters.errors.fetchAndAddRelaxed(1);
+    } else if (outcome == Cancelled) {
+        counters.cancellations.fetchAndAddRelaxed(1);
+    }
+}
+
+void AuthorityMetricsRecorder::laneQueued(AuthorityMetrics::Lane lane, int depth)
+{
+    LaneCounters &counters = m_lanes[lane];
+    counters.queued.fetchAndAddRelaxed(1);
+    counters.depth.store(depth);
+
+    quint64 maxDepth = counters.maxDepth.load();
+    while (quint64(depth) > maxDepth && !counters.maxDepth.testAndSetRelaxed(maxDepth, depth)) {
+        maxDepth = counters.maxDepth.load();
+    }
+}
+
+void AuthorityMetricsRecorder::laneDequeued(AuthorityMetrics::Lane lane, int depth, qint64 usecs)
+{
+    LaneCounters &counters = m_lanes[lane];
+    counters.depth.store(depth);
+    counters.queueTime.fetchAndAddRelaxed(usecs < 0 ? 0 : quint64(usecs));
+}
+
+void AuthorityMetricsRecorder::laneInFlight(AuthorityMetrics::Lane lane, int inFlight)
+{
+    m_lanes[lane].inFlight.store(inFlight);
+}
+
+AuthorityMetrics AuthorityMetricsRecorder::snapshot() const
+{
+    AuthorityMetrics result;
+    for (int i = 0; i < AuthorityMetrics::OperationCount; ++i) {
+        const Counters &counters = m_counters[i];
+        OperationData &data = result.d->operations[i];
+        data.calls = counters.calls.load();
+        data.errors = counters.errors.load();
+        data.cancellations = counters.cancellations.load();
+        data.latency = counters.latency.load();
+        for (int b = 0; b < AuthorityMetrics::BucketCount; ++b) {
+            data.buckets[b] = counters.buckets[b].load();
+        }
+    }
+    for (int i = 0; i < AuthorityMetrics::LaneCount; ++i) {
+        const LaneCounters &counters = m_lanes[i];
+        LaneData &data = result.d->lanes[i];
+        data.depth = counters.depth.load();
+        data.maxDepth = counters.maxDepth.load();
+        data.inFlight = counters.inFlight.load();
+        data.queued = counters.queued.load();
+        data.queueTime = counters.queueTime.load();
+    }
+    return result;
+}
+
+void AuthorityMetricsRecorder::reset()
+{
+    for (int i = 0; i < AuthorityMetrics::OperationCount; ++i) {
+        Counters &counters = m_counters[i];
+        counters.calls.store(0);
+        counters.errors.store(0);
+        counters.cancellations.store(0);
+        counters.latency.store(0);
+        for (int b = 0; b < AuthorityMetrics::BucketCount; ++b) {
+            counters.buckets[b].store(0);
+        }
+    }
+    for (int i = 0; i < AuthorityMetrics::LaneCount; ++i) {
+        LaneCounters &counters = m_lanes[i];
+        counters.maxDepth.store(counters.depth.load());
+        counters.queued.store(0);
+        counters.queueTime.store(0);
+    }
+}
+
+}
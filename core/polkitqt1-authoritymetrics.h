@@ -0,0 +1,218 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_AUTHORITYMETRICS_H
+#define POLKITQT1_AUTHORITYMETRICS_H
+
+#include "polkitqt1-export.h"
+
+#include <QtCore/QMetaType>
+#include <QtCore/QSharedData>
+#include <QtCore/QString>
+
+namespace PolkitQt1
+{
+
+/**
+ * \class AuthorityMetrics polkitqt1-authoritymetrics.h AuthorityMetrics
+ *
+ * \brief Snapshot of the statistics Authority keeps about its operations
+ *
+ * Authority counts, for each of its operations, how many calls were started,
+ * how many failed and how many were cancelled, and records how long they
+ * took in a latency histogram. Recording is lock free and always enabled.
+ * Call Authority::metrics() to get a snapshot.
+ *
+ * Latencies are in microseconds. The histogram has four buckets per power
+ * of two, so percentiles are exact to within 25%.
+ */
+class POLKITQT1_EXPORT AuthorityMetrics
+{
+public:
+    /**
+     * The operations of Authority, asynchronous and synchronous variants apart
+     */
+    enum Operation {
+        CheckAuthorization = 0,
+        CheckAuthorizationSync,
+        CheckAuthorizationAsync,
+        CheckAuthorizations,
+        CheckAuthorizationsSync,
+        EnumerateActions,
+        EnumerateActionsSync,
+        RegisterAuthenticationAgent,
+        RegisterAuthenticationAgentSync,
+        UnregisterAuthenticationAgent,
+        UnregisterAuthenticationAgentSync,
+        AuthenticationAgentResponse,
+        AuthenticationAgentResponseSync,
+        EnumerateTemporaryAuthorizations,
+        EnumerateTemporaryAuthorizationsSync,
+        RevokeTemporaryAuthorizations,
+        RevokeTemporaryAuthorizationsSync,
+        RevokeTemporaryAuthorization,
+        RevokeTemporaryAuthorizationSync,
+        RevokeTemporaryAuthorizationsBulk,
+        EnumerateActionsStreamed,
+        OperationCount
+    };
+
+    /**
+     * The lanes authorization checks are scheduled in. Each lane has its own
+     * limit of checks in flight and its own queue.
+     *
+     * \see Authority::setInteractiveCheckLimit
+     * \see Authority::setBackgroundCheckLimit
+     */
+    enum Lane {
+        /** Checks allowing user interaction, which last as long as the user takes to authenticate */
+        InteractiveLane = 0,
+        /** Every other check */
+        BackgroundLane,
+        LaneCount
+    };
+
+    enum {
+        /** Number of buckets of the latency histograms */
+        BucketCount = 132
+    };
+
+    AuthorityMetrics();
+    AuthorityMetrics(const AuthorityMetrics &other);
+    ~AuthorityMetrics();
+
+    AuthorityMetrics &operator=(const AuthorityMetrics &other);
+
+    /**
+     * \return the name of \p operation, which is the name of the Authority method
+     */
+    static QString operationName(Operation operation);
+
+    /**
+     * \return the number of calls of \p operation which were started
+     */
+    quint64 calls(Operation operation) const;
+
+    /**
+     * \return the number of calls of \p operation which finished, whatever the outcome
+     */
+    quint64 completed(Operation operation) const;
+
+    /**
+     * \return the number of calls of \p operation which failed
+     */
+    quint64 errors(Operation operation) const;
+
+    /**
+     * \return the number of calls of \p operation which were cancelled
+     */
+    quint64 cancellations(Operation operation) const;
+
+    /**
+     * \return the sum of the latencies of the finished calls of \p operation, in microseconds
+     */
+    quint64 totalLatency(Operation operation) const;
+
+    /**
+     * \return the number of finished calls of \p operation whose latency fell in bucket \p index
+     */
+    quint64 bucket(Operation operation, int index) const;
+
+    /**
+     * \return the smallest latency, in microseconds, which falls after bucket \p index
+     */
+    static quint64 bucketUpperBound(int index);
+
+    /**
+     * Returns the latency under which the fraction \p quantile of the finished calls
+     * of \p operation completed, e.g. 0.99 for the 99th percentile.
+     *
+     * \return the latency in microseconds, 0 if no call finished
+     */
+    quint64 percentile(Operation operation, double quantile) const;
+
+    /**
+     * \return the median latency of \p operation, in microseconds
+     */
+    quint64 p50(Operation operation) const;
+
+    /**
+     * \return the 99th percentile of the latency of \p operation, in microseconds
+     */
+    quint64 p99(Operation operation) const;
+
+    /**
+     * \return the 99.9th percentile of the latency of \p operation, in microseconds
+     */
+    quint64 p999(Operation operation) const;
+
+    /**
+     * \return the name of \p lane, e.g. "interactive"
+     */
+    static QString laneName(Lane lane);
+
+    /**
+     * \return the number of checks of \p lane which were waiting for a free slot
+     */
+    quint64 queueDepth(Lane lane) const;
+
+    /**
+     * \return the highest number of checks of \p lane which were waiting at the same time
+     */
+    quint64 maxQueueDepth(Lane lane) const;
+
+    /**
+     * \return the number of checks of \p lane which were sent to the authority and not answered yet
+     */
+    quint64 checksInFlight(Lane lane) const;
+
+    /**
+     * \return the number of checks of \p lane which had to wait for a free slot
+     */
+    quint64 queuedChecks(Lane lane) const;
+
+    /**
+     * \return the time the checks of \p lane spent waiting for a free slot, in microseconds
+     */
+    quint64 totalQueueTime(Lane lane) const;
+
+    /**
+     * Dumps the metrics in the Prometheus text exposition format: counters
+     * for the calls, errors and cancellations, and a histogram plus the
+     * 50th, 99th and 99.9th percentiles of the latency of every operation,
+     * followed by the queue depths and waiting times of every lane.
+     *
+     * \return the metrics as plain text
+     */
+    QString toPrometheusText() const;
+
+private:
+    class Data;
+    QSharedDataPointer<Data> d;
+
+    friend class AuthorityMetricsRecorder;
+};
+
+}
+
+Q_DECLARE_METATYPE(PolkitQt1::AuthorityMetrics)
+
+#endif
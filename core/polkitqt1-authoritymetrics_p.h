@@ -0,0 +1,96 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_AUTHORITYMETRICS_P_H
+#define POLKITQT1_AUTHORITYMETRICS_P_H
+
+#include "polkitqt1-authoritymetrics.h"
+
+#include <QtCore/QAtomicInteger>
+
+namespace PolkitQt1
+{
+
+/**
+  * \internal
+  * \brief Lock free store behind AuthorityMetrics
+  *
+  * Every counter is a separate atomic, so recording never blocks. A snapshot
+  * taken while calls finish may be off by the calls in progress.
+  */
+class AuthorityMetricsRecorder
+{
+public:
+    enum Outcome {
+        Succeeded,
+        Failed,
+        Cancelled
+    };
+
+    AuthorityMetricsRecorder() {}
+
+    void started(AuthorityMetrics::Operation operation);
+    void finished(AuthorityMetrics::Operation operation, qint64 usecs, Outcome outcome);
+
+    /** Records that a check of \p lane started waiting, leaving \p depth checks in the queue */
+    void laneQueued(AuthorityMetrics::Lane lane, int depth);
+    /** Records that a check of \p lane left the queue after \p usecs microseconds, leaving \p depth checks */
+    void laneDequeued(AuthorityMetrics::Lane lane, int depth, qint64 usecs);
+    /** Records that \p inFlight checks of \p lane are now in flight */
+    void laneInFlight(AuthorityMetrics::Lane lane, int inFlight);
+
+    AuthorityMetrics snapshot() const;
+    void reset();
+
+    /** Returns the histogram bucket of a latency of \p usecs microseconds */
+    static int bucketIndex(quint64 usecs);
+    /** Returns the name of \p operation, as the tracepoints report it */
+    static const char *operationName(AuthorityMetrics::Operation operation);
+
+private:
+    Q_DISABLE_COPY(AuthorityMetricsRecorder)
+
+    struct Counters
+    {
+        QAtomicInteger<quint64> calls;
+        QAtomicInteger<quint64> errors;
+        QAtomicInteger<quint64> cancellations;
+        QAtomicInteger<quint64> latency;
+        QAtomicInteger<quint64> buckets[AuthorityMetrics::BucketCount];
+    };
+
+    // the depths are gauges, which reset() leaves alone
+    struct LaneCounters
+    {
+        QAtomicInteger<quint64> depth;
+        QAtomicInteger<quint64> maxDepth;
+        QAtomicInteger<quint64> inFlight;
+        QAtomicInteger<quint64> queued;
+        QAtomicInteger<quint64> queueTime;
+    };
+
+    Counters m_counters[AuthorityMetrics::OperationCount];
+    LaneCounters m_lanes[AuthorityMetrics::LaneCount];
+};
+
+}
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "polkitqt1-authorizationmatrix.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QPair>
+#include <QtCore/QVector>
+
+namespace PolkitQt1
+{
+
+// 2 bits per cell, so that every Authority::Result fits
+static const int CellsPerWord = 16;
+
+class AuthorizationMatrix::Data : public QSharedData
+{
+public:
+    Data()
+        : rows(0)
+        , columns(0)
+        , elapsed(0)
+    {}
+    Data(const Data &other)
+        : QSharedData(other)
+        , actionIds(other.actionIds)
+        , subjects(other.subjects)
+        , rows(other.rows)
+        , columns(other.columns)
+        , cells(other.cells)
+        , errors(other.errors)
+        , elapsed(other.elapsed)
+    {
+    }
+    ~Data() {}
+
+    int index(int row, int column) const {
+        Q_ASSERT(row >= 0 && row < rows);
+        Q_ASSERT(column >= 0 && column < columns);
+        return row * columns + column;
+    }
+
+    QStringList actionIds;
+    QList<Subject> subjects;
+    int rows;
+    int columns;
+    QVector<quint32> cells;
+    // cell index -> error, only for the cells which failed
+    QHash<int, QPair<Authority::ErrorCode, QString> > errors;
+    qint64 elapsed;
+};
+
+AuthorizationMatrix::AuthorizationMatrix()
+        : d(new Data)
+{
+}
+
+AuthorizationMatrix::AuthorizationMatrix(const QStringList &actionIds, const QList<Subject> &subjects)
+        : d(new Data)
+{
+    d->actionIds = actionIds;
+    d->subjects = subjects;
+    d->rows = actionIds.size();
+    d->columns = subjects.size();
+    // Authority::Unknown is 0, so a zeroed vector is a matrix of unknown results
+    d->cells.fill(0, (d->rows * d->columns + CellsPerWord - 1) / CellsPerWord);
+}
+
+AuthorizationMatrix::AuthorizationMatrix(const AuthorizationMatrix &other)
+        : d(other.d)
+{
+}
+
+AuthorizationMatrix::~AuthorizationMatrix()
+{
+}
+
+AuthorizationMatrix &AuthorizationMatrix::operator=(const AuthorizationMatrix &other)
+{
+    d = other.d;
+    return *this;
+}
+
+QStringList AuthorizationMatrix::actionIds() const
+{
+    return d->actionIds;
+}
+
+QList<Subject> AuthorizationMatrix::subjects() const
+{
+    return d->subjects;
+}
+
+int AuthorizationMatrix::rowCount() const
+{
+    return d->rows;
+}
+
+int AuthorizationMatrix::columnCount() const
+{
+    return d->columns;
+}
+
+Authority::Result AuthorizationMatrix::result(int row, int column) const
+{
+    const int i = d->index(row, column);
+    return static_cast<Authority::Result>((d->cells.at(i / CellsPerWord) >> ((i % CellsPerWord) * 2)) & 0x3);
+}
+
+Authority::Result AuthorizationMatrix::result(const QString &actionId, int column) const
+{
+    const int row = d->actionIds.indexOf(actionId);
+    if (row < 0) {
+        return Authority::Unknown;
+    }
+
+    return result(row, column);
+}
+
+void AuthorizationMatrix::setResult(int row, int column, Authority::Result result)
+{
+    const int i = d->index(row, column);
+    const int shift = (i % CellsPerWord) * 2;
+    quint32 &word = d->cells[i / CellsPerWord];
+    word = (word & ~(quint32(0x3) << shift)) | ((quint32(result) & 0x3) << shift);
+}
+
+bool AuthorizationMatrix::hasError(int row, int column) const
+{
+    return d->errors.contains(d->index(row, column));
+}
+
+Authority::ErrorCode AuthorizationMatrix::error(int row, int column) const
+{
+    return d->errors.value(d->index(row, column), qMakePair(Authority::E_None, QString())).first;
+}
+
+QString AuthorizationMatrix::errorDetails(int row, int column) const
+{
+    return d->errors.value(d->index(row, column)).second;
+}
+
+void AuthorizationMatrix::setError(int row, int column, Authority::ErrorCode code, const QString &details)
+{
+    setResult(row, column, Authority::Unknown);
+    d->errors.insert(d->index(row, column), qMakePair(code, details));
+}
+
+int AuthorizationMatrix::errorCount() const
+{
+    return d->errors.size();
+}
+
+qint64 AuthorizationMatrix::elapsed() const
+{
+    return d->elapsed;
+}
+
+void AuthorizationMatrix::setElapsed(qint64 msecs)
+{
+    d->elapsed = msecs;
+}
+
+}
@@ -0,0 +1,145 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef POLKITQT1_AUTHORIZATIONMATRIX_H
+#define POLKITQT1_AUTHORIZATIONMATRIX_H
+
+#include "polkitqt1-export.h"
+#include "polkitqt1-authority.h"
+#include "polkitqt1-subject.h"
+
+#include <QtCore/QList>
+#include <QtCore/QMetaType>
+#include <QtCore/QSharedData>
+#include <QtCore/QStringList>
+
+namespace PolkitQt1
+{
+
+/**
+ * \class AuthorizationMatrix polkitqt1-authorizationmatrix.h AuthorizationMatrix
+ *
+ * \brief Results of a bulk authorization check
+ *
+ * An AuthorizationMatrix holds the outcome of checking every action in a
+ * list of action ids against every subject in a list of subjects. Rows are
+ * actions and columns are subjects, in the order they were passed to
+ * Authority::checkAuthorizationsSync() or Authority::checkAuthorizations().
+ *
+ * Results are packed in two bits per cell. Errors are stored separately and
+ * only for the cells which actually failed; a failed cell always has the
+ * result \c Authority::Unknown.
+ */
+class POLKITQT1_EXPORT AuthorizationMatrix
+{
+public:
+    AuthorizationMatrix();
+    /**
+     * Creates a matrix for \p actionIds and \p subjects with every cell set
+     * to \c Authority::Unknown.
+     */
+    AuthorizationMatrix(const QStringList &actionIds, const QList<Subject> &subjects);
+    AuthorizationMatrix(const AuthorizationMatrix &other);
+    ~AuthorizationMatrix();
+
+    AuthorizationMatrix &operator=(const AuthorizationMatrix &other);
+
+    /**
+     * \return the action ids, i.e. the row headers
+     */
+    QStringList actionIds() const;
+
+    /**
+     * \return the subjects, i.e. the column headers
+     */
+    QList<Subject> subjects() const;
+
+    /**
+     * \return the number of actions
+     */
+    int rowCount() const;
+
+    /**
+     * \return the number of subjects
+     */
+    int columnCount() const;
+
+    /**
+     * \return the result for the action in \p row and the subject in \p column
+     */
+    Authority::Result result(int row, int column) const;
+
+    /**
+     * \return the result for \p actionId and the subject in \p column, or
+     *         \c Authority::Unknown if \p actionId is not part of the matrix
+     */
+    Authority::Result result(const QString &actionId, int column = 0) const;
+
+    /**
+     * Sets the result for the action in \p row and the subject in \p column.
+     */
+    void setResult(int row, int column, Authority::Result result);
+
+    /**
+     * \return \c true if the check for \p row and \p column failed
+     */
+    bool hasError(int row, int column) const;
+
+    /**
+     * \return the code of the error the check for \p row and \p column failed with
+     */
+    Authority::ErrorCode error(int row, int column) const;
+
+    /**
+     * \return detail message of the error the check for \p row and \p column failed with
+     */
+    QString errorDetails(int row, int column) const;
+
+    /**
+     * Marks the check for \p row and \p column as failed and resets its result
+     * to \c Authority::Unknown.
+     */
+    void setError(int row, int column, Authority::ErrorCode code, const QString &details = QString());
+
+    /**
+     * \return the number of cells whose check failed
+     */
+    int errorCount() const;
+
+    /**
+     * \return the number of milliseconds the whole bulk check took
+     */
+    qint64 elapsed() const;
+
+    /**
+     * Sets the number of milliseconds the whole bulk check took.
+     */
+    void setElapsed(qint64 msecs);
+
+private:
+    class Data;
+    QSharedDataPointer< Data > d;
+};
+
+}
+
+Q_DECLARE_METATYPE(PolkitQt1::AuthorizationMatrix)
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "polkitqt1-authorizationwatch.h"
+#include "polkitqt1-pendingauthorization.h"
+
+#include <QtCore/QPair>
+
+namespace PolkitQt1
+{
+
+class AuthorizationWatch::Private
+{
+public:
+    Private(AuthorizationWatch *qq)
+        : q(qq)
+        , authority(0)
+        , pending(0)
+        , stale(false)
+        , ready(false) {}
+
+    void checksFinished(PendingAuthorizationMatrix *request);
+
+    AuthorizationWatch *q;
+    Authority *authority;
+    QStringList actionIds;
+    QList<Subject> subjects;
+    AuthorizationMatrix matrix;
+    // the running bulk check, and whether a change came in since it started
+    PendingAuthorizationMatrix *pending;
+    bool stale;
+    bool ready;
+};
+
+void AuthorizationWatch::Private::checksFinished(PendingAuthorizationMatrix *request)
+{
+    pending = 0;
+    request->deleteLater();
+    if (stale) {
+        // the results may predate the last change
+        q->refresh();
+        return;
+    }
+
+    const AuthorizationMatrix fresh = request->matrix();
+    QList<QPair<int, int> > changes;
+    for (int row = 0; row < fresh.rowCount(); ++row) {
+        for (int column = 0; column < fresh.columnCount(); ++column) {
+            if (fresh.hasError(row, column) || fresh.result(row, column) == matrix.result(row, column)) {
+                continue;
+            }
+            matrix.setResult(row, column, fresh.result(row, column));
+            changes.append(qMakePair(row, column));
+        }
+    }
+    matrix.setElapsed(fresh.elapsed());
+
+    const bool first = !ready;
+    ready = true;
+    for (int i = 0; i < changes.size(); ++i) {
+        const int row = changes.at(i).first;
+        const int column = changes.at(i).second;
+        Q_EMIT q->resultChanged(actionIds.at(row), column, matrix.result(row, column));
+    }
+    if (first || !changes.isEmpty()) {
+        Q_EMIT q->changed(q);
+    }
+}
+
+AuthorizationWatch::AuthorizationWatch(Authority *authority, const QStringList &actionIds,
+                                       const QList<Subject> &subjects, QObject *parent)
+        : QObject(parent)
+        , d(new Private(this))
+{
+    d->authority = authority;
+    d->actionIds = actionIds;
+    d->subjects = subjects;
+    d->matrix = AuthorizationMatrix(actionIds, subjects);
+
+    // changed() comes once for a burst of polkit and ConsoleKit changes
+    connect(authority, SIGNAL(changed(quint64)), this, SLOT(refresh()));
+    refresh();
+}
+
+AuthorizationWatch::~AuthorizationWatch()
+{
+    // cancels the running check
+    delete d->pending;
+    delete d;
+}
+
+QStringList AuthorizationWatch::actionIds() const
+{
+    return d->actionIds;
+}
+
+QList<Subject> AuthorizationWatch::subjects() const
+{
+    return d->subjects;
+}
+
+AuthorizationMatrix AuthorizationWatch::matrix() const
+{
+    return d->matrix;
+}
+
+bool AuthorizationWatch::isReady() const
+{
+    return d->ready;
+}
+
+void AuthorizationWatch::refresh()
+{
+    if (d->pending != 0) {
+        d->stale = true;
+        return;
+    }
+
+    d->stale = false;
+    d->pending = d->authority->checkAuthorizations(d->actionIds, d->subjects, Authority::None, this);
+    connect(d->pending, SIGNAL(finished(PolkitQt1::PendingAuthorizationMatrix*)),
+            this, SLOT(checksFinished(PolkitQt1::PendingAuthorizationMatrix*)));
+}
+
+}
+
+#include "moc_polkitqt1-authorizationwatch.cpp"
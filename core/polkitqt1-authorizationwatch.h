@@ -0,0 +1,123 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_AUTHORIZATIONWATCH_H
+#define POLKITQT1_AUTHORIZATIONWATCH_H
+
+#include "polkitqt1-export.h"
+#include "polkitqt1-authority.h"
+#include "polkitqt1-authorizationmatrix.h"
+#include "polkitqt1-subject.h"
+
+#include <QtCore/QObject>
+
+namespace PolkitQt1
+{
+
+class PendingAuthorizationMatrix;
+
+/**
+ * \class AuthorizationWatch polkitqt1-authorizationwatch.h AuthorizationWatch
+ *
+ * \brief Keeps the results of a set of authorization checks up to date
+ *
+ * Returned by Authority::watchAuthorizations(). The watch checks every action
+ * against every subject, like Authority::checkAuthorizations(), and checks
+ * them all again in one bulk check whenever Authority emits changed(). Only
+ * the results which actually changed are reported, so there is no need to
+ * check everything again, or to repaint, on every configChanged() or
+ * consoleKitDBChanged().
+ *
+ * The results start as \c Authority::Unknown. A check which fails keeps the
+ * last result known for its cell, so that a polkitd restart does not show up
+ * as a change.
+ *
+ * The watch is owned by the caller: delete it to stop watching.
+ *
+ * \see Authority::watchAuthorizations
+ */
+class POLKITQT1_EXPORT AuthorizationWatch : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(AuthorizationWatch)
+public:
+    ~AuthorizationWatch();
+
+    /**
+     * \return the watched action ids, i.e. the rows of the matrix
+     */
+    QStringList actionIds() const;
+
+    /**
+     * \return the watched subjects, i.e. the columns of the matrix
+     */
+    QList<Subject> subjects() const;
+
+    /**
+     * \return the last known results
+     */
+    AuthorizationMatrix matrix() const;
+
+    /**
+     * \return \c true once the results have been checked for the first time
+     */
+    bool isReady() const;
+
+public Q_SLOTS:
+    /**
+     * Checks all the results again, as if Authority had emitted changed().
+     */
+    void refresh();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted for every result which changed.
+     *
+     * \param actionId the action whose result changed
+     * \param column the column of the subject in matrix()
+     * \param result the new result
+     */
+    void resultChanged(const QString &actionId, int column, PolkitQt1::Authority::Result result);
+
+    /**
+     * This signal is emitted once the results have been checked for the first
+     * time, and then once after every check which changed at least one result,
+     * after all the resultChanged() signals.
+     *
+     * \param watch the watch whose results changed, i.e. this object
+     */
+    void changed(PolkitQt1::AuthorizationWatch *watch);
+
+private:
+    AuthorizationWatch(Authority *authority, const QStringList &actionIds, const QList<Subject> &subjects,
+                       QObject *parent = 0);
+
+    class Private;
+    friend class Private;
+    friend class Authority;
+    Private * const d;
+
+    Q_PRIVATE_SLOT(d, void checksFinished(PolkitQt1::PendingAuthorizationMatrix *request))
+};
+
+}
+
+#endif
@@ -0,0 +1,200 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "polkitqt1-deadline_p.h"
+
+#include <QtCore/QMultiMap>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QThread>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QWaitCondition>
+
+#include <gio/gio.h>
+
+namespace PolkitQt1
+{
+
+/**
+  * \internal
+  * \brief Thread cancelling the cancellables of the deadlines which expired
+  *
+  * The operations bound by a deadline block their own thread, so nothing but
+  * another thread can interrupt them.
+  */
+class DeadlineWatchdog : public QThread
+{
+public:
+    DeadlineWatchdog();
+    ~DeadlineWatchdog();
+
+    void watch(const Deadline *deadline, int msec);
+    void unwatch(const Deadline *deadline);
+
+protected:
+    void run();
+
+private:
+    struct Entry {
+        const Deadline *deadline;
+        GCancellable *cancellable;
+    };
+
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QElapsedTimer m_clock;
+    // by due time, in msecs of m_clock
+    QMultiMap<qint64, Entry> m_entries;
+    bool m_quit;
+};
+
+Q_GLOBAL_STATIC(DeadlineWatchdog, s_watchdog)
+
+// The deadlines of a thread form a stack, whose top is the current one
+struct DeadlineStack
+{
+    DeadlineStack() : current(0) {}
+
+    const Deadline *current;
+};
+
+static QThreadStorage<DeadlineStack> s_deadlines;
+
+DeadlineWatchdog::DeadlineWatchdog()
+        : m_quit(false)
+{
+    m_clock.start();
+}
+
+DeadlineWatchdog::~DeadlineWatchdog()
+{
+    m_mutex.lock();
+    m_quit = true;
+    m_condition.wakeOne();
+    m_mutex.unlock();
+    wait();
+
+    Q_FOREACH(const Entry &entry, m_entries) {
+        g_object_unref(entry.cancellable);
+    }
+}
+
+void DeadlineWatchdog::watch(const Deadline *deadline, int msec)
+{
+    QMutexLocker locker(&m_mutex);
+    Entry entry;
+    entry.deadline = deadline;
+    // the deadline may be gone by the time it is cancelled
+    entry.cancellable = (GCancellable *) g_object_ref(deadline->cancellable());
+    m_entries.insert(m_clock.elapsed() + msec, entry);
+    m_condition.wakeOne();
+
+    if (!isRunning()) {
+        start();
+    }
+}
+
+void DeadlineWatchdog::unwatch(const Deadline *deadline)
+{
+    QMutexLocker locker(&m_mutex);
+    QMultiMap<qint64, Entry>::iterator it = m_entries.begin();
+    while (it != m_entries.end()) {
+        if (it.value().deadline == deadline) {
+            g_object_unref(it.value().cancellable);
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DeadlineWatchdog::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        if (m_entries.isEmpty()) {
+            m_condition.wait(&m_mutex);
+            continue;
+        }
+
+        const qint64 due = m_entries.begin().key();
+        const qint64 now = m_clock.elapsed();
+        if (due > now) {
+            m_condition.wait(&m_mutex, due - now);
+            continue;
+        }
+
+        GCancellable *cancellable = m_entries.begin().value().cancellable;
+        m_entries.erase(m_entries.begin());
+        // the cancelled handlers may take locks of their own
+        locker.unlock();
+        g_cancellable_cancel(cancellable);
+        g_object_unref(cancellable);
+        locker.relock();
+    }
+}
+
+Deadline::Deadline(int msec)
+        : m_cancellable(g_cancellable_new())
+        , m_msec(msec)
+        , m_previous(0)
+{
+    m_timer.start();
+    if (m_msec >= 0) {
+        m_previous = s_deadlines.localData().current;
+        s_deadlines.localData().current = this;
+        s_watchdog()->watch(this, m_msec);
+    }
+}
+
+Deadline::~Deadline()
+{
+    if (m_msec >= 0) {
+        s_deadlines.localData().current = m_previous;
+        s_watchdog()->unwatch(this);
+    }
+    g_object_unref(m_cancellable);
+}
+
+GCancellable *Deadline::cancellable() const
+{
+    return m_cancellable;
+}
+
+bool Deadline::hasExpired() const
+{
+    return m_msec >= 0 && m_timer.elapsed() >= m_msec;
+}
+
+int Deadline::remaining() const
+{
+    if (m_msec < 0) {
+        return -1;
+    }
+    return int(qMax<qint64>(0, m_msec - m_timer.elapsed()));
+}
+
+const Deadline *Deadline::current()
+{
+    return s_deadlines.localData().current;
+}
+
+}
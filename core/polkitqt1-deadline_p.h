@@ -0,0 +1,69 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_DEADLINE_P_H
+#define POLKITQT1_DEADLINE_P_H
+
+#include <QtCore/QElapsedTimer>
+
+typedef struct _GCancellable GCancellable;
+
+namespace PolkitQt1
+{
+
+/**
+  * \internal
+  * \brief Time limit of a blocking operation
+  *
+  * The cancellable of the deadline is cancelled by a watchdog thread once the
+  * time is up, which makes the GIO calls using it return. While it exists, the
+  * deadline is the current() one of the thread which created it, so that the
+  * backends can bound their own waits too.
+  */
+class Deadline
+{
+public:
+    /** Starts a deadline of \p msec milliseconds, or none at all if \p msec is negative */
+    explicit Deadline(int msec);
+    ~Deadline();
+
+    /** The cancellable to pass to the calls bound by this deadline */
+    GCancellable *cancellable() const;
+    /** Returns \c true once the time is up */
+    bool hasExpired() const;
+    /** Returns the milliseconds left, or -1 if there is no time limit */
+    int remaining() const;
+
+    /** Returns the innermost deadline of the calling thread which has a time limit, or \c NULL */
+    static const Deadline *current();
+
+private:
+    Q_DISABLE_COPY(Deadline)
+
+    GCancellable *m_cancellable;
+    int m_msec;
+    QElapsedTimer m_timer;
+    const Deadline *m_previous;
+};
+
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "polkitqt1-fakeauthoritybackend_p.h"
+
+#include <QtCore/QMutexLocker>
+
+namespace PolkitQt1
+{
+
+CheckAuthorizationReply FakeAuthorityBackend::Private::answer(const QString &actionId)
+{
+    CheckAuthorizationReply reply;
+
+    QMutexLocker locker(&mutex);
+    ++checkCount;
+    if (failNextCount > 0) {
+        --failNextCount;
+        reply.error = failNextError;
+        reply.errorDetails = failNextDetails;
+    } else if (failures.contains(actionId)) {
+        const Failure &failure = failures[actionId];
+        reply.error = failure.error;
+        reply.errorDetails = failure.details;
+    } else {
+        reply.result = results.value(actionId, defaultResult);
+    }
+    return reply;
+}
+
+FakeAuthorityBackend::FakeAuthorityBackend(QObject *parent)
+        : QObject(parent)
+        , d(new Private)
+{
+}
+
+FakeAuthorityBackend::~FakeAuthorityBackend()
+{
+    delete d;
+}
+
+void FakeAuthorityBackend::setDefaultResult(Authority::Result result)
+{
+    QMutexLocker locker(&d->mutex);
+    d->defaultResult = result;
+}
+
+Authority::Result FakeAuthorityBackend::defaultResult() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->defaultResult;
+}
+
+void FakeAuthorityBackend::setResult(const QString &actionId, Authority::Result result)
+{
+    QMutexLocker locker(&d->mutex);
+    d->results.insert(actionId, result);
+}
+
+Authority::Result FakeAuthorityBackend::result(const QString &actionId) const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->results.value(actionId, d->defaultResult);
+}
+
+void FakeAuthorityBackend::setFailure(const QString &actionId, Authority::ErrorCode error, const QString &details)
+{
+    QMutexLocker locker(&d->mutex);
+    if (error == Authority::E_None) {
+        d->failures.remove(actionId);
+    } else {
+        Private::Failure failure;
+        failure.error = error;
+        failure.details = details;
+        d->failures.insert(actionId, failure);
+    }
+}
+
+void FakeAuthorityBackend::failNextChecks(int count, Authority::ErrorCode error, const QString &details)
+{
+    QMutexLocker locker(&d->mutex);
+    d->failNextCount = count;
+    d->failNextError = error;
+    d->failNextDetails = details;
+}
+
+void FakeAuthorityBackend::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->results.clear();
+    d->failures.clear();
+    d->failNextCount = 0;
+}
+
+void FakeAuthorityBackend::setLatency(int msec)
+{
+    QMutexLocker locker(&d->mutex);
+    d->latency = qMax(0, msec);
+}
+
+int FakeAuthorityBackend::latency() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->latency;
+}
+
+quint64 FakeAuthorityBackend::checkCount() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->checkCount;
+}
+
+void FakeAuthorityBackend::changeConfig()
+{
+    Q_EMIT configChanged();
+}
+
+void FakeAuthorityBackend::addSeat(const QString &seat)
+{
+    Q_EMIT seatAdded(seat);
+}
+
+void FakeAuthorityBackend::removeSeat(const QString &seat)
+{
+    Q_EMIT seatRemoved(seat);
+}
+
+void FakeAuthorityBackend::addSession(const QString &seat, const QString &session)
+{
+    Q_EMIT sessionAdded(seat, session);
+}
+
+void FakeAuthorityBackend::removeSession(const QString &seat, const QString &session)
+{
+    Q_EMIT sessionRemoved(seat, session);
+}
+
+void FakeAuthorityBackend::activateSession(const QString &seat, const QString &session)
+{
+    Q_EMIT activeSessionChanged(seat, session);
+}
+
+}
+
+#include "moc_polkitqt1-fakeauthoritybackend.cpp"
@@ -0,0 +1,190 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_FAKEAUTHORITYBACKEND_H
+#define POLKITQT1_FAKEAUTHORITYBACKEND_H
+
+#include "polkitqt1-export.h"
+#include "polkitqt1-authority.h"
+
+#include <QtCore/QObject>
+
+namespace PolkitQt1
+{
+
+/**
+ * \class FakeAuthorityBackend polkitqt1-fakeauthoritybackend.h FakeAuthorityBackend
+ *
+ * \brief In-process stand-in for polkitd
+ *
+ * Once installed with Authority::setFakeBackend(), the Authority answers every
+ * authorization check from this object instead of asking polkitd, without any
+ * D-Bus traffic. This makes it possible to test code built on Authority, like
+ * Gui::Action, and to measure the overhead of the library itself.
+ *
+ * Results are deterministic: an action answers with the result given to
+ * setResult(), or with defaultResult(). Failures can be injected per action
+ * with setFailure() or for the next checks with failNextChecks(), and every
+ * answer can be delayed with setLatency(). The slots changeConfig(),
+ * addSeat() and so on make the Authority react as if polkitd or ConsoleKit
+ * had reported the change.
+ *
+ * All the methods are thread safe. Only checks go through the fake: the
+ * other operations of Authority fail with Authority::E_GetAuthority.
+ *
+ * \note The fake has to outlive the Authority it is installed in.
+ */
+class POLKITQT1_EXPORT FakeAuthorityBackend : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(FakeAuthorityBackend)
+public:
+    explicit FakeAuthorityBackend(QObject *parent = 0);
+    ~FakeAuthorityBackend();
+
+    /**
+     * Sets the result of the actions which have none of their own.
+     * It is \c Authority::No by default.
+     */
+    void setDefaultResult(Authority::Result result);
+
+    /**
+     * \return the result of the actions which have none of their own
+     */
+    Authority::Result defaultResult() const;
+
+    /**
+     * Makes every check of \p actionId answer \p result
+     */
+    void setResult(const QString &actionId, Authority::Result result);
+
+    /**
+     * \return the result checks of \p actionId answer when they do not fail
+     */
+    Authority::Result result(const QString &actionId) const;
+
+    /**
+     * Makes every check of \p actionId fail with \p error and \p details,
+     * or succeed again if \p error is \c Authority::E_None
+     */
+    void setFailure(const QString &actionId, Authority::ErrorCode error, const QString &details = QString());
+
+    /**
+     * Makes the next \p count checks fail with \p error and \p details,
+     * whatever their action
+     */
+    void failNextChecks(int count, Authority::ErrorCode error = Authority::E_CheckFailed,
+                        const QString &details = QString());
+
+    /**
+     * Forgets all the results and failures set so far
+     */
+    void clear();
+
+    /**
+     * Delays every answer by \p msec milliseconds. With no latency, the
+     * answers of asynchronous checks still come from the event loop.
+     */
+    void setLatency(int msec);
+
+    /**
+     * \return the latency of the answers, in milliseconds
+     */
+    int latency() const;
+
+    /**
+     * \return the number of checks the fake was asked so far
+     */
+    quint64 checkCount() const;
+
+public Q_SLOTS:
+    /**
+     * Reports a change of the polkit configuration, as polkitd does when
+     * policies or rules change
+     */
+    void changeConfig();
+
+    /**
+     * Reports that \p seat appeared, as ConsoleKit does
+     */
+    void addSeat(const QString &seat);
+
+    /**
+     * Reports that \p seat went away, as ConsoleKit does
+     */
+    void removeSeat(const QString &seat);
+
+    /**
+     * Reports that \p session was opened on \p seat, as ConsoleKit does
+     */
+    void addSession(const QString &seat, const QString &session);
+
+    /**
+     * Reports that \p session was closed on \p seat, as ConsoleKit does
+     */
+    void removeSession(const QString &seat, const QString &session);
+
+    /**
+     * Reports that \p session became the active one of \p seat, as ConsoleKit does
+     */
+    void activateSession(const QString &seat, const QString &session);
+
+Q_SIGNALS:
+    /**
+     * Emitted by changeConfig()
+     */
+    void configChanged();
+
+    /**
+     * Emitted by addSeat()
+     */
+    void seatAdded(const QString &seat);
+
+    /**
+     * Emitted by removeSeat()
+     */
+    void seatRemoved(const QString &seat);
+
+    /**
+     * Emitted by addSession()
+     */
+    void sessionAdded(const QString &seat, const QString &session);
+
+    /**
+     * Emitted by removeSession()
+     */
+    void sessionRemoved(const QString &seat, const QString &session);
+
+    /**
+     * Emitted by activateSession()
+     */
+    void activeSessionChanged(const QString &seat, const QString &session);
+
+private:
+    class Private;
+    friend class Private;
+    friend class InProcessAuthorityBackend;
+    Private * const d;
+};
+
+}
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_FAKEAUTHORITYBACKEND_P_H
+#define POLKITQT1_FAKEAUTHORITYBACKEND_P_H
+
+#include "polkitqt1-fakeauthoritybackend.h"
+#include "polkitqt1-authoritybackend_p.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+
+/**
+  * \internal
+  */
+class PolkitQt1::FakeAuthorityBackend::Private
+{
+public:
+    Private()
+        : defaultResult(Authority::No)
+        , failNextCount(0)
+        , failNextError(Authority::E_None)
+        , latency(0)
+        , checkCount(0) {}
+
+    struct Failure {
+        Authority::ErrorCode error;
+        QString details;
+    };
+
+    /** Counts a check of \p actionId and returns its scripted answer */
+    CheckAuthorizationReply answer(const QString &actionId);
+
+    mutable QMutex mutex;
+    Authority::Result defaultResult;
+    QHash<QString, Authority::Result> results;
+    QHash<QString, Failure> failures;
+    int failNextCount;
+    Authority::ErrorCode failNextError;
+    QString failNextDetails;
+    int latency;
+    quint64 checkCount;
+};
+
+#endif
@@ -0,0 +1,204 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "polkitqt1-pendingactions_p.h"
+
+#include <QtCore/QMetaObject>
+#include <QtCore/QPointer>
+
+#include <polkit/polkit.h>
+
+namespace PolkitQt1
+{
+
+PendingActions::Private::Private(PendingActions *qq)
+        : q(qq)
+        , id(0)
+        , chunkSize(1)
+        , count(0)
+        , actions(NULL)
+        , next(NULL)
+        , error(Authority::E_None)
+        , finished(false)
+        , cancelled(false)
+        , elapsed(0)
+        , cancellable(g_cancellable_new())
+{
+    timer.start();
+}
+
+PendingActions::Private::~Private()
+{
+    freeActions();
+    g_object_unref(cancellable);
+}
+
+void PendingActions::Private::freeActions()
+{
+    for (GList *glist = next; glist != NULL; glist = g_list_next(glist)) {
+        g_object_unref(glist->data);
+    }
+    g_list_free(actions);
+    actions = NULL;
+    next = NULL;
+}
+
+void PendingActions::Private::deliver(GList *list)
+{
+    actions = list;
+    next = list;
+    QMetaObject::invokeMethod(q, "deliverChunk", Qt::QueuedConnection);
+}
+
+void PendingActions::Private::failLater(Authority::ErrorCode code, const QString &details)
+{
+    error = code;
+    errorDetails = details;
+    QMetaObject::invokeMethod(q, "emitFinished", Qt::QueuedConnection);
+}
+
+void PendingActions::Private::deliverChunk()
+{
+    if (finished) {
+        return;
+    }
+    if (cancelled) {
+        freeActions();
+        emitFinished();
+        return;
+    }
+
+    ActionDescription::List chunk;
+    chunk.reserve(chunkSize);
+    for (; next != NULL && chunk.size() < chunkSize; next = g_list_next(next)) {
+        chunk.append(ActionDescription(static_cast<PolkitActionDescription *>(next->data)));
+        g_object_unref(next->data);
+    }
+    count += chunk.size();
+
+    const bool last = next == NULL;
+    if (!last) {
+        // the next chunk waits for the events which came in meanwhile
+        QMetaObject::invokeMethod(q, "deliverChunk", Qt::QueuedConnection);
+    }
+
+    if (!chunk.isEmpty()) {
+        // a receiver may delete the request
+        QPointer<PendingActions> guard(q);
+        Q_EMIT q->actionsReady(chunk);
+        if (guard.isNull()) {
+            return;
+        }
+    }
+
+    if (last) {
+        freeActions();
+        emitFinished();
+    }
+}
+
+void PendingActions::Private::emitFinished()
+{
+    if (finished) {
+        return;
+    }
+
+    finished = true;
+    elapsed = timer.elapsed();
+    Q_EMIT q->finished(q);
+}
+
+PendingActions::PendingActions(quint64 id, int chunkSize, QObject *parent)
+        : QObject(parent)
+        , d(new Private(this))
+{
+    d->id = id;
+    d->chunkSize = qMax(chunkSize, 1);
+}
+
+PendingActions::~PendingActions()
+{
+    if (!d->finished) {
+        g_cancellable_cancel(d->cancellable);
+    }
+
+    delete d;
+}
+
+quint64 PendingActions::id() const
+{
+    return d->id;
+}
+
+int PendingActions::chunkSize() const
+{
+    return d->chunkSize;
+}
+
+int PendingActions::count() const
+{
+    return d->count;
+}
+
+bool PendingActions::isFinished() const
+{
+    return d->finished;
+}
+
+bool PendingActions::isCancelled() const
+{
+    return d->cancelled;
+}
+
+bool PendingActions::hasError() const
+{
+    return d->error != Authority::E_None;
+}
+
+Authority::ErrorCode PendingActions::error() const
+{
+    return d->error;
+}
+
+QString PendingActions::errorDetails() const
+{
+    return d->errorDetails;
+}
+
+qint64 PendingActions::elapsed() const
+{
+    return d->finished ? d->elapsed : d->timer.elapsed();
+}
+
+void PendingActions::cancel()
+{
+    if (d->finished || d->cancelled) {
+        return;
+    }
+
+    // the reply, or the next chunk, notices it
+    d->cancelled = true;
+    g_cancellable_cancel(d->cancellable);
+}
+
+}
+
+#include "moc_polkitqt1-pendingactions.cpp"
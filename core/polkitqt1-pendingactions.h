@@ -0,0 +1,143 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_PENDINGACTIONS_H
+#define POLKITQT1_PENDINGACTIONS_H
+
+#include "polkitqt1-export.h"
+#include "polkitqt1-authority.h"
+#include "polkitqt1-actiondescription.h"
+
+#include <QtCore/QObject>
+
+namespace PolkitQt1
+{
+
+/**
+ * \class PendingActions polkitqt1-pendingactions.h PendingActions
+ *
+ * \brief Handle of an asynchronous enumeration of the actions, delivered in chunks
+ *
+ * Returned by Authority::enumerateActionsStreamed(). Once polkitd has replied,
+ * the actions are converted and handed out through actionsReady() at most
+ * chunkSize() at a time, one chunk per iteration of the event loop of the
+ * thread the handle lives in, so that views can start showing them and the
+ * thread never blocks on the whole list. finished() is emitted after the last
+ * chunk, or when the enumeration fails or is cancelled.
+ *
+ * The handle is owned by the caller. Deleting a handle which has not finished
+ * yet cancels the enumeration, and the actions which were not delivered yet
+ * are never converted.
+ *
+ * \see Authority::enumerateActionsStreamed
+ */
+class POLKITQT1_EXPORT PendingActions : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(PendingActions)
+public:
+    ~PendingActions();
+
+    /**
+     * \return a number identifying this request, unique within the process
+     */
+    quint64 id() const;
+
+    /**
+     * \return the maximum number of actions delivered by each actionsReady()
+     */
+    int chunkSize() const;
+
+    /**
+     * \return the number of actions delivered so far
+     */
+    int count() const;
+
+    /**
+     * \return \c true once finished() has been emitted
+     */
+    bool isFinished() const;
+
+    /**
+     * \return \c true if the enumeration was cancelled before all the actions
+     *         were delivered
+     */
+    bool isCancelled() const;
+
+    /**
+     * \return \c true if the enumeration failed
+     */
+    bool hasError() const;
+
+    /**
+     * \return the code of the error the enumeration failed with
+     */
+    Authority::ErrorCode error() const;
+
+    /**
+     * \return detail message of the error the enumeration failed with
+     */
+    QString errorDetails() const;
+
+    /**
+     * \return the number of milliseconds the whole enumeration took, or the
+     *         number of milliseconds elapsed so far if it is still running
+     */
+    qint64 elapsed() const;
+
+public Q_SLOTS:
+    /**
+     * Cancels the enumeration, and stops delivering actions. finished() is
+     * still emitted, with isCancelled() returning \c true.
+     */
+    void cancel();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted for every chunk of actions.
+     *
+     * \param actions the next chunkSize() actions, or fewer for the last chunk
+     */
+    void actionsReady(const PolkitQt1::ActionDescription::List &actions);
+
+    /**
+     * This signal is emitted after the last chunk, or when the enumeration
+     * fails or is cancelled.
+     *
+     * \param request the request that finished, i.e. this object
+     */
+    void finished(PolkitQt1::PendingActions *request);
+
+private:
+    PendingActions(quint64 id, int chunkSize, QObject *parent = 0);
+
+    class Private;
+    friend class Private;
+    friend class Authority;
+    Private * const d;
+
+    Q_PRIVATE_SLOT(d, void deliverChunk())
+    Q_PRIVATE_SLOT(d, void emitFinished())
+};
+
+}
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_PENDINGACTIONS_P_H
+#define POLKITQT1_PENDINGACTIONS_P_H
+
+#include "polkitqt1-pendingactions.h"
+
+#include <QtCore/QElapsedTimer>
+
+typedef struct _GCancellable GCancellable;
+typedef struct _GList GList;
+
+/**
+  * \internal
+  */
+class PolkitQt1::PendingActions::Private
+{
+public:
+    Private(PendingActions *qq);
+    ~Private();
+
+    /** Takes \p actions, and starts delivering them from the event loop */
+    void deliver(GList *actions);
+    /** Stores the error and emits finished() from the event loop */
+    void failLater(Authority::ErrorCode code, const QString &details);
+    void deliverChunk();
+    void emitFinished();
+    /** Drops the actions which were not delivered */
+    void freeActions();
+
+    PendingActions *q;
+    quint64 id;
+    int chunkSize;
+    int count;
+    // the reply, and the first action not delivered yet
+    GList *actions;
+    GList *next;
+    Authority::ErrorCode error;
+    QString errorDetails;
+    bool finished;
+    bool cancelled;
+    QElapsedTimer timer;
+    qint64 elapsed;
+    GCancellable *cancellable;
+};
+
+#endif
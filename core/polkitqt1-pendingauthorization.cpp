@@ -0,0 +1,261 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "polkitqt1-pendingauthorization_p.h"
+
+#include <QtCore/QMetaObject>
+
+#include <polkit/polkit.h>
+
+namespace PolkitQt1
+{
+
+PendingAuthorization::Private::Private(PendingAuthorization *qq)
+        : q(qq)
+        , id(0)
+        , result(Authority::Unknown)
+        , error(Authority::E_None)
+        , finished(false)
+        , cancelled(false)
+        , elapsed(0)
+        , cancellable(g_cancellable_new())
+{
+    timer.start();
+}
+
+PendingAuthorization::Private::~Private()
+{
+    g_object_unref(cancellable);
+}
+
+void PendingAuthorization::Private::finish(Authority::Result res, Authority::ErrorCode code, const QString &details)
+{
+    result = res;
+    error = code;
+    errorDetails = details;
+    emitFinished();
+}
+
+void PendingAuthorization::Private::finishLater(Authority::Result res, Authority::ErrorCode code, const QString &details)
+{
+    result = res;
+    error = code;
+    errorDetails = details;
+    QMetaObject::invokeMethod(q, "emitFinished", Qt::QueuedConnection);
+}
+
+void PendingAuthorization::Private::emitFinished()
+{
+    if (finished) {
+        return;
+    }
+
+    if (cancelled) {
+        result = Authority::Unknown;
+        error = Authority::E_None;
+        errorDetails.clear();
+    }
+
+    finished = true;
+    elapsed = timer.elapsed();
+    Q_EMIT q->finished(q);
+}
+
+PendingAuthorization::PendingAuthorization(quint64 id, const QString &actionId, const Subject &subject,
+                                           Authority::AuthorizationFlags flags, QObject *parent)
+        : QObject(parent)
+        , d(new Private(this))
+{
+    d->id = id;
+    d->actionId = actionId;
+    d->subject = subject;
+    d->flags = flags;
+}
+
+PendingAuthorization::~PendingAuthorization()
+{
+    if (!d->finished) {
+        g_cancellable_cancel(d->cancellable);
+    }
+
+    delete d;
+}
+
+quint64 PendingAuthorization::id() const
+{
+    return d->id;
+}
+
+QString PendingAuthorization::actionId() const
+{
+    return d->actionId;
+}
+
+Subject PendingAuthorization::subject() const
+{
+    return d->subject;
+}
+
+Authority::AuthorizationFlags PendingAuthorization::flags() const
+{
+    return d->flags;
+}
+
+bool PendingAuthorization::isFinished() const
+{
+    return d->finished;
+}
+
+bool PendingAuthorization::isCancelled() const
+{
+    return d->cancelled;
+}
+
+Authority::Result PendingAuthorization::result() const
+{
+    return d->result;
+}
+
+bool PendingAuthorization::hasError() const
+{
+    return d->error != Authority::E_None;
+}
+
+Authority::ErrorCode PendingAuthorization::error() const
+{
+    return d->error;
+}
+
+QString PendingAuthorization::errorDetails() const
+{
+    return d->errorDetails;
+}
+
+qint64 PendingAuthorization::elapsed() const
+{
+    return d->finished ? d->elapsed : d->timer.elapsed();
+}
+
+void PendingAuthorization::cancel()
+{
+    if (d->finished || d->cancelled) {
+        return;
+    }
+
+    d->cancelled = true;
+    // the pending callback will see the cancellation and emit finished()
+    g_cancellable_cancel(d->cancellable);
+}
+
+
+PendingAuthorizationMatrix::Private::Private(PendingAuthorizationMatrix *qq)
+        : q(qq)
+        , id(0)
+        , finished(false)
+        , cancelled(false)
+        , elapsed(0)
+        , cancellable(g_cancellable_new())
+{
+    timer.start();
+}
+
+PendingAuthorizationMatrix::Private::~Private()
+{
+    g_object_unref(cancellable);
+}
+
+void PendingAuthorizationMatrix::Private::finish(const AuthorizationMatrix &m)
+{
+    matrix = m;
+    emitFinished();
+}
+
+void PendingAuthorizationMatrix::Private::finishLater(const AuthorizationMatrix &m)
+{
+    matrix = m;
+    QMetaObject::invokeMethod(q, "emitFinished", Qt::QueuedConnection);
+}
+
+void PendingAuthorizationMatrix::Private::emitFinished()
+{
+    if (finished) {
+        return;
+    }
+
+    finished = true;
+    elapsed = timer.elapsed();
+    Q_EMIT q->finished(q);
+}
+
+PendingAuthorizationMatrix::PendingAuthorizationMatrix(quint64 id, const AuthorizationMatrix &matrix, QObject *parent)
+        : QObject(parent)
+        , d(new Private(this))
+{
+    d->id = id;
+    d->matrix = matrix;
+}
+
+PendingAuthorizationMatrix::~PendingAuthorizationMatrix()
+{
+    if (!d->finished) {
+        g_cancellable_cancel(d->cancellable);
+    }
+
+    delete d;
+}
+
+quint64 PendingAuthorizationMatrix::id() const
+{
+    return d->id;
+}
+
+AuthorizationMatrix PendingAuthorizationMatrix::matrix() const
+{
+    return d->matrix;
+}
+
+bool PendingAuthorizationMatrix::isFinished() const
+{
+    return d->finished;
+}
+
+bool PendingAuthorizationMatrix::isCancelled() const
+{
+    return d->cancelled;
+}
+
+qint64 PendingAuthorizationMatrix::elapsed() const
+{
+    return d->finished ? d->elapsed : d->timer.elapsed();
+}
+
+void PendingAuthorizationMatrix::cancel()
+{
+    if (d->finished || d->cancelled) {
+        return;
+    }
+
+    d->cancelled = true;
+    g_cancellable_cancel(d->cancellable);
+}
+
+}
+
+#include "moc_polkitqt1-pendingauthorization.cpp"
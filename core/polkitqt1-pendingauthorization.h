@@ -0,0 +1,217 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef POLKITQT1_PENDINGAUTHORIZATION_H
+#define POLKITQT1_PENDINGAUTHORIZATION_H
+
+#include "polkitqt1-export.h"
+#include "polkitqt1-authority.h"
+#include "polkitqt1-authorizationmatrix.h"
+#include "polkitqt1-subject.h"
+
+#include <QtCore/QObject>
+
+namespace PolkitQt1
+{
+
+/**
+ * \class PendingAuthorization polkitqt1-pendingauthorization.h PendingAuthorization
+ *
+ * \brief Handle of a single asynchronous authorization check
+ *
+ * Every call to Authority::checkAuthorizationAsync() returns a new
+ * PendingAuthorization. Each handle has its own cancellable, result, error
+ * and timing, so any number of checks can be in flight at the same time and
+ * every reply can be matched to the request it answers.
+ *
+ * The finished() signal is emitted exactly once, when the check completes,
+ * fails or is cancelled. The handle is owned by the caller: delete it (or
+ * call deleteLater()) once you are done with it. Deleting a handle which
+ * has not finished yet cancels the check.
+ *
+ * \see Authority::checkAuthorizationAsync
+ */
+class POLKITQT1_EXPORT PendingAuthorization : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(PendingAuthorization)
+public:
+    ~PendingAuthorization();
+
+    /**
+     * \return a number identifying this request, unique within the process
+     */
+    quint64 id() const;
+
+    /**
+     * \return the action id this check was issued for
+     */
+    QString actionId() const;
+
+    /**
+     * \return the subject this check was issued for
+     */
+    Subject subject() const;
+
+    /**
+     * \return the flags this check was issued with
+     */
+    Authority::AuthorizationFlags flags() const;
+
+    /**
+     * \return \c true once finished() has been emitted
+     */
+    bool isFinished() const;
+
+    /**
+     * \return \c true if the check was cancelled before it completed
+     */
+    bool isCancelled() const;
+
+    /**
+     * \return the result of the check, or \c Authority::Unknown if the check
+     *         has not finished yet, failed or was cancelled
+     */
+    Authority::Result result() const;
+
+    /**
+     * \return \c true if the check failed
+     */
+    bool hasError() const;
+
+    /**
+     * \return the code of the error the check failed with
+     */
+    Authority::ErrorCode error() const;
+
+    /**
+     * \return detail message of the error the check failed with
+     */
+    QString errorDetails() const;
+
+    /**
+     * \return the number of milliseconds the check took, or the number of
+     *         milliseconds elapsed so far if it is still running
+     */
+    qint64 elapsed() const;
+
+public Q_SLOTS:
+    /**
+     * Cancels the check. finished() is still emitted, with isCancelled()
+     * returning \c true.
+     */
+    void cancel();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when the check completes, fails or is cancelled.
+     *
+     * \param request the request that finished, i.e. this object
+     */
+    void finished(PolkitQt1::PendingAuthorization *request);
+
+private:
+    PendingAuthorization(quint64 id, const QString &actionId, const Subject &subject,
+                         Authority::AuthorizationFlags flags, QObject *parent = 0);
+
+    class Private;
+    friend class Private;
+    friend class Authority;
+    Private * const d;
+
+    Q_PRIVATE_SLOT(d, void emitFinished())
+};
+
+/**
+ * \class PendingAuthorizationMatrix polkitqt1-pendingauthorization.h PendingAuthorization
+ *
+ * \brief Handle of an asynchronous bulk authorization check
+ *
+ * Returned by Authority::checkAuthorizations(). The finished() signal is emitted
+ * once every cell of the matrix has been checked, or once the check has been
+ * cancelled and the calls already sent to the authority have returned.
+ *
+ * The handle is owned by the caller. Deleting a handle which has not finished
+ * yet cancels the check.
+ *
+ * \see Authority::checkAuthorizations
+ */
+class POLKITQT1_EXPORT PendingAuthorizationMatrix : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(PendingAuthorizationMatrix)
+public:
+    ~PendingAuthorizationMatrix();
+
+    /**
+     * \return a number identifying this request, unique within the process
+     */
+    quint64 id() const;
+
+    /**
+     * \return the results gathered so far; complete once finished() was emitted
+     */
+    AuthorizationMatrix matrix() const;
+
+    /**
+     * \return \c true once finished() has been emitted
+     */
+    bool isFinished() const;
+
+    /**
+     * \return \c true if the check was cancelled before it completed. Cells which
+     *         were not checked yet hold \c Authority::Unknown.
+     */
+    bool isCancelled() const;
+
+    /**
+     * \return the number of milliseconds the check took, or the number of
+     *         milliseconds elapsed so far if it is still running
+     */
+    qint64 elapsed() const;
+
+public Q_SLOTS:
+    /**
+     * Cancels the checks which did not complete yet.
+     */
+    void cancel();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when the bulk check completes or is cancelled.
+     *
+     * \param request the request that finished, i.e. this object
+     */
+    void finished(PolkitQt1::PendingAuthorizationMatrix *request);
+
+private:
+    PendingAuthorizationMatrix(quint64 id, const AuthorizationMatrix &matrix, QObject *parent = 0);
+
+    class Private;
+    friend class Private;
+    friend class Authority;
+    Private * const d;
+
+    Q_PRIVATE_SLOT(d, void emitFinished())
+};
+
+}
+
+#endif
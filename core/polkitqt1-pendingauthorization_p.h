@@ -0,0 +1,87 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef POLKITQT1_PENDINGAUTHORIZATION_P_H
+#define POLKITQT1_PENDINGAUTHORIZATION_P_H
+
+#include "polkitqt1-pendingauthorization.h"
+
+#include <QtCore/QElapsedTimer>
+
+typedef struct _GCancellable GCancellable;
+
+/**
+  * \internal
+  */
+class PolkitQt1::PendingAuthorization::Private
+{
+public:
+    Private(PendingAuthorization *qq);
+    ~Private();
+
+    /** Stores the outcome and emits finished() right away */
+    void finish(Authority::Result res, Authority::ErrorCode code = Authority::E_None,
+                const QString &details = QString());
+    /** Stores the outcome and emits finished() from the event loop */
+    void finishLater(Authority::Result res, Authority::ErrorCode code = Authority::E_None,
+                     const QString &details = QString());
+    void emitFinished();
+
+    PendingAuthorization *q;
+    quint64 id;
+    QString actionId;
+    Subject subject;
+    Authority::AuthorizationFlags flags;
+    Authority::Result result;
+    Authority::ErrorCode error;
+    QString errorDetails;
+    bool finished;
+    bool cancelled;
+    QElapsedTimer timer;
+    qint64 elapsed;
+    GCancellable *cancellable;
+};
+
+/**
+  * \internal
+  */
+class PolkitQt1::PendingAuthorizationMatrix::Private
+{
+public:
+    Private(PendingAuthorizationMatrix *qq);
+    ~Private();
+
+    /** Stores the matrix and emits finished() right away */
+    void finish(const AuthorizationMatrix &m);
+    /** Stores the matrix and emits finished() from the event loop */
+    void finishLater(const AuthorizationMatrix &m);
+    void emitFinished();
+
+    PendingAuthorizationMatrix *q;
+    quint64 id;
+    AuthorizationMatrix matrix;
+    bool finished;
+    bool cancelled;
+    QElapsedTimer timer;
+    qint64 elapsed;
+    GCancellable *cancellable;
+};
+
+#endif
@@ -0,0 +1,174 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "polkitqt1-pendingrevocation_p.h"
+
+#include <QtCore/QMetaObject>
+
+#include <polkit/polkit.h>
+
+namespace PolkitQt1
+{
+
+PendingRevocation::Private::Private(PendingRevocation *qq)
+        : q(qq)
+        , id(0)
+        , finished(false)
+        , cancelled(false)
+        , elapsed(0)
+        , cancellable(g_cancellable_new())
+{
+    timer.start();
+}
+
+PendingRevocation::Private::~Private()
+{
+    g_object_unref(cancellable);
+}
+
+void PendingRevocation::Private::finish(const QVector<RevocationResult> &r)
+{
+    results = r;
+    emitFinished();
+}
+
+void PendingRevocation::Private::finishLater(const QVector<RevocationResult> &r)
+{
+    results = r;
+    QMetaObject::invokeMethod(q, "emitFinished", Qt::QueuedConnection);
+}
+
+void PendingRevocation::Private::emitFinished()
+{
+    if (finished) {
+        return;
+    }
+
+    finished = true;
+    elapsed = timer.elapsed();
+    Q_EMIT q->finished(q);
+}
+
+PendingRevocation::PendingRevocation(quint64 id, const QStringList &ids, const QList<Subject> &subjects,
+                                     QObject *parent)
+        : QObject(parent)
+        , d(new Private(this))
+{
+    d->id = id;
+    d->ids = ids;
+    d->subjects = subjects;
+    d->results.resize(ids.size() + subjects.size());
+}
+
+PendingRevocation::~PendingRevocation()
+{
+    if (!d->finished) {
+        g_cancellable_cancel(d->cancellable);
+    }
+
+    delete d;
+}
+
+quint64 PendingRevocation::id() const
+{
+    return d->id;
+}
+
+int PendingRevocation::count() const
+{
+    return d->results.size();
+}
+
+QStringList PendingRevocation::ids() const
+{
+    return d->ids;
+}
+
+QList<Subject> PendingRevocation::subjects() const
+{
+    return d->subjects;
+}
+
+bool PendingRevocation::isRevoked(int index) const
+{
+    return d->results.value(index).revoked;
+}
+
+Authority::ErrorCode PendingRevocation::error(int index) const
+{
+    return d->results.value(index).error;
+}
+
+QString PendingRevocation::errorDetails(int index) const
+{
+    return d->results.value(index).errorDetails;
+}
+
+int PendingRevocation::revokedCount() const
+{
+    int count = 0;
+    Q_FOREACH(const RevocationResult &result, d->results) {
+        if (result.revoked) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+int PendingRevocation::errorCount() const
+{
+    int count = 0;
+    Q_FOREACH(const RevocationResult &result, d->results) {
+        if (result.error != Authority::E_None) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool PendingRevocation::isFinished() const
+{
+    return d->finished;
+}
+
+bool PendingRevocation::isCancelled() const
+{
+    return d->cancelled;
+}
+
+qint64 PendingRevocation::elapsed() const
+{
+    return d->finished ? d->elapsed : d->timer.elapsed();
+}
+
+void PendingRevocation::cancel()
+{
+    if (d->finished || d->cancelled) {
+        return;
+    }
+
+    d->cancelled = true;
+    g_cancellable_cancel(d->cancellable);
+}
+
+}
+
+#include "moc_polkitqt1-pendingrevocation.cpp"
@@ -0,0 +1,152 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_PENDINGREVOCATION_H
+#define POLKITQT1_PENDINGREVOCATION_H
+
+#include "polkitqt1-export.h"
+#include "polkitqt1-authority.h"
+#include "polkitqt1-subject.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+
+namespace PolkitQt1
+{
+
+/**
+ * \class PendingRevocation polkitqt1-pendingrevocation.h PendingRevocation
+ *
+ * \brief Handle of an asynchronous bulk revocation of temporary authorizations
+ *
+ * Returned by Authority::revokeTemporaryAuthorizationsById() and
+ * Authority::revokeTemporaryAuthorizations(). The items, either ids or
+ * subjects, are revoked with up to Authority::bulkCheckWindow() calls in
+ * flight, and every item gets its own result. The finished() signal is emitted
+ * once every item has been handled, or once the revocation has been cancelled
+ * and the calls already sent to the authority have returned.
+ *
+ * The handle is owned by the caller. Deleting a handle which has not finished
+ * yet cancels the revocation.
+ *
+ * \see Authority::revokeTemporaryAuthorizationsById
+ * \see Authority::revokeTemporaryAuthorizations
+ */
+class POLKITQT1_EXPORT PendingRevocation : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(PendingRevocation)
+public:
+    ~PendingRevocation();
+
+    /**
+     * \return a number identifying this request, unique within the process
+     */
+    quint64 id() const;
+
+    /**
+     * \return the number of items to revoke
+     */
+    int count() const;
+
+    /**
+     * \return the ids of the temporary authorizations to revoke, empty if
+     *         revoking by subject
+     */
+    QStringList ids() const;
+
+    /**
+     * \return the subjects whose temporary authorizations are revoked, empty
+     *         if revoking by id
+     */
+    QList<Subject> subjects() const;
+
+    /**
+     * \return \c true if the item at \p index was revoked
+     */
+    bool isRevoked(int index) const;
+
+    /**
+     * \return the code of the error revoking the item at \p index failed with,
+     *         \c Authority::E_None if it did not fail
+     */
+    Authority::ErrorCode error(int index) const;
+
+    /**
+     * \return detail message of the error revoking the item at \p index failed with
+     */
+    QString errorDetails(int index) const;
+
+    /**
+     * \return the number of items revoked so far
+     */
+    int revokedCount() const;
+
+    /**
+     * \return the number of items which failed so far
+     */
+    int errorCount() const;
+
+    /**
+     * \return \c true once finished() has been emitted
+     */
+    bool isFinished() const;
+
+    /**
+     * \return \c true if the revocation was cancelled before it completed. The
+     *         items which were not revoked yet are neither revoked nor failed.
+     */
+    bool isCancelled() const;
+
+    /**
+     * \return the number of milliseconds the whole revocation took, or the
+     *         number of milliseconds elapsed so far if it is still running
+     */
+    qint64 elapsed() const;
+
+public Q_SLOTS:
+    /**
+     * Cancels the items which were not revoked yet.
+     */
+    void cancel();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when the revocation completes or is cancelled.
+     *
+     * \param request the request that finished, i.e. this object
+     */
+    void finished(PolkitQt1::PendingRevocation *request);
+
+private:
+    PendingRevocation(quint64 id, const QStringList &ids, const QList<Subject> &subjects, QObject *parent = 0);
+
+    class Private;
+    friend class Private;
+    friend class Authority;
+    Private * const d;
+
+    Q_PRIVATE_SLOT(d, void emitFinished())
+};
+
+}
+
+#endif
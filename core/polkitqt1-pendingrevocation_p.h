@@ -0,0 +1,77 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_PENDINGREVOCATION_P_H
+#define POLKITQT1_PENDINGREVOCATION_P_H
+
+#include "polkitqt1-pendingrevocation.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QVector>
+
+typedef struct _GCancellable GCancellable;
+
+namespace PolkitQt1
+{
+
+/**
+  * \internal
+  * \brief The outcome of revoking one item
+  */
+struct RevocationResult
+{
+    RevocationResult() : revoked(false), error(Authority::E_None) {}
+
+    bool revoked;
+    Authority::ErrorCode error;
+    QString errorDetails;
+};
+
+}
+
+/**
+  * \internal
+  */
+class PolkitQt1::PendingRevocation::Private
+{
+public:
+    Private(PendingRevocation *qq);
+    ~Private();
+
+    /** Stores the results and emits finished() right away */
+    void finish(const QVector<RevocationResult> &r);
+    /** Stores the results and emits finished() from the event loop */
+    void finishLater(const QVector<RevocationResult> &r);
+    void emitFinished();
+
+    PendingRevocation *q;
+    quint64 id;
+    QStringList ids;
+    QList<Subject> subjects;
+    QVector<RevocationResult> results;
+    bool finished;
+    bool cancelled;
+    QElapsedTimer timer;
+    qint64 elapsed;
+    GCancellable *cancellable;
+};
+
+#endif
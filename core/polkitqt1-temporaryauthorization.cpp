@@ -54,10 +54,10 @@ TemporaryAuthorization::TemporaryAuthorization(PolkitTemporaryAuthorization *pkT
     g_type_init();
     d->id = QString::fromUtf8(polkit_temporary_authorization_get_id(pkTemporaryAuthorization));
     d->actionId = QString::fromUtf8(polkit_temporary_authorization_get_action_id(pkTemporaryAuthorization));
-    d->subject = Subject::fromString(polkit_subject_to_string(polkit_temporary_authorization_get_subject(pkTemporaryAuthorization)));
+    // the subject comes with a reference of its own, which Subject takes over
+    d->subject = Subject(polkit_temporary_authorization_get_subject(pkTemporaryAuthorization));
     d->timeObtained = QDateTime::fromTime_t(polkit_temporary_authorization_get_time_obtained(pkTemporaryAuthorization));
     d->timeExpires = QDateTime::fromTime_t(polkit_temporary_authorization_get_time_expires(pkTemporaryAuthorization));
-    g_object_unref(pkTemporaryAuthorization);
 }
 
 TemporaryAuthorization::TemporaryAuthorization(const PolkitQt1::TemporaryAuthorization& other)
@@ -58,7 +58,8 @@ public:
      *
      * \warning It shouldn't be used directly unless you are completely aware of what are you doing
      *
-     * \param pkTemporaryAuthorization PolkitTemporaryAuthorization object
+     * \param pkTemporaryAuthorization PolkitTemporaryAuthorization object, which the caller keeps
+     *        its reference to
      * \param parent
      */
     explicit TemporaryAuthorization(PolkitTemporaryAuthorization *pkTemporaryAuthorization);
@@ -119,6 +120,7 @@ private:
 };
 }
 
+Q_DECLARE_METATYPE(PolkitQt1::TemporaryAuthorization)
 Q_DECLARE_METATYPE(PolkitQt1::TemporaryAuthorization::List)
 
 #endif // TEMPORARYAUTHORIZATION_H
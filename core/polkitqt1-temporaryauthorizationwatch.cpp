@@ -0,0 +1,263 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "polkitqt1-temporaryauthorizationwatch.h"
+
+#include <QtCore/QPointer>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
+#include <QtCore/QtAlgorithms>
+
+#include <polkit/polkit.h>
+
+namespace PolkitQt1
+{
+
+// A listing in flight; the watch may be deleted before it finishes
+struct TemporaryAuthorizationListing
+{
+    QPointer<TemporaryAuthorizationWatch> watch;
+};
+
+static bool expiresBefore(const TemporaryAuthorization &a, const TemporaryAuthorization &b)
+{
+    return a.expirationTime() < b.expirationTime();
+}
+
+class TemporaryAuthorizationWatch::Private
+{
+public:
+    Private(TemporaryAuthorizationWatch *qq)
+        : q(qq)
+        , authority(0)
+        , cancellable(NULL)
+        , expiryTimer(0)
+        , stale(false)
+        , ready(false) {}
+
+    /** Merges a fresh listing of the temporary authorizations, \p ok is \c false if it failed */
+    void listed(const TemporaryAuthorization::List &fresh, bool ok);
+    void expire();
+    /** Starts the expiry timer for the authorization expiring first */
+    void scheduleExpiry();
+
+    static void listCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+
+    TemporaryAuthorizationWatch *q;
+    Authority *authority;
+    Subject subject;
+    // sorted by expiration time
+    TemporaryAuthorization::List authorizations;
+    // set while a listing runs
+    GCancellable *cancellable;
+    QTimer *expiryTimer;
+    // whether a change came in since the running listing started
+    bool stale;
+    bool ready;
+};
+
+void TemporaryAuthorizationWatch::Private::listCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    QScopedPointer<TemporaryAuthorizationListing> listing((TemporaryAuthorizationListing *) user_data);
+    GError *error = NULL;
+
+    GList *glist = polkit_authority_enumerate_temporary_authorizations_finish((PolkitAuthority *) object, result, &error);
+    TemporaryAuthorization::List fresh;
+    for (GList *glist2 = glist; glist2 != NULL; glist2 = g_list_next(glist2)) {
+        fresh.append(TemporaryAuthorization((PolkitTemporaryAuthorization *) glist2->data));
+        g_object_unref(glist2->data);
+    }
+    g_list_free(glist);
+
+    if (!listing->watch.isNull()) {
+        listing->watch->d->listed(fresh, error == NULL);
+    }
+    if (error != NULL) {
+        g_error_free(error);
+    }
+}
+
+void TemporaryAuthorizationWatch::Private::listed(const TemporaryAuthorization::List &fresh, bool ok)
+{
+    g_object_unref(cancellable);
+    cancellable = NULL;
+    if (stale) {
+        // the listing may predate the last change
+        q->refresh();
+        return;
+    }
+    if (!ok) {
+        // keep what we know, a polkitd restart is not a change
+        return;
+    }
+
+    const QDateTime now = QDateTime::currentDateTime();
+    TemporaryAuthorization::List current;
+    QSet<QString> currentIds;
+    Q_FOREACH (const TemporaryAuthorization &authorization, fresh) {
+        if (authorization.expirationTime() > now) {
+            current.append(authorization);
+            currentIds.insert(authorization.id());
+        }
+    }
+    qSort(current.begin(), current.end(), expiresBefore);
+
+    QSet<QString> knownIds;
+    QStringList removedIds;
+    QStringList expiredIds;
+    Q_FOREACH (const TemporaryAuthorization &authorization, authorizations) {
+        knownIds.insert(authorization.id());
+        if (currentIds.contains(authorization.id())) {
+            continue;
+        }
+        if (authorization.expirationTime() <= now) {
+            expiredIds.append(authorization.id());
+        } else {
+            removedIds.append(authorization.id());
+        }
+    }
+    TemporaryAuthorization::List added;
+    Q_FOREACH (const TemporaryAuthorization &authorization, current) {
+        if (!knownIds.contains(authorization.id())) {
+            added.append(authorization);
+        }
+    }
+
+    authorizations = current;
+    scheduleExpiry();
+
+    const bool first = !ready;
+    ready = true;
+    Q_FOREACH (const QString &id, removedIds) {
+        Q_EMIT q->removed(id);
+    }
+    Q_FOREACH (const QString &id, expiredIds) {
+        Q_EMIT q->expired(id);
+    }
+    Q_FOREACH (const TemporaryAuthorization &authorization, added) {
+        Q_EMIT q->added(authorization);
+    }
+    if (first || !removedIds.isEmpty() || !expiredIds.isEmpty() || !added.isEmpty()) {
+        Q_EMIT q->changed(q);
+    }
+}
+
+void TemporaryAuthorizationWatch::Private::expire()
+{
+    // polkitd gives the expiration time in seconds, rounded down, so this
+    // never reports an authorization as expired later than it really does
+    const QDateTime now = QDateTime::currentDateTime();
+    QStringList expiredIds;
+    while (!authorizations.isEmpty() && authorizations.first().expirationTime() <= now) {
+        expiredIds.append(authorizations.takeFirst().id());
+    }
+    scheduleExpiry();
+
+    Q_FOREACH (const QString &id, expiredIds) {
+        Q_EMIT q->expired(id);
+    }
+    if (!expiredIds.isEmpty()) {
+        Q_EMIT q->changed(q);
+    }
+}
+
+void TemporaryAuthorizationWatch::Private::scheduleExpiry()
+{
+    if (authorizations.isEmpty()) {
+        expiryTimer->stop();
+        return;
+    }
+
+    const qint64 msecs = QDateTime::currentDateTime().msecsTo(authorizations.first().expirationTime());
+    expiryTimer->start(int(qMax<qint64>(0, msecs)));
+}
+
+TemporaryAuthorizationWatch::TemporaryAuthorizationWatch(Authority *authority, const Subject &subject, QObject *parent)
+        : QObject(parent)
+        , d(new Private(this))
+{
+    d->authority = authority;
+    d->subject = subject;
+    d->expiryTimer = new QTimer(this);
+    d->expiryTimer->setSingleShot(true);
+    d->expiryTimer->setTimerType(Qt::PreciseTimer);
+    connect(d->expiryTimer, SIGNAL(timeout()), this, SLOT(expire()));
+
+    // polkitd does not announce temporary authorizations, these are the hints we have
+    connect(authority, SIGNAL(changed(quint64)), this, SLOT(refresh()));
+    connect(authority, SIGNAL(temporaryAuthorizationsChanged()), this, SLOT(refresh()));
+    refresh();
+}
+
+TemporaryAuthorizationWatch::~TemporaryAuthorizationWatch()
+{
+    if (d->cancellable != NULL) {
+        g_cancellable_cancel(d->cancellable);
+        g_object_unref(d->cancellable);
+    }
+    delete d;
+}
+
+Subject TemporaryAuthorizationWatch::subject() const
+{
+    return d->subject;
+}
+
+TemporaryAuthorization::List TemporaryAuthorizationWatch::authorizations() const
+{
+    return d->authorizations;
+}
+
+bool TemporaryAuthorizationWatch::isReady() const
+{
+    return d->ready;
+}
+
+void TemporaryAuthorizationWatch::refresh()
+{
+    if (d->cancellable != NULL) {
+        d->stale = true;
+        return;
+    }
+
+    // the fake backend has no temporary authorizations, and failing to get the
+    // authority is not an error of the caller's
+    const bool hadError = d->authority->hasError();
+    PolkitAuthority *pkAuthority = d->authority->polkitAuthority();
+    if (pkAuthority == NULL) {
+        if (!hadError) {
+            d->authority->clearError();
+        }
+        return;
+    }
+
+    d->stale = false;
+    d->cancellable = g_cancellable_new();
+    TemporaryAuthorizationListing *listing = new TemporaryAuthorizationListing;
+    listing->watch = this;
+    polkit_authority_enumerate_temporary_authorizations(pkAuthority, d->subject.subject(), d->cancellable,
+                                                        Private::listCallback, listing);
+}
+
+}
+
+#include "moc_polkitqt1-temporaryauthorizationwatch.cpp"
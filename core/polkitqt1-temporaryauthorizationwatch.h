@@ -0,0 +1,129 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_TEMPORARYAUTHORIZATIONWATCH_H
+#define POLKITQT1_TEMPORARYAUTHORIZATIONWATCH_H
+
+#include "polkitqt1-export.h"
+#include "polkitqt1-authority.h"
+#include "polkitqt1-subject.h"
+#include "polkitqt1-temporaryauthorization.h"
+
+#include <QtCore/QObject>
+
+namespace PolkitQt1
+{
+
+/**
+ * \class TemporaryAuthorizationWatch polkitqt1-temporaryauthorizationwatch.h TemporaryAuthorizationWatch
+ *
+ * \brief Keeps a local copy of the temporary authorizations of a subject
+ *
+ * Returned by Authority::watchTemporaryAuthorizations(). The watch lists the
+ * temporary authorizations of its subject once, then only lists them again
+ * when Authority emits changed() or temporaryAuthorizationsChanged(), and
+ * reports what was added and removed. An authorization which reaches its
+ * expiration time is dropped by a timer, without asking the authority.
+ *
+ * polkitd keeps temporary authorizations per session, so the subject should
+ * be a UnixSessionSubject. It does not announce the authorizations obtained or
+ * revoked by other processes either: call refresh() to pick those up.
+ *
+ * The watch is owned by the caller: delete it to stop watching.
+ *
+ * \see Authority::watchTemporaryAuthorizations
+ */
+class POLKITQT1_EXPORT TemporaryAuthorizationWatch : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TemporaryAuthorizationWatch)
+public:
+    ~TemporaryAuthorizationWatch();
+
+    /**
+     * \return the subject whose temporary authorizations are watched
+     */
+    Subject subject() const;
+
+    /**
+     * \return the temporary authorizations known to be in effect, the one
+     *         expiring first coming first
+     */
+    TemporaryAuthorization::List authorizations() const;
+
+    /**
+     * \return \c true once the temporary authorizations have been listed for the first time
+     */
+    bool isReady() const;
+
+public Q_SLOTS:
+    /**
+     * Lists the temporary authorizations again, as if Authority had emitted changed().
+     */
+    void refresh();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted for every temporary authorization which appeared.
+     *
+     * \param authorization the new temporary authorization
+     */
+    void added(const PolkitQt1::TemporaryAuthorization &authorization);
+
+    /**
+     * This signal is emitted for every temporary authorization which went away
+     * before its expiration time, usually because it was revoked.
+     *
+     * \param id the identifier of the temporary authorization
+     */
+    void removed(const QString &id);
+
+    /**
+     * This signal is emitted when a temporary authorization reaches its
+     * expiration time.
+     *
+     * \param id the identifier of the temporary authorization
+     */
+    void expired(const QString &id);
+
+    /**
+     * This signal is emitted once the temporary authorizations have been listed
+     * for the first time, and then once after every listing or expiry which
+     * changed them, after the added(), removed() and expired() signals.
+     *
+     * \param watch the watch whose authorizations changed, i.e. this object
+     */
+    void changed(PolkitQt1::TemporaryAuthorizationWatch *watch);
+
+private:
+    TemporaryAuthorizationWatch(Authority *authority, const Subject &subject, QObject *parent = 0);
+
+    class Private;
+    friend class Private;
+    friend class Authority;
+    Private * const d;
+
+    Q_PRIVATE_SLOT(d, void expire())
+};
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POLKITQT1_TRACING_P_H
+#define POLKITQT1_TRACING_P_H
+
+/*
+ * Static tracepoints (USDT) for perf, bpftrace and SystemTap, built in when
+ * configuring with -DENABLE_TRACEPOINTS=ON. All of them belong to the
+ * "polkitqt1" provider:
+ *
+ *   operation__start(const char *operation)
+ *   operation__done(const char *operation, int outcome, long long usecs)
+ *   callback__enter(const char *operation)
+ *   callback__exit(const char *operation, int outcome, long long usecs)
+ *   check__start(const char *actionId, const char *subjectKind, int flags)
+ *   check__done(const char *actionId, const char *subjectKind, int result, int error, long long usecs)
+ *   agent__initiate(const char *actionId, const char *cookie)
+ *   agent__initiate__done(const char *actionId, int failed, long long usecs)
+ *   agent__cancelled(void *listener)
+ *   session__initiate(void *session, const char *cookie)
+ *   session__request(void *session, int echo)
+ *   session__response(void *session)
+ *   session__cancel(void *session)
+ *   session__completed(void *session, int gained, long long usecs)
+ *
+ * The operation names are the ones of AuthorityMetrics::operationName(), the
+ * outcome is 0 on success, 1 on failure and 2 on cancellation, and an error
+ * of -1 means the check was cancelled. The sessions of an authentication
+ * share its cookie.
+ *
+ * Without tracepoints every macro expands to nothing. With them, a probe no
+ * tracer is attached to costs a nop plus the setup of its arguments; the
+ * probes which need more than that check POLKITQT1_ENABLED() first.
+ *
+ * Every probe has a semaphore, which the tracers increment while they are
+ * attached to it. The translation unit firing a probe defines its semaphore
+ * with POLKITQT1_SEMAPHORE().
+ */
+
+#ifdef POLKIT_QT_1_TRACEPOINTS
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define POLKITQT1_SEMAPHORE_NAME(name) polkitqt1_##name##_semaphore
+#define POLKITQT1_SEMAPHORE(name) \
+    extern "C" { \
+    __attribute__((visibility("hidden"), section(".probes"))) volatile unsigned short POLKITQT1_SEMAPHORE_NAME(name) = 0; \
+    }
+#define POLKITQT1_ENABLED(name) __builtin_expect(POLKITQT1_SEMAPHORE_NAME(name) != 0, 0)
+
+#define POLKITQT1_TRACE1(name, a) DTRACE_PROBE1(polkitqt1, name, a)
+#define POLKITQT1_TRACE2(name, a, b) DTRACE_PROBE2(polkitqt1, name, a, b)
+#define POLKITQT1_TRACE3(name, a, b, c) DTRACE_PROBE3(polkitqt1, name, a, b, c)
+#define POLKITQT1_TRACE5(name, a, b, c, d, e) DTRACE_PROBE5(polkitqt1, name, a, b, c, d, e)
+
+#else
+
+#define POLKITQT1_SEMAPHORE(name)
+#define POLKITQT1_ENABLED(name) false
+#define POLKITQT1_TRACE1(name, a)
+#define POLKITQT1_TRACE2(name, a, b)
+#define POLKITQT1_TRACE3(name, a, b, c)
+#define POLKITQT1_TRACE5(name, a, b, c, d, e)
+
+#endif
+
+#endif
@@ -109,11 +109,11 @@ Action::Action(const QString &actionId, QObject *parent)
     // this must be called AFTER the values initialization
     setPolkitAction(actionId);
 
-    // track the config changes to update the action
-    connect(Authority::instance(), SIGNAL(configChanged()),
+    // track the config and ConsoleKit changes to update the action, once per burst
+    connect(Authority::instance(), SIGNAL(changed(quint64)),
             this, SLOT(configChanged()));
-    // for now we call config changed..
-    connect(Authority::instance(), SIGNAL(consoleKitDBChanged()),
+    // the result is only computed once an asynchronously initialized authority is ready
+    connect(Authority::instance(), SIGNAL(ready()),
             this, SLOT(configChanged()));
 }
 
@@ -227,6 +227,11 @@ bool Action::Private::computePkResult()
     old_result = pkResult;
     pkResult = Authority::Unknown;
 
+    // don't block the application while the authority initializes, ready() brings us back
+    if (!Authority::instance()->isReady()) {
+        return old_result != pkResult;
+    }
+
     pkResult = Authority::instance()->checkAuthorizationSync(actionId, subject, Authority::None);
 
     return old_result != pkResult;
@@ -0,0 +1,239 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+/*
+ * Benchmarks of the hot paths of Authority against polkit-qt-mockpolkitd,
+ * so that they need neither polkitd nor installed policies. Set
+ * POLKIT_QT_BENCH_LATENCY to the latency of the mock authority in msecs
+ * (0 by default) and POLKIT_QT_1_BACKEND to choose the backend.
+ *
+ * With POLKIT_QT_BENCH_BACKEND=fake, the checks are answered in process by a
+ * FakeAuthorityBackend instead, which measures the overhead of the library
+ * alone.
+ */
+
+#include "bench.h"
+#include "core/polkitqt1-authority.h"
+#include "core/polkitqt1-pendingauthorization.h"
+#include "core/polkitqt1-authorizationmatrix.h"
+#include "core/polkitqt1-fakeauthoritybackend.h"
+using namespace PolkitQt1;
+
+// number of synthetic actions returned by EnumerateActions
+static const int mockActions = 500;
+
+BenchAuth::BenchAuth(PrivateBus *bus)
+        : m_bus(bus)
+        , m_running(0)
+        , m_lastResult(Authority::Unknown)
+{
+}
+
+void BenchAuth::initTestCase()
+{
+    QVERIFY(!Authority::instance()->hasError());
+    QCOMPARE(Authority::instance()->checkAuthorizationSync("org.qt.policykit.mock.yes",
+                                                           UnixProcessSubject(QCoreApplication::applicationPid()),
+                                                           Authority::None), Authority::Yes);
+}
+
+void BenchAuth::bench_checkAuthorizationSync()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    QBENCHMARK {
+        authority->checkAuthorizationSync("org.qt.policykit.mock.yes", process, Authority::None);
+    }
+    QVERIFY(!authority->hasError());
+}
+
+void BenchAuth::bench_checkAuthorizationAsync_data()
+{
+    QTest::addColumn<int>("inFlight");
+    QTest::newRow("1") << 1;
+    QTest::newRow("16") << 16;
+    QTest::newRow("256") << 256;
+}
+
+void BenchAuth::bench_checkAuthorizationAsync()
+{
+    QFETCH(int, inFlight);
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    QBENCHMARK {
+        m_running = inFlight;
+        for (int i = 0; i < inFlight; ++i) {
+            PendingAuthorization *request = authority->checkAuthorizationAsync("org.qt.policykit.mock.yes", process,
+                                                                               Authority::None, this);
+            connect(request, SIGNAL(finished(PolkitQt1::PendingAuthorization*)),
+                    this, SLOT(requestFinished(PolkitQt1::PendingAuthorization*)));
+        }
+        while (m_running > 0) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    }
+}
+
+void BenchAuth::bench_checkAuthorizationsSync()
+{
+    QStringList actionIds;
+    for (int i = 0; i < 64; ++i) {
+        actionIds << QString::fromLatin1("org.qt.policykit.mock.action%1").arg(i);
+    }
+    QList<Subject> subjects;
+    subjects << UnixProcessSubject(QCoreApplication::applicationPid());
+
+    QBENCHMARK {
+        AuthorizationMatrix matrix = Authority::instance()->checkAuthorizationsSync(actionIds, subjects,
+                                                                                     Authority::None);
+        QCOMPARE(matrix.rowCount(), actionIds.count());
+    }
+}
+
+void BenchAuth::bench_enumerateActionsSync()
+{
+    if (qgetenv("POLKIT_QT_BENCH_BACKEND") == "fake") {
+        QSKIP("The fake backend only answers checks");
+    }
+    Authority *authority = Authority::instance();
+
+    QBENCHMARK {
+        ActionDescription::List actions = authority->enumerateActionsSync();
+        QVERIFY(actions.count() >= mockActions);
+    }
+}
+
+void BenchAuth::bench_cancelCheckAuthorization()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    // the mock never answers a held check, so this measures start, cancel and
+    // the delivery of the cancellation only
+    QBENCHMARK {
+        m_running = 1;
+        PendingAuthorization *request = authority->checkAuthorizationAsync("org.qt.policykit.mock.hold", process,
+                                                                           Authority::AllowUserInteraction, this);
+        connect(request, SIGNAL(finished(PolkitQt1::PendingAuthorization*)),
+                this, SLOT(requestFinished(PolkitQt1::PendingAuthorization*)));
+        request->cancel();
+        while (m_running > 0) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    }
+}
+
+void BenchAuth::bench_reconnect()
+{
+    if (qgetenv("POLKIT_QT_BENCH_BACKEND") == "fake") {
+        QSKIP("The fake backend cannot be restarted");
+    }
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    // a check asked for while polkitd restarts waits for it; this measures
+    // the restart of the mock plus the reconnection
+    QBENCHMARK {
+        m_bus->stopAuthority();
+        // let the authority notice that polkitd left
+        QTest::qWait(20);
+        m_running = 1;
+        PendingAuthorization *request = authority->checkAuthorizationAsync("org.qt.policykit.mock.yes", process,
+                                                                           Authority::None, this);
+        connect(request, SIGNAL(finished(PolkitQt1::PendingAuthorization*)),
+                this, SLOT(requestFinished(PolkitQt1::PendingAuthorization*)));
+        QVERIFY(m_bus->startAuthority());
+        while (m_running > 0) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+        QCOMPARE(m_lastResult, Authority::Yes);
+    }
+    QVERIFY(!authority->hasError());
+}
+
+void BenchAuth::test_checkAuthorizationsSyncWhileLost()
+{
+    if (qgetenv("POLKIT_QT_BENCH_BACKEND") == "fake") {
+        QSKIP("The fake backend cannot be stopped");
+    }
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    const QStringList actionIds = QStringList() << QLatin1String("org.qt.policykit.mock.no")
+                                                << QLatin1String("org.qt.policykit.mock.challenge");
+
+    m_bus->stopAuthority();
+    QTest::qWait(20);
+    // a blocking check cannot wait for the reconnection, its cells fail right away
+    const AuthorizationMatrix matrix = authority->checkAuthorizationsSync(actionIds, QList<Subject>() << process,
+                                                                          Authority::None, 2000);
+    QCOMPARE(matrix.errorCount(), actionIds.size());
+
+    // the asynchronous checks still wait for polkitd
+    m_running = 1;
+    PendingAuthorization *request = authority->checkAuthorizationAsync("org.qt.policykit.mock.no", process,
+                                                                       Authority::None, this);
+    connect(request, SIGNAL(finished(PolkitQt1::PendingAuthorization*)),
+            this, SLOT(requestFinished(PolkitQt1::PendingAuthorization*)));
+    QVERIFY(m_bus->startAuthority());
+    while (m_running > 0) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    QCOMPARE(m_lastResult, Authority::No);
+    QVERIFY(!authority->hasError());
+}
+
+void BenchAuth::requestFinished(PendingAuthorization *request)
+{
+    --m_running;
+    m_lastResult = request->result();
+    request->deleteLater();
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    PrivateBus bus;
+    FakeAuthorityBackend fake;
+    if (qgetenv("POLKIT_QT_BENCH_BACKEND") == "fake") {
+        fake.setResult("org.qt.policykit.mock.yes", Authority::Yes);
+        fake.setResult("org.qt.policykit.mock.challenge", Authority::Challenge);
+        // nothing is held here: a cancelled check races with its answer
+        Authority::setFakeBackend(&fake);
+    } else {
+        bus.setScript("org.qt.policykit.mock.yes yes\n"
+                      "org.qt.policykit.mock.no no\n"
+                      "org.qt.policykit.mock.challenge challenge\n"
+                      "org.qt.policykit.mock.hold hold\n");
+        bus.setLatency(qgetenv("POLKIT_QT_BENCH_LATENCY").toInt());
+        bus.setSyntheticActions(mockActions);
+        if (!bus.start()) {
+            return 1;
+        }
+    }
+
+    BenchAuth bench(&bus);
+    return QTest::qExec(&bench, argc, argv);
+}
+
+#include "moc_bench.cpp"
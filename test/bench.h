@@ -0,0 +1,61 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <QtCore/QObject>
+#include <QtTest/QtTest>
+
+#include "privatebus.h"
+#include "core/polkitqt1-authority.h"
+
+namespace PolkitQt1
+{
+class PendingAuthorization;
+}
+
+class BenchAuth : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BenchAuth(PrivateBus *bus);
+
+private Q_SLOTS:
+    void initTestCase();
+    void bench_checkAuthorizationSync();
+    void bench_checkAuthorizationAsync_data();
+    void bench_checkAuthorizationAsync();
+    void bench_checkAuthorizationsSync();
+    void bench_enumerateActionsSync();
+    void bench_cancelCheckAuthorization();
+    void bench_reconnect();
+    void test_checkAuthorizationsSyncWhileLost();
+
+    void requestFinished(PolkitQt1::PendingAuthorization *request);
+
+private:
+    PrivateBus *m_bus;
+    int m_running;
+    PolkitQt1::Authority::Result m_lastResult;
+};
+
+#endif // BENCH_H
@@ -0,0 +1,358 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+/*
+ * Tests of ActionCatalog against polkit-qt-mockpolkitd on a private bus,
+ * whose script decides the actions polkitd enumerates.
+ */
+
+#include "catalogtest.h"
+#include "core/polkitqt1-authority.h"
+#include "core/polkitqt1-actioncatalog.h"
+#include <QtCore/QThreadPool>
+#include <string.h>
+using namespace PolkitQt1;
+
+static const char scriptA[] =
+    "org.qt.policykit.mock.b yes\n"
+    "org.qt.policykit.mock.c yes\n"
+    "org.qt.policykit.mock.e yes\n";
+
+// a comes before every action of A, and e after every action of B
+static const char scriptB[] =
+    "org.qt.policykit.mock.a yes\n"
+    "org.qt.policykit.mock.c yes 0 Changed description of c\n"
+    "org.qt.policykit.mock.d yes\n";
+
+static QStringList mockIds(const char *names)
+{
+    QStringList result;
+    Q_FOREACH(const QString &name, QString::fromLatin1(names).split(QLatin1Char(' '), QString::SkipEmptyParts)) {
+        result.append(QLatin1String("org.qt.policykit.mock.") + name);
+    }
+    return result;
+}
+
+// offsets in the snapshot file, see polkitqt1-actionsnapshot.cpp
+static const int versionOffset = 8;
+static const int byteOrderOffset = 12;
+static const int sizeOffset = 16;
+static const int directoryCountOffset = 24;
+static const int directoriesOffsetOffset = 28;
+static const int actionCountOffset = 32;
+static const int actionsOffsetOffset = 36;
+static const int stringsOffsetOffset = 40;
+static const int stringsSizeOffset = 44;
+static const int localeOffset = 48;
+static const int directoryMtimeOffset = 8;
+static const int actionSize = 64;
+static const int actionImplicitAnyOffset = 48;
+// every string is an offset and a length
+static const int stringSize = 8;
+
+static quint32 read32(const QByteArray &bytes, int offset)
+{
+    quint32 value;
+    memcpy(&value, bytes.constData() + offset, sizeof(value));
+    return value;
+}
+
+static quint64 read64(const QByteArray &bytes, int offset)
+{
+    quint64 value;
+    memcpy(&value, bytes.constData() + offset, sizeof(value));
+    return value;
+}
+
+static QByteArray write32(QByteArray bytes, int offset, quint32 value)
+{
+    memcpy(bytes.data() + offset, &value, sizeof(value));
+    return bytes;
+}
+
+static QByteArray write64(QByteArray bytes, int offset, qint64 value)
+{
+    memcpy(bytes.data() + offset, &value, sizeof(value));
+    return bytes;
+}
+
+/** Returns \p bytes with the first byte of the string described at \p offset changed */
+static QByteArray alterString(QByteArray bytes, int offset)
+{
+    const int at = read32(bytes, stringsOffsetOffset) + read32(bytes, offset);
+    bytes[at] = bytes.at(at) == 'X' ? 'Y' : 'X';
+    return bytes;
+}
+
+/** Takes the actions of every emission recorded by \p spy */
+static ActionDescription::List takeActions(QSignalSpy &spy)
+{
+    ActionDescription::List result;
+    while (!spy.isEmpty()) {
+        result += qvariant_cast<ActionDescription::List>(spy.takeFirst().at(0));
+    }
+    return result;
+}
+
+static QStringList actionIds(const ActionDescription::List &actions)
+{
+    QStringList result;
+    Q_FOREACH(const ActionDescription &action, actions) {
+        result.append(action.actionId());
+    }
+    return result;
+}
+
+TestActionCatalog::TestActionCatalog(PrivateBus *bus)
+        : QObject(0)
+        , m_bus(bus)
+        , m_snapshots(0)
+{
+}
+
+QString TestActionCatalog::nextSnapshotPath()
+{
+    // a new file every time, so that the catalog loads it
+    return m_dir.path() + QString::fromLatin1("/actions-%1.snapshot").arg(++m_snapshots);
+}
+
+QString TestActionCatalog::useSnapshot(const QByteArray &bytes)
+{
+    const QString path = nextSnapshotPath();
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size()) {
+        return QString();
+    }
+    file.close();
+    Authority::instance()->actionCatalog()->setSnapshotPath(path);
+    return path;
+}
+
+bool TestActionCatalog::reload(const QByteArray &script, const QStringList &actionIds)
+{
+    m_bus->stopAuthority();
+    if (!m_bus->setScript(script) || !m_bus->startAuthority() || !m_bus->waitForAuthority()) {
+        return false;
+    }
+
+    ActionCatalog *catalog = Authority::instance()->actionCatalog();
+    QSignalSpy loadedSpy(catalog, SIGNAL(loaded(PolkitQt1::ActionCatalog*)));
+    catalog->refresh();
+    for (int i = 0; i < 500 && (loadedSpy.isEmpty() || catalog->actionIds() != actionIds); ++i) {
+        QTest::qWait(10);
+    }
+    // let the enumeration the authority started on its own when it saw the
+    // restart finish as well; it finds nothing more
+    QTest::qWait(200);
+    return catalog->actionIds() == actionIds;
+}
+
+void TestActionCatalog::initTestCase()
+{
+    QVERIFY(!Authority::instance()->hasError());
+    QVERIFY(m_dir.isValid());
+    // lookups have to ask polkitd, not a snapshot of a previous run
+    Authority::instance()->actionCatalog()->setSnapshotPath(QString());
+}
+
+void TestActionCatalog::test_Catalog_diff()
+{
+    ActionCatalog *catalog = Authority::instance()->actionCatalog();
+    QSignalSpy addedSpy(catalog, SIGNAL(actionsAdded(PolkitQt1::ActionDescription::List)));
+    QSignalSpy removedSpy(catalog, SIGNAL(actionsRemoved(PolkitQt1::ActionDescription::List)));
+    QSignalSpy changedSpy(catalog, SIGNAL(actionsChanged(PolkitQt1::ActionDescription::List)));
+    QSignalSpy loadedSpy(catalog, SIGNAL(loaded(PolkitQt1::ActionCatalog*)));
+
+    // the first enumeration adds every action, the authority starts with A
+    QCOMPARE(catalog->actionIds(), mockIds("b c e"));
+    QCOMPARE(loadedSpy.count(), 1);
+    QCOMPARE(actionIds(takeActions(addedSpy)), mockIds("b c e"));
+    QVERIFY(removedSpy.isEmpty());
+    QVERIFY(changedSpy.isEmpty());
+
+    // an action added before all the others, one removed after all the
+    // others, one changed and one left alone
+    QVERIFY(reload(scriptB, mockIds("a c d")));
+    QCOMPARE(actionIds(takeActions(addedSpy)), mockIds("a d"));
+    const ActionDescription::List removed = takeActions(removedSpy);
+    QCOMPARE(actionIds(removed), mockIds("b e"));
+    QCOMPARE(removed.first().description(), QString("Description of org.qt.policykit.mock.b"));
+    const ActionDescription::List changed = takeActions(changedSpy);
+    QCOMPARE(actionIds(changed), mockIds("c"));
+    QCOMPARE(changed.first().description(), QString("Changed description of c"));
+    QCOMPARE(catalog->action("org.qt.policykit.mock.c").description(), QString("Changed description of c"));
+
+    // the same actions again change nothing
+    QVERIFY(reload(scriptB, mockIds("a c d")));
+    QVERIFY(addedSpy.isEmpty());
+    QVERIFY(removedSpy.isEmpty());
+    QVERIFY(changedSpy.isEmpty());
+
+    // removing the last actions reports them with the descriptions they had
+    QVERIFY(reload(QByteArray(), QStringList()));
+    const ActionDescription::List lastRemoved = takeActions(removedSpy);
+    QCOMPARE(actionIds(lastRemoved), mockIds("a c d"));
+    QCOMPARE(lastRemoved.at(1).description(), QString("Changed description of c"));
+    QVERIFY(addedSpy.isEmpty());
+    QVERIFY(changedSpy.isEmpty());
+    QCOMPARE(catalog->count(), 0);
+
+    // and the first action after that is added
+    QVERIFY(reload(scriptA, mockIds("b c e")));
+    QCOMPARE(actionIds(takeActions(addedSpy)), mockIds("b c e"));
+    QVERIFY(removedSpy.isEmpty());
+    QVERIFY(changedSpy.isEmpty());
+    QVERIFY(loadedSpy.count() >= 5);
+}
+
+void TestActionCatalog::test_Catalog_snapshot()
+{
+    ActionCatalog *catalog = Authority::instance()->actionCatalog();
+    QVERIFY(reload(scriptA, mockIds("b c e")));
+
+    // the first lookup with no snapshot enumerates, and saves the actions
+    const QString path = nextSnapshotPath();
+    catalog->setSnapshotPath(path);
+    QCOMPARE(catalog->actionIds(), mockIds("b c e"));
+    QThreadPool::globalInstance()->waitForDone();
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    m_snapshot = file.readAll();
+    file.close();
+    QCOMPARE(m_snapshot.left(8), QByteArray("PKQTACT", 8));
+    QCOMPARE(read64(m_snapshot, sizeOffset), quint64(m_snapshot.size()));
+    QCOMPARE(read32(m_snapshot, actionCountOffset), quint32(3));
+
+    // once polkitd has other actions, the lookups answering A come from the file
+    QVERIFY(reload(scriptB, mockIds("a c d")));
+    QVERIFY(!useSnapshot(m_snapshot).isEmpty());
+    QCOMPARE(catalog->actionIds(), mockIds("b c e"));
+    QCOMPARE(catalog->action("org.qt.policykit.mock.c").description(),
+             QString("Description of org.qt.policykit.mock.c"));
+    QCOMPARE(catalog->action("org.qt.policykit.mock.b").message(),
+             QString("Authentication is required to run org.qt.policykit.mock.b"));
+    QCOMPARE(catalog->actionsByVendor("Polkit-qt").size(), 3);
+    QCOMPARE(catalog->actionsWithImplicitAuthorization(ActionCatalog::ImplicitActive,
+                                                       ActionDescription::AdministratorAuthenticationRequiredRetained).size(), 3);
+    QVERIFY(catalog->actionsWithPrefix("org.qt.policykit.mock.a").isEmpty());
+
+    // the same file taken for another locale is stale
+    const QByteArray locale = qgetenv("LC_ALL");
+    qputenv("LC_ALL", "xx_XX.UTF-8");
+    QVERIFY(!useSnapshot(m_snapshot).isEmpty());
+    QCOMPARE(catalog->actionIds(), mockIds("a c d"));
+    if (locale.isEmpty()) {
+        qunsetenv("LC_ALL");
+    } else {
+        qputenv("LC_ALL", locale);
+    }
+    QThreadPool::globalInstance()->waitForDone();
+}
+
+void TestActionCatalog::test_Catalog_staleSnapshot_data()
+{
+    QTest::addColumn<QByteArray>("snapshot");
+
+    QVERIFY(!m_snapshot.isEmpty());
+    const QByteArray &valid = m_snapshot;
+    const int size = valid.size();
+    const int directories = read32(valid, directoriesOffsetOffset);
+    const int actions = read32(valid, actionsOffsetOffset);
+    const quint32 stringsSize = read32(valid, stringsSizeOffset);
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("truncated header") << valid.left(40);
+    QTest::newRow("truncated") << valid.left(size - 1);
+    QTest::newRow("grown") << valid + QByteArray(8, '\0');
+    QByteArray magic = valid;
+    magic[0] = 'X';
+    QTest::newRow("magic") << magic;
+    QTest::newRow("version") << write32(valid, versionOffset, 2);
+    QTest::newRow("byte order") << write32(valid, byteOrderOffset, 0x04030201);
+    QTest::newRow("size") << write64(valid, sizeOffset, size - 1);
+    QTest::newRow("directories offset") << write32(valid, directoriesOffsetOffset, size);
+    QTest::newRow("action count") << write32(valid, actionCountOffset, 1000);
+    QTest::newRow("strings size") << write32(valid, stringsSizeOffset, stringsSize + 8);
+    QTest::newRow("locale offset") << write32(valid, localeOffset, stringsSize);
+    QTest::newRow("directory path offset") << write32(valid, directories, stringsSize);
+    QTest::newRow("id offset") << write32(valid, actions, stringsSize);
+    QTest::newRow("id length") << write32(valid, actions + 4, stringsSize);
+    // the length then ends inside the next string, not on a NUL
+    QTest::newRow("id without NUL") << write32(valid, actions + 4, read32(valid, actions + 4) + 1);
+    QTest::newRow("icon offset") << write32(valid, actions + 5 * stringSize, 0xffffffff);
+    QTest::newRow("implicit") << write32(valid, actions + actionImplicitAnyOffset, 42);
+
+    // the ids have to be sorted and unique
+    QByteArray swapped = valid;
+    swapped.replace(actions, actionSize, valid.mid(actions + actionSize, actionSize));
+    swapped.replace(actions + actionSize, actionSize, valid.mid(actions, actionSize));
+    QTest::newRow("unsorted") << swapped;
+    QByteArray duplicate = valid;
+    duplicate.replace(actions + actionSize, actionSize, valid.mid(actions, actionSize));
+    QTest::newRow("duplicate") << duplicate;
+
+    // valid files, taken in other conditions
+    QTest::newRow("locale") << alterString(valid, localeOffset);
+    QTest::newRow("directory path") << alterString(valid, directories);
+    QTest::newRow("directory mtime") << write64(valid, directories + directoryMtimeOffset, 1234567890);
+    QTest::newRow("directory count") << write32(valid, directoryCountOffset, 0);
+}
+
+void TestActionCatalog::test_Catalog_staleSnapshot()
+{
+    QFETCH(QByteArray, snapshot);
+    ActionCatalog *catalog = Authority::instance()->actionCatalog();
+    QSignalSpy addedSpy(catalog, SIGNAL(actionsAdded(PolkitQt1::ActionDescription::List)));
+
+    // polkitd has B, the broken snapshot would have had A
+    QVERIFY(reload(scriptB, mockIds("a c d")));
+    addedSpy.clear();
+    const QString path = useSnapshot(snapshot);
+    QVERIFY(!path.isEmpty());
+    QCOMPARE(catalog->actionIds(), mockIds("a c d"));
+    QVERIFY(!catalog->contains("org.qt.policykit.mock.b"));
+    QCOMPARE(catalog->action("org.qt.policykit.mock.c").description(), QString("Changed description of c"));
+    QVERIFY(addedSpy.isEmpty());
+    QVERIFY(!Authority::instance()->hasError());
+
+    // and the enumeration replaced it with a valid one
+    QThreadPool::globalInstance()->waitForDone();
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray saved = file.readAll();
+    QCOMPARE(saved.left(8), QByteArray("PKQTACT", 8));
+    QCOMPARE(read64(saved, sizeOffset), quint64(saved.size()));
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    PrivateBus bus;
+    if (!bus.setScript(scriptA) || !bus.start()) {
+        return 1;
+    }
+
+    TestActionCatalog test(&bus);
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "moc_catalogtest.cpp"
@@ -0,0 +1,61 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef CATALOGTEST_H
+#define CATALOGTEST_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+
+#include "privatebus.h"
+
+class TestActionCatalog : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TestActionCatalog(PrivateBus *bus);
+
+private Q_SLOTS:
+    void initTestCase();
+    void test_Catalog_diff();
+    void test_Catalog_snapshot();
+    void test_Catalog_staleSnapshot_data();
+    void test_Catalog_staleSnapshot();
+
+private:
+    /** Restarts the mock authority with \p script, and waits until the catalog lists \p actionIds */
+    bool reload(const QByteArray &script, const QStringList &actionIds);
+    /** Returns a file of m_dir which was never used */
+    QString nextSnapshotPath();
+    /** Writes \p bytes to a new file of m_dir and makes it the snapshot of the catalog */
+    QString useSnapshot(const QByteArray &bytes);
+
+    PrivateBus *m_bus;
+    QTemporaryDir m_dir;
+    int m_snapshots;
+    // a valid snapshot of the actions of script A
+    QByteArray m_snapshot;
+};
+
+#endif // CATALOGTEST_H
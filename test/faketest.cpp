@@ -0,0 +1,337 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+/*
+ * Tests of Authority against a FakeAuthorityBackend, which answers the checks
+ * in process, so that they need neither polkitd nor installed policies.
+ */
+
+#include "faketest.h"
+#include "core/polkitqt1-authority.h"
+#include "core/polkitqt1-pendingauthorization.h"
+#include "core/polkitqt1-fakeauthoritybackend.h"
+#include <QtCore/QElapsedTimer>
+using namespace PolkitQt1;
+
+TestFakeAuth::TestFakeAuth(FakeAuthorityBackend *fake)
+        : QObject(0)
+        , m_fake(fake)
+{
+}
+
+void TestFakeAuth::init()
+{
+    m_fake->clear();
+    m_fake->setDefaultResult(Authority::No);
+    m_fake->setLatency(0);
+    Authority::instance()->clearError();
+}
+
+void TestFakeAuth::test_Fake_results()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    QVERIFY(authority->isReady());
+
+    m_fake->setResult("org.qt.policykit.fake.yes", Authority::Yes);
+    m_fake->setResult("org.qt.policykit.fake.challenge", Authority::Challenge);
+    QCOMPARE(m_fake->result("org.qt.policykit.fake.yes"), Authority::Yes);
+    QCOMPARE(m_fake->result("org.qt.policykit.fake.other"), Authority::No);
+
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.yes", process, Authority::None),
+             Authority::Yes);
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.challenge", process, Authority::None),
+             Authority::Challenge);
+    // actions with no result of their own get the default one
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.other", process, Authority::None),
+             Authority::No);
+    m_fake->setDefaultResult(Authority::Challenge);
+    QCOMPARE(m_fake->defaultResult(), Authority::Challenge);
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.other", process, Authority::None),
+             Authority::Challenge);
+    QVERIFY(!authority->hasError());
+
+    // asynchronous checks get the same answers, from the event loop
+    PendingAuthorization *request = authority->checkAuthorizationAsync("org.qt.policykit.fake.yes", process,
+                                                                       Authority::None, this);
+    QSignalSpy spy(request, SIGNAL(finished(PolkitQt1::PendingAuthorization*)));
+    QVERIFY(!request->isFinished());
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(request->result(), Authority::Yes);
+    QVERIFY(!request->hasError());
+    delete request;
+
+    // forgotten results fall back to the default one
+    m_fake->clear();
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.yes", process, Authority::None),
+             Authority::Challenge);
+    QVERIFY(!authority->hasError());
+}
+
+void TestFakeAuth::test_Fake_failure()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    m_fake->setResult("org.qt.policykit.fake.broken", Authority::Yes);
+    m_fake->setFailure("org.qt.policykit.fake.broken", Authority::E_CheckFailed, "broken on purpose");
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.broken", process, Authority::None),
+             Authority::Unknown);
+    QVERIFY(authority->hasError());
+    QCOMPARE(authority->lastError(), Authority::E_CheckFailed);
+    QCOMPARE(authority->errorDetails(), QString("broken on purpose"));
+    authority->clearError();
+
+    // other actions are not affected
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.other", process, Authority::None),
+             Authority::No);
+    QVERIFY(!authority->hasError());
+
+    // the failure lasts until it is lifted
+    PendingAuthorization *request = authority->checkAuthorizationAsync("org.qt.policykit.fake.broken", process,
+                                                                       Authority::None, this);
+    QSignalSpy spy(request, SIGNAL(finished(PolkitQt1::PendingAuthorization*)));
+    QVERIFY(spy.wait(1000));
+    QVERIFY(request->hasError());
+    QCOMPARE(request->error(), Authority::E_CheckFailed);
+    QCOMPARE(request->errorDetails(), QString("broken on purpose"));
+    QCOMPARE(request->result(), Authority::Unknown);
+    delete request;
+
+    m_fake->setFailure("org.qt.policykit.fake.broken", Authority::E_None);
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.broken", process, Authority::None),
+             Authority::Yes);
+    QVERIFY(!authority->hasError());
+}
+
+void TestFakeAuth::test_Fake_failNextChecks()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    m_fake->setResult("org.qt.policykit.fake.yes", Authority::Yes);
+    m_fake->failNextChecks(2, Authority::E_CheckFailed, "flaky");
+    // exactly two checks fail, whatever their action
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.yes", process, Authority::None),
+             Authority::Unknown);
+    QCOMPARE(authority->lastError(), Authority::E_CheckFailed);
+    QCOMPARE(authority->errorDetails(), QString("flaky"));
+    authority->clearError();
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.other", process, Authority::None),
+             Authority::Unknown);
+    QCOMPARE(authority->lastError(), Authority::E_CheckFailed);
+    authority->clearError();
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.yes", process, Authority::None),
+             Authority::Yes);
+    QVERIFY(!authority->hasError());
+
+    // they come before the failures of the actions
+    m_fake->setFailure("org.qt.policykit.fake.yes", Authority::E_CheckFailed, "broken");
+    m_fake->failNextChecks(1, Authority::E_UnknownResult, "flaky");
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.yes", process, Authority::None),
+             Authority::Unknown);
+    QCOMPARE(authority->lastError(), Authority::E_UnknownResult);
+    authority->clearError();
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.yes", process, Authority::None),
+             Authority::Unknown);
+    QCOMPARE(authority->lastError(), Authority::E_CheckFailed);
+    QCOMPARE(authority->errorDetails(), QString("broken"));
+}
+
+void TestFakeAuth::test_Fake_latency()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    m_fake->setLatency(100);
+    QCOMPARE(m_fake->latency(), 100);
+    m_fake->setResult("org.qt.policykit.fake.yes", Authority::Yes);
+
+    QElapsedTimer timer;
+    timer.start();
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.yes", process, Authority::None),
+             Authority::Yes);
+    QVERIFY(timer.elapsed() >= 100);
+
+    timer.restart();
+    PendingAuthorization *request = authority->checkAuthorizationAsync("org.qt.policykit.fake.yes", process,
+                                                                       Authority::None, this);
+    QSignalSpy spy(request, SIGNAL(finished(PolkitQt1::PendingAuthorization*)));
+    QTest::qWait(20);
+    QVERIFY(!request->isFinished());
+    QVERIFY(spy.wait(1000));
+    // timers may fire a little early
+    QVERIFY(timer.elapsed() >= 90);
+    QCOMPARE(request->result(), Authority::Yes);
+    delete request;
+
+    // a check answered later than its timeout is given up
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.yes", process, Authority::None, 20),
+             Authority::Unknown);
+    QCOMPARE(authority->lastError(), Authority::E_Timeout);
+    authority->clearError();
+
+    m_fake->setLatency(-5);
+    QCOMPARE(m_fake->latency(), 0);
+}
+
+void TestFakeAuth::test_Fake_checkCount()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    const quint64 before = m_fake->checkCount();
+    authority->checkAuthorizationSync("org.qt.policykit.fake.yes", process, Authority::None);
+    authority->checkAuthorizationSync("org.qt.policykit.fake.other", process, Authority::None);
+    QCOMPARE(m_fake->checkCount(), before + 2);
+
+    // failed checks were asked too
+    m_fake->failNextChecks(1);
+    authority->checkAuthorizationSync("org.qt.policykit.fake.yes", process, Authority::None);
+    QCOMPARE(m_fake->checkCount(), before + 3);
+    authority->clearError();
+
+    PendingAuthorization *request = authority->checkAuthorizationAsync("org.qt.policykit.fake.yes", process,
+                                                                       Authority::None, this);
+    QSignalSpy spy(request, SIGNAL(finished(PolkitQt1::PendingAuthorization*)));
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(m_fake->checkCount(), before + 4);
+    delete request;
+
+    // checks refused by the library never reach the fake
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.yes", Subject(), Authority::None),
+             Authority::Unknown);
+    QCOMPARE(authority->lastError(), Authority::E_WrongSubject);
+    QCOMPARE(m_fake->checkCount(), before + 4);
+    authority->clearError();
+}
+
+void TestFakeAuth::test_Fake_configChanged()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    QSignalSpy spy(authority, SIGNAL(configChanged()));
+
+    m_fake->changeConfig();
+    QCOMPARE(spy.count(), 1);
+
+    // results cached before the change are not used after it
+    authority->setCachingEnabled(true);
+    m_fake->setResult("org.qt.policykit.fake.cached", Authority::Yes);
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.cached", process, Authority::None),
+             Authority::Yes);
+    m_fake->setResult("org.qt.policykit.fake.cached", Authority::No);
+    m_fake->changeConfig();
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.fake.cached", process, Authority::None),
+             Authority::No);
+    authority->setCachingEnabled(false);
+}
+
+void TestFakeAuth::test_Fake_consoleKit()
+{
+    Authority *authority = Authority::instance();
+    QSignalSpy changedSpy(authority, SIGNAL(consoleKitDBChanged()));
+    QSignalSpy seatAddedSpy(authority, SIGNAL(seatAdded(QString)));
+    QSignalSpy seatRemovedSpy(authority, SIGNAL(seatRemoved(QString)));
+    QSignalSpy sessionAddedSpy(authority, SIGNAL(sessionAdded(QString,QString)));
+    QSignalSpy sessionRemovedSpy(authority, SIGNAL(sessionRemoved(QString,QString)));
+    QSignalSpy activeSpy(authority, SIGNAL(activeSessionChanged(QString,QString)));
+
+    m_fake->addSeat("/org/freedesktop/ConsoleKit/Seat1");
+    QCOMPARE(seatAddedSpy.count(), 1);
+    QCOMPARE(seatAddedSpy.takeFirst()[0].toString(), QString("/org/freedesktop/ConsoleKit/Seat1"));
+    QCOMPARE(changedSpy.count(), 1);
+
+    m_fake->addSession("/org/freedesktop/ConsoleKit/Seat1", "/org/freedesktop/ConsoleKit/Session2");
+    QCOMPARE(sessionAddedSpy.count(), 1);
+    QList<QVariant> arguments = sessionAddedSpy.takeFirst();
+    QCOMPARE(arguments[0].toString(), QString("/org/freedesktop/ConsoleKit/Seat1"));
+    QCOMPARE(arguments[1].toString(), QString("/org/freedesktop/ConsoleKit/Session2"));
+    QCOMPARE(changedSpy.count(), 2);
+
+    m_fake->activateSession("/org/freedesktop/ConsoleKit/Seat1", "/org/freedesktop/ConsoleKit/Session2");
+    QCOMPARE(activeSpy.count(), 1);
+    arguments = activeSpy.takeFirst();
+    QCOMPARE(arguments[0].toString(), QString("/org/freedesktop/ConsoleKit/Seat1"));
+    QCOMPARE(arguments[1].toString(), QString("/org/freedesktop/ConsoleKit/Session2"));
+    QCOMPARE(changedSpy.count(), 3);
+
+    m_fake->removeSession("/org/freedesktop/ConsoleKit/Seat1", "/org/freedesktop/ConsoleKit/Session2");
+    QCOMPARE(sessionRemovedSpy.count(), 1);
+    arguments = sessionRemovedSpy.takeFirst();
+    QCOMPARE(arguments[0].toString(), QString("/org/freedesktop/ConsoleKit/Seat1"));
+    QCOMPARE(arguments[1].toString(), QString("/org/freedesktop/ConsoleKit/Session2"));
+    QCOMPARE(changedSpy.count(), 4);
+
+    m_fake->removeSeat("/org/freedesktop/ConsoleKit/Seat1");
+    QCOMPARE(seatRemovedSpy.count(), 1);
+    QCOMPARE(seatRemovedSpy.takeFirst()[0].toString(), QString("/org/freedesktop/ConsoleKit/Seat1"));
+    QCOMPARE(changedSpy.count(), 5);
+
+    // every event was reported through its own signal only
+    QVERIFY(seatAddedSpy.isEmpty());
+    QVERIFY(sessionAddedSpy.isEmpty());
+    QVERIFY(activeSpy.isEmpty());
+}
+
+void TestFakeAuth::test_Fake_changed()
+{
+    Authority *authority = Authority::instance();
+    authority->setChangeCoalescingWindow(50);
+    QSignalSpy spy(authority, SIGNAL(changed(quint64)));
+    // let the changes of the previous tests through first
+    QTest::qWait(100);
+    spy.clear();
+    const quint64 generation = authority->changeGeneration();
+
+    // a burst of changes of both kinds is reported once
+    m_fake->changeConfig();
+    m_fake->addSeat("/org/freedesktop/ConsoleKit/Seat1");
+    m_fake->activateSession("/org/freedesktop/ConsoleKit/Seat1", "/org/freedesktop/ConsoleKit/Session2");
+    m_fake->changeConfig();
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(spy.wait(1000));
+    QTest::qWait(100);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.takeFirst()[0].toULongLong(), generation + 1);
+    QCOMPARE(authority->changeGeneration(), generation + 1);
+
+    // and a later change once more
+    m_fake->removeSeat("/org/freedesktop/ConsoleKit/Seat1");
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.takeFirst()[0].toULongLong(), generation + 2);
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    // installed before anything creates the authority
+    FakeAuthorityBackend fake;
+    Authority::setFakeBackend(&fake);
+
+    TestFakeAuth test(&fake);
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "moc_faketest.cpp"
@@ -0,0 +1,54 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef FAKETEST_H
+#define FAKETEST_H
+
+#include <QtCore/QObject>
+#include <QtTest/QtTest>
+
+namespace PolkitQt1
+{
+class FakeAuthorityBackend;
+}
+
+class TestFakeAuth : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TestFakeAuth(PolkitQt1::FakeAuthorityBackend *fake);
+
+private Q_SLOTS:
+    void init();
+    void test_Fake_results();
+    void test_Fake_failure();
+    void test_Fake_failNextChecks();
+    void test_Fake_latency();
+    void test_Fake_checkCount();
+    void test_Fake_configChanged();
+    void test_Fake_consoleKit();
+    void test_Fake_changed();
+
+private:
+    PolkitQt1::FakeAuthorityBackend *m_fake;
+};
+
+#endif // FAKETEST_H
@@ -0,0 +1,400 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+/*
+ * A scripted polkitd for tests and benchmarks.
+ *
+ * It implements enough of org.freedesktop.PolicyKit1.Authority for
+ * libpolkit-gobject and the QtDBus backend of polkit-qt-1 to talk to it:
+ * CheckAuthorization, CancelCheckAuthorization, EnumerateActions and the
+ * Backend* properties. Run it on a private bus and point
+ * DBUS_SYSTEM_BUS_ADDRESS of the client to that bus.
+ */
+
+#include "mockpolkitd.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMetaType>
+#include <QtDBus/QDBusVariant>
+
+#include <stdio.h>
+
+static const char polkitService[] = "org.freedesktop.PolicyKit1";
+static const char authorityPath[] = "/org/freedesktop/PolicyKit1/Authority";
+static const char authorityInterface[] = "org.freedesktop.PolicyKit1.Authority";
+static const char propertiesInterface[] = "org.freedesktop.DBus.Properties";
+
+QDBusArgument &operator<<(QDBusArgument &argument, const MockActionDescription &action)
+{
+    argument.beginStructure();
+    argument << action.actionId << action.description << action.message
+             << action.vendorName << action.vendorUrl << action.iconName
+             << action.implicitAny << action.implicitInactive << action.implicitActive
+             << action.annotations;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, MockActionDescription &action)
+{
+    argument.beginStructure();
+    argument >> action.actionId >> action.description >> action.message
+             >> action.vendorName >> action.vendorUrl >> action.iconName
+             >> action.implicitAny >> action.implicitInactive >> action.implicitActive
+             >> action.annotations;
+    argument.endStructure();
+    return argument;
+}
+
+static bool parseResult(const QString &string, MockAuthority::Result *result)
+{
+    if (string == QLatin1String("yes")) {
+        *result = MockAuthority::Yes;
+    } else if (string == QLatin1String("no")) {
+        *result = MockAuthority::No;
+    } else if (string == QLatin1String("challenge")) {
+        *result = MockAuthority::Challenge;
+    } else if (string == QLatin1String("hold")) {
+        *result = MockAuthority::Hold;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static MockActionDescription mockAction(const QString &actionId)
+{
+    MockActionDescription action;
+    action.actionId = actionId;
+    action.description = QString::fromLatin1("Description of %1").arg(actionId);
+    action.message = QString::fromLatin1("Authentication is required to run %1").arg(actionId);
+    action.vendorName = QLatin1String("Polkit-qt");
+    action.vendorUrl = QLatin1String("http://www.kde.org");
+    action.iconName = QLatin1String("dialog-password");
+    // implicit authorizations: no, no, auth_admin
+    action.implicitAny = 1;
+    action.implicitInactive = 1;
+    action.implicitActive = 4;
+    return action;
+}
+
+MockAuthority::MockAuthority(QObject *parent)
+        : QDBusVirtualObject(parent)
+{
+    m_clock.start();
+    m_timer.setSingleShot(true);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(sendDueReplies()));
+}
+
+bool MockAuthority::loadScript(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        fprintf(stderr, "Cannot open %s\n", qPrintable(fileName));
+        return false;
+    }
+
+    QTextStream stream(&file);
+    int lineNumber = 0;
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+
+        const QStringList fields = line.split(QLatin1Char(' '), QString::SkipEmptyParts);
+        Script script;
+        bool ok = fields.count() >= 2;
+        ok = ok && parseResult(fields.at(1), &script.result);
+        if (ok && fields.count() >= 3) {
+            script.latency = fields.at(2).toInt(&ok);
+        }
+        if (!ok) {
+            fprintf(stderr, "%s:%d: expected \"action-id yes|no|challenge|hold [latency-msec [description]]\"\n",
+                    qPrintable(fileName), lineNumber);
+            return false;
+        }
+
+        m_script.insert(fields.at(0), script);
+        MockActionDescription action = mockAction(fields.at(0));
+        if (fields.count() > 3) {
+            // the rest of the line, so that tests can change an action
+            action.description = fields.mid(3).join(QLatin1Char(' '));
+        }
+        m_actions.append(action);
+    }
+    return true;
+}
+
+void MockAuthority::setDefault(Result result, int latency)
+{
+    m_default.result = result;
+    m_default.latency = latency;
+}
+
+void MockAuthority::setSyntheticActions(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        m_actions.append(mockAction(QString::fromLatin1("org.qt.policykit.mock.action%1").arg(i)));
+    }
+}
+
+QString MockAuthority::introspect(const QString &path) const
+{
+    Q_UNUSED(path);
+    return QLatin1String(
+        "  <interface name=\"org.freedesktop.PolicyKit1.Authority\">\n"
+        "    <method name=\"EnumerateActions\">\n"
+        "      <arg type=\"s\" name=\"locale\" direction=\"in\"/>\n"
+        "      <arg type=\"a(ssssssuuua{ss})\" name=\"action_descriptions\" direction=\"out\"/>\n"
+        "    </method>\n"
+        "    <method name=\"CheckAuthorization\">\n"
+        "      <arg type=\"(sa{sv})\" name=\"subject\" direction=\"in\"/>\n"
+        "      <arg type=\"s\" name=\"action_id\" direction=\"in\"/>\n"
+        "      <arg type=\"a{ss}\" name=\"details\" direction=\"in\"/>\n"
+        "      <arg type=\"u\" name=\"flags\" direction=\"in\"/>\n"
+        "      <arg type=\"s\" name=\"cancellation_id\" direction=\"in\"/>\n"
+        "      <arg type=\"(bba{ss})\" name=\"result\" direction=\"out\"/>\n"
+        "    </method>\n"
+        "    <method name=\"CancelCheckAuthorization\">\n"
+        "      <arg type=\"s\" name=\"cancellation_id\" direction=\"in\"/>\n"
+        "    </method>\n"
+        "    <signal name=\"Changed\"/>\n"
+        "    <property type=\"s\" name=\"BackendName\" access=\"read\"/>\n"
+        "    <property type=\"s\" name=\"BackendVersion\" access=\"read\"/>\n"
+        "    <property type=\"u\" name=\"BackendFeatures\" access=\"read\"/>\n"
+        "  </interface>\n");
+}
+
+bool MockAuthority::handleMessage(const QDBusMessage &message, const QDBusConnection &connection)
+{
+    if (message.interface() == QLatin1String(propertiesInterface)) {
+        properties(message, connection);
+        return true;
+    }
+
+    if (message.interface() != QLatin1String(authorityInterface) && !message.interface().isEmpty()) {
+        return false;
+    }
+
+    if (message.member() == QLatin1String("CheckAuthorization")) {
+        checkAuthorization(message, connection);
+    } else if (message.member() == QLatin1String("CancelCheckAuthorization")) {
+        cancelCheckAuthorization(message, connection);
+    } else if (message.member() == QLatin1String("EnumerateActions")) {
+        enumerateActions(message);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void MockAuthority::checkAuthorization(const QDBusMessage &message, const QDBusConnection &connection)
+{
+    if (message.signature() != QLatin1String("(sa{sv})sa{ss}us")) {
+        connection.send(message.createErrorReply(QLatin1String("org.freedesktop.PolicyKit1.Error.Failed"),
+                                                 QLatin1String("Unexpected signature ") + message.signature()));
+        return;
+    }
+
+    const QString actionId = message.arguments().at(1).toString();
+    const QString cancellationId = message.arguments().at(4).toString();
+    const Script script = m_script.value(actionId, m_default);
+    const QString cancellationKey = cancellationId.isEmpty() ? QString() :
+                                    message.service() + QLatin1Char('/') + cancellationId;
+
+    if (script.result == Hold) {
+        if (cancellationKey.isEmpty()) {
+            connection.send(message.createErrorReply(QLatin1String("org.freedesktop.PolicyKit1.Error.Failed"),
+                                                     QLatin1String("A held check needs a cancellation id")));
+        } else {
+            m_held.insert(cancellationKey, message);
+        }
+        return;
+    }
+
+    // (bba{ss}): is_authorized, is_challenge, details
+    QDBusArgument result;
+    result.beginStructure();
+    result << (script.result == Yes) << (script.result == Challenge);
+    result.beginMap(QVariant::String, QVariant::String);
+    result.endMap();
+    result.endStructure();
+
+    QDBusMessage checkReply = message.createReply();
+    checkReply << QVariant::fromValue(result);
+    reply(message, checkReply, script.latency, cancellationKey);
+}
+
+void MockAuthority::cancelCheckAuthorization(const QDBusMessage &message, const QDBusConnection &connection)
+{
+    const QString cancellationKey = message.service() + QLatin1Char('/') + message.arguments().value(0).toString();
+    const QString cancelledName = QLatin1String("org.freedesktop.PolicyKit1.Error.Cancelled");
+    const QString cancelledMessage = QLatin1String("The authentication was cancelled");
+
+    bool found = false;
+    if (m_held.contains(cancellationKey)) {
+        connection.send(m_held.take(cancellationKey).createErrorReply(cancelledName, cancelledMessage));
+        found = true;
+    } else {
+        QMultiMap<qint64, PendingReply>::iterator it = m_pending.begin();
+        for (; it != m_pending.end(); ++it) {
+            if (it.value().cancellationKey == cancellationKey && it.value().reply.type() != QDBusMessage::InvalidMessage) {
+                connection.send(it.value().call.createErrorReply(cancelledName, cancelledMessage));
+                it.value().reply = QDBusMessage();
+                found = true;
+            }
+        }
+    }
+
+    if (found) {
+        connection.send(message.createReply());
+    } else {
+        connection.send(message.createErrorReply(QLatin1String("org.freedesktop.PolicyKit1.Error.Failed"),
+                                                 QLatin1String("No such authentication")));
+    }
+}
+
+void MockAuthority::enumerateActions(const QDBusMessage &message)
+{
+    QDBusMessage actionsReply = message.createReply();
+    actionsReply << QVariant::fromValue(m_actions);
+    reply(message, actionsReply, m_default.latency, QString());
+}
+
+void MockAuthority::properties(const QDBusMessage &message, const QDBusConnection &connection)
+{
+    QVariantMap properties;
+    properties.insert(QLatin1String("BackendName"), QLatin1String("polkit-qt-mockpolkitd"));
+    properties.insert(QLatin1String("BackendVersion"), QLatin1String("0.1"));
+    properties.insert(QLatin1String("BackendFeatures"), QVariant::fromValue<uint>(0));
+
+    if (message.member() == QLatin1String("GetAll")) {
+        connection.send(message.createReply(properties));
+    } else if (message.member() == QLatin1String("Get") && properties.contains(message.arguments().value(1).toString())) {
+        const QVariant value = properties.value(message.arguments().value(1).toString());
+        connection.send(message.createReply(QVariant::fromValue(QDBusVariant(value))));
+    } else {
+        connection.send(message.createErrorReply(QLatin1String("org.freedesktop.DBus.Error.InvalidArgs"),
+                                                 QLatin1String("No such property")));
+    }
+}
+
+void MockAuthority::reply(const QDBusMessage &call, const QDBusMessage &reply, int latency,
+                          const QString &cancellationKey)
+{
+    if (latency <= 0) {
+        QDBusConnection::systemBus().send(reply);
+        return;
+    }
+
+    PendingReply pending;
+    pending.call = call;
+    pending.reply = reply;
+    pending.cancellationKey = cancellationKey;
+    m_pending.insert(m_clock.elapsed() + latency, pending);
+    rescheduleTimer();
+}
+
+void MockAuthority::sendDueReplies()
+{
+    const qint64 now = m_clock.elapsed();
+    while (!m_pending.isEmpty() && m_pending.begin().key() <= now) {
+        const PendingReply pending = m_pending.take(m_pending.begin().key());
+        // cancelled replies are left behind with an invalid message
+        if (pending.reply.type() != QDBusMessage::InvalidMessage) {
+            QDBusConnection::systemBus().send(pending.reply);
+        }
+    }
+    rescheduleTimer();
+}
+
+void MockAuthority::rescheduleTimer()
+{
+    if (m_pending.isEmpty()) {
+        m_timer.stop();
+    } else {
+        m_timer.start(qMax<qint64>(0, m_pending.begin().key() - m_clock.elapsed()));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(QLatin1String("polkit-qt-mockpolkitd"));
+
+    qDBusRegisterMetaType<MockActionDescription>();
+    qDBusRegisterMetaType<QList<MockActionDescription> >();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QLatin1String("Scripted polkit authority for tests and benchmarks"));
+    parser.addHelpOption();
+    QCommandLineOption scriptOption(QLatin1String("script"),
+                                    QLatin1String("Lines of \"action-id yes|no|challenge|hold [latency-msec [description]]\"."),
+                                    QLatin1String("file"));
+    QCommandLineOption resultOption(QLatin1String("default-result"),
+                                    QLatin1String("Result of the actions which are not in the script."),
+                                    QLatin1String("result"), QLatin1String("no"));
+    QCommandLineOption latencyOption(QLatin1String("latency"),
+                                     QLatin1String("Latency of the actions which are not in the script."),
+                                     QLatin1String("msec"), QLatin1String("0"));
+    QCommandLineOption actionsOption(QLatin1String("actions"),
+                                     QLatin1String("Number of synthetic actions returned by EnumerateActions."),
+                                     QLatin1String("count"), QLatin1String("0"));
+    parser.addOption(scriptOption);
+    parser.addOption(resultOption);
+    parser.addOption(latencyOption);
+    parser.addOption(actionsOption);
+    parser.process(app);
+
+    MockAuthority authority;
+    MockAuthority::Result result;
+    if (!parseResult(parser.value(resultOption), &result)) {
+        fprintf(stderr, "Invalid default result %s\n", qPrintable(parser.value(resultOption)));
+        return 1;
+    }
+    authority.setDefault(result, parser.value(latencyOption).toInt());
+    if (parser.isSet(scriptOption) && !authority.loadScript(parser.value(scriptOption))) {
+        return 1;
+    }
+    authority.setSyntheticActions(parser.value(actionsOption).toInt());
+
+    // DBUS_SYSTEM_BUS_ADDRESS decides which bus this is
+    QDBusConnection bus = QDBusConnection::systemBus();
+    if (!bus.registerVirtualObject(QLatin1String(authorityPath), &authority)) {
+        fprintf(stderr, "Cannot register the authority: %s\n", qPrintable(bus.lastError().message()));
+        return 1;
+    }
+    if (!bus.registerService(QLatin1String(polkitService))) {
+        fprintf(stderr, "Cannot own %s: %s\n", polkitService, qPrintable(bus.lastError().message()));
+        return 1;
+    }
+
+    return app.exec();
+}
+
+#include "moc_mockpolkitd.cpp"
@@ -0,0 +1,123 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef MOCKPOLKITD_H
+#define MOCKPOLKITD_H
+
+#include <QtCore/QHash>
+#include <QtCore/QMultiMap>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMetaType>
+#include <QtCore/QTimer>
+#include <QtDBus/QDBusArgument>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusVirtualObject>
+
+/**
+ * One entry of the reply of EnumerateActions, (ssssssuuua{ss})
+ */
+struct MockActionDescription
+{
+    MockActionDescription() : implicitAny(0), implicitInactive(0), implicitActive(0) {}
+
+    QString actionId;
+    QString description;
+    QString message;
+    QString vendorName;
+    QString vendorUrl;
+    QString iconName;
+    uint implicitAny;
+    uint implicitInactive;
+    uint implicitActive;
+    QMap<QString, QString> annotations;
+};
+Q_DECLARE_METATYPE(MockActionDescription)
+Q_DECLARE_METATYPE(QList<MockActionDescription>)
+
+QDBusArgument &operator<<(QDBusArgument &argument, const MockActionDescription &action);
+const QDBusArgument &operator>>(const QDBusArgument &argument, MockActionDescription &action);
+
+/**
+ * Scripted org.freedesktop.PolicyKit1.Authority
+ *
+ * Every action answers with the result given by the script, after the given
+ * latency. Actions which are not in the script answer with the default result.
+ * A "hold" result never answers, until the check is cancelled.
+ */
+class MockAuthority : public QDBusVirtualObject
+{
+    Q_OBJECT
+public:
+    enum Result {
+        Yes,
+        No,
+        Challenge,
+        Hold
+    };
+
+    struct Script {
+        Script() : result(No), latency(0) {}
+
+        Result result;
+        int latency;
+    };
+
+    explicit MockAuthority(QObject *parent = 0);
+
+    /** Reads the "action-id result [latency-msec [description]]" lines of \p fileName */
+    bool loadScript(const QString &fileName);
+    void setDefault(Result result, int latency);
+    /** Adds \p count synthetic actions to the reply of EnumerateActions */
+    void setSyntheticActions(int count);
+
+    QString introspect(const QString &path) const;
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection);
+
+private Q_SLOTS:
+    void sendDueReplies();
+
+private:
+    struct PendingReply {
+        QDBusMessage call;
+        QDBusMessage reply;
+        QString cancellationKey;
+    };
+
+    void checkAuthorization(const QDBusMessage &message, const QDBusConnection &connection);
+    void cancelCheckAuthorization(const QDBusMessage &message, const QDBusConnection &connection);
+    void enumerateActions(const QDBusMessage &message);
+    void properties(const QDBusMessage &message, const QDBusConnection &connection);
+    void reply(const QDBusMessage &call, const QDBusMessage &reply, int latency, const QString &cancellationKey);
+    void rescheduleTimer();
+
+    QHash<QString, Script> m_script;
+    Script m_default;
+    QList<MockActionDescription> m_actions;
+
+    // replies waiting for their latency to expire, by due time in msecs
+    QMultiMap<qint64, PendingReply> m_pending;
+    // checks on hold, by cancellation key
+    QHash<QString, QDBusMessage> m_held;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+};
+
+#endif // MOCKPOLKITD_H
@@ -0,0 +1,123 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "privatebus.h"
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusConnectionInterface>
+
+PrivateBus::PrivateBus()
+        : m_latency(0)
+        , m_syntheticActions(0)
+{
+}
+
+PrivateBus::~PrivateBus()
+{
+    if (m_mock.state() != QProcess::NotRunning) {
+        m_mock.terminate();
+        m_mock.waitForFinished();
+    }
+    if (m_daemon.state() != QProcess::NotRunning) {
+        m_daemon.terminate();
+        m_daemon.waitForFinished();
+    }
+}
+
+bool PrivateBus::setScript(const QByteArray &script)
+{
+    if (!m_script.isOpen() && !m_script.open()) {
+        qWarning("Cannot create the script of the mock authority");
+        return false;
+    }
+    m_script.resize(0);
+    m_script.seek(0);
+    m_script.write(script);
+    return m_script.flush();
+}
+
+void PrivateBus::setLatency(int msec)
+{
+    m_latency = msec;
+}
+
+void PrivateBus::setSyntheticActions(int count)
+{
+    m_syntheticActions = count;
+}
+
+bool PrivateBus::start()
+{
+    m_daemon.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    m_daemon.start(QLatin1String("dbus-daemon"),
+                   QStringList() << QLatin1String("--session") << QLatin1String("--nofork")
+                                 << QLatin1String("--print-address=1"));
+    if (!m_daemon.waitForStarted() || !m_daemon.waitForReadyRead()) {
+        qWarning("Cannot start dbus-daemon");
+        return false;
+    }
+    const QByteArray address = m_daemon.readLine().trimmed();
+    qputenv("DBUS_SYSTEM_BUS_ADDRESS", address);
+
+    if (!m_script.isOpen() && !setScript(QByteArray())) {
+        return false;
+    }
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(QLatin1String("DBUS_SYSTEM_BUS_ADDRESS"), QString::fromLatin1(address));
+    m_mock.setProcessEnvironment(environment);
+    m_mock.setProcessChannelMode(QProcess::ForwardedChannels);
+    return startAuthority() && waitForAuthority();
+}
+
+bool PrivateBus::startAuthority()
+{
+    m_mock.start(QLatin1String(MOCK_POLKITD_EXECUTABLE),
+                 QStringList() << QLatin1String("--script") << m_script.fileName()
+                               << QLatin1String("--latency") << QString::number(m_latency)
+                               << QLatin1String("--actions") << QString::number(m_syntheticActions));
+    if (!m_mock.waitForStarted()) {
+        qWarning("Cannot start %s", MOCK_POLKITD_EXECUTABLE);
+        return false;
+    }
+    return true;
+}
+
+bool PrivateBus::waitForAuthority()
+{
+    // the authority fails without the mock on the bus
+    QDBusConnectionInterface *bus = QDBusConnection::systemBus().interface();
+    for (int i = 0; i < 500; ++i) {
+        if (bus->isServiceRegistered(QLatin1String("org.freedesktop.PolicyKit1"))) {
+            return true;
+        }
+        if (m_mock.waitForFinished(10)) {
+            break;
+        }
+    }
+    qWarning("The mock authority did not show up on the bus");
+    return false;
+}
+
+void PrivateBus::stopAuthority()
+{
+    m_mock.terminate();
+    m_mock.waitForFinished();
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is part of the Polkit-qt project
+ * Copyright (C) 2026 Polkit-qt developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef PRIVATEBUS_H
+#define PRIVATEBUS_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QProcess>
+#include <QtCore/QTemporaryFile>
+
+/**
+ * A dbus-daemon of its own with polkit-qt-mockpolkitd on it, used as the
+ * system bus of this process
+ */
+class PrivateBus
+{
+public:
+    PrivateBus();
+    ~PrivateBus();
+
+    /**
+     * Sets the script of the mock authority, in the format of its --script
+     * option; it is used from the next start of the authority on
+     */
+    bool setScript(const QByteArray &script);
+    /** Sets the latency of the actions which are not in the script, 0 by default */
+    void setLatency(int msec);
+    /** Sets the number of synthetic actions the mock authority enumerates, 0 by default */
+    void setSyntheticActions(int count);
+
+    /** Starts the bus and the mock authority, must be called before the first use of the system bus */
+    bool start();
+    /** Starts the mock authority again after stopAuthority(), without waiting for it to be on the bus */
+    bool startAuthority();
+    /** Waits until the mock authority owns its name on the bus */
+    bool waitForAuthority();
+    /** Stops the mock authority, as a restart of polkitd would */
+    void stopAuthority();
+
+private:
+    QProcess m_daemon;
+    QProcess m_mock;
+    QTemporaryFile m_script;
+    int m_latency;
+    int m_syntheticActions;
+};
+
+#endif // PRIVATEBUS_H
@@ -2,11 +2,21 @@
 
 #include "test.h"
 #include "core/polkitqt1-authority.h"
+#include "core/polkitqt1-actioncatalog.h"
+#include "core/polkitqt1-pendingauthorization.h"
+#include "core/polkitqt1-pendingrevocation.h"
+#include "core/polkitqt1-pendingactions.h"
+#include "core/polkitqt1-authorizationmatrix.h"
+#include "core/polkitqt1-authorizationwatch.h"
+#include "core/polkitqt1-temporaryauthorizationwatch.h"
+#include "core/polkitqt1-authoritymetrics.h"
 #include "agent/polkitqt1-agent-session.h"
 #include "core/polkitqt1-details.h"
 #include <stdlib.h>
 #include <unistd.h>
 #include <pwd.h>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThreadPool>
 #include <QtDBus/QDBusMessage>
 #include <QtDBus/QDBusConnection>
 using namespace PolkitQt1;
@@ -20,6 +30,26 @@ void wait()
     }
 }
 
+void TestAuth::test_Auth_asyncInit()
+{
+    // This has to run first, before anything creates the authority
+    Authority::setAsynchronousInitialization(true);
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    QSignalSpy spy(authority, SIGNAL(checkAuthorizationFinished(PolkitQt1::Authority::Result)));
+
+    // The check is queued until the authority is ready
+    authority->checkAuthorization("org.qt.policykit.examples.kick", process, Authority::None);
+    for (int i = 0; i < 100 && spy.count() == 0; i++) {
+        wait();
+    }
+    QVERIFY(authority->isReady());
+    QCOMPARE(spy.count(), 1);
+    Authority::Result result = qVariantValue<PolkitQt1::Authority::Result> (spy.takeFirst()[0]);
+    QCOMPARE(result, Authority::No);
+    QVERIFY(!authority->hasError());
+}
+
 void TestAuth::test_Auth_checkAuthorization()
 {
     // This needs the file org.qt.policykit.examples.policy from examples to be installed
@@ -69,6 +99,357 @@ void TestAuth::test_Auth_checkAuthorization()
     qWarning() << "You should see an authentication dialog for a short period.";
 }
 
+void TestAuth::test_Auth_cache()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    authority->setCachingEnabled(true);
+    QVERIFY(authority->isCachingEnabled());
+
+    quint64 hits = authority->cacheHits();
+    quint64 misses = authority->cacheMisses();
+    // The first check has to ask polkit, the second one is answered from the cache
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.examples.kick", process, Authority::None), Authority::No);
+    QCOMPARE(authority->cacheMisses(), misses + 1);
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.examples.kick", process, Authority::None), Authority::No);
+    QCOMPARE(authority->cacheHits(), hits + 1);
+    QVERIFY(!authority->hasError());
+
+    // Asynchronous checks are served from the cache as well
+    QSignalSpy spy(authority, SIGNAL(checkAuthorizationFinished(PolkitQt1::Authority::Result)));
+    authority->checkAuthorization("org.qt.policykit.examples.kick", process, Authority::None);
+    wait();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(qVariantValue<PolkitQt1::Authority::Result> (spy.takeFirst()[0]), Authority::No);
+    QCOMPARE(authority->cacheHits(), hits + 2);
+
+    // Flushing the cache forces a new round trip
+    authority->clearCache();
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.examples.kick", process, Authority::None), Authority::No);
+    QCOMPARE(authority->cacheMisses(), misses + 2);
+
+    authority->setCachingEnabled(false);
+}
+
+void TestAuth::test_Auth_pendingAuthorization()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    // Several checks in flight at once, each one answering its own request
+    PendingAuthorization *kick = authority->checkAuthorizationAsync("org.qt.policykit.examples.kick", process, Authority::None);
+    PendingAuthorization *cry = authority->checkAuthorizationAsync("org.qt.policykit.examples.cry", process, Authority::None);
+    PendingAuthorization *bleed = authority->checkAuthorizationAsync("org.qt.policykit.examples.bleed", process, Authority::None);
+    QVERIFY(kick->id() != cry->id());
+    QSignalSpy spy(cry, SIGNAL(finished(PolkitQt1::PendingAuthorization*)));
+
+    // Cancelling one of them must not affect the others
+    kick->cancel();
+    wait();
+    QVERIFY(kick->isFinished());
+    QVERIFY(kick->isCancelled());
+    QCOMPARE(kick->result(), Authority::Unknown);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(cry->result(), Authority::Yes);
+    QCOMPARE(bleed->result(), Authority::Challenge);
+    QVERIFY(!cry->hasError());
+    QVERIFY(!authority->hasError());
+    delete kick;
+    delete cry;
+    delete bleed;
+
+    // The legacy cancellable is renewed, so a check started after a cancel still works
+    QSignalSpy legacySpy(authority, SIGNAL(checkAuthorizationFinished(PolkitQt1::Authority::Result)));
+    authority->checkAuthorization("org.qt.policykit.examples.kick", process, Authority::None);
+    authority->checkAuthorizationCancel();
+    authority->checkAuthorization("org.qt.policykit.examples.kick", process, Authority::None);
+    wait();
+    QCOMPARE(legacySpy.count(), 1);
+
+    // Invalid subjects are reported on the handle, not on the authority
+    PendingAuthorization *invalid = authority->checkAuthorizationAsync("org.qt.policykit.examples.kick", Subject(), Authority::None);
+    wait();
+    QVERIFY(invalid->isFinished());
+    QCOMPARE(invalid->error(), Authority::E_WrongSubject);
+    QVERIFY(!authority->hasError());
+    delete invalid;
+}
+
+void TestAuth::test_Auth_coalescing()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    QVERIFY(authority->isCheckCoalescingEnabled());
+    const quint64 coalesced = authority->coalescedChecks();
+
+    // Identical checks in flight at the same time share a single request
+    QList<PendingAuthorization *> requests;
+    for (int i = 0; i < 4; i++) {
+        requests << authority->checkAuthorizationAsync("org.qt.policykit.examples.cry", process, Authority::None);
+    }
+    QCOMPARE(authority->coalescedChecks(), coalesced + 3);
+
+    // Cancelling one of the callers leaves the others waiting
+    requests.first()->cancel();
+    for (int i = 0; i < 100 && !requests.last()->isFinished(); i++) {
+        wait();
+    }
+    QVERIFY(requests.first()->isCancelled());
+    for (int i = 1; i < requests.count(); i++) {
+        QVERIFY(requests.at(i)->isFinished());
+        QCOMPARE(requests.at(i)->result(), Authority::Yes);
+    }
+    qDeleteAll(requests);
+
+    // Nothing is remembered once the check is over
+    authority->checkAuthorizationSync("org.qt.policykit.examples.cry", process, Authority::None);
+    QCOMPARE(authority->coalescedChecks(), coalesced + 3);
+
+    authority->setCheckCoalescingEnabled(false);
+    PendingAuthorization *first = authority->checkAuthorizationAsync("org.qt.policykit.examples.cry", process, Authority::None);
+    PendingAuthorization *second = authority->checkAuthorizationAsync("org.qt.policykit.examples.cry", process, Authority::None);
+    QCOMPARE(authority->coalescedChecks(), coalesced + 3);
+    delete first;
+    delete second;
+    authority->setCheckCoalescingEnabled(true);
+}
+
+void TestAuth::test_Auth_timeout()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    QCOMPARE(authority->defaultTimeout(), -1);
+
+    // A generous deadline does not change the answer
+    authority->setDefaultTimeout(5000);
+    QCOMPARE(authority->defaultTimeout(), 5000);
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.examples.cry", process, Authority::None), Authority::Yes);
+    QVERIFY(!authority->hasError());
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.examples.kick", process, Authority::None, 5000), Authority::No);
+    QVERIFY(!authority->hasError());
+
+    // Negative values disable the deadline again
+    authority->setDefaultTimeout(-10);
+    QCOMPARE(authority->defaultTimeout(), -1);
+}
+
+void TestAuth::test_Auth_lanes()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    QCOMPARE(authority->interactiveCheckLimit(), 4);
+    QCOMPARE(authority->backgroundCheckLimit(), 64);
+    authority->setBackgroundCheckLimit(2);
+    const quint64 queued = authority->metrics().queuedChecks(AuthorityMetrics::BackgroundLane);
+
+    // The checks over the limit wait for a free slot
+    QList<PendingAuthorization *> requests;
+    for (int i = 0; i < 6; i++) {
+        requests << authority->checkAuthorizationAsync("org.qt.policykit.examples.cry", process, Authority::None);
+    }
+    AuthorityMetrics metrics = authority->metrics();
+    QCOMPARE(metrics.checksInFlight(AuthorityMetrics::BackgroundLane), quint64(2));
+    QCOMPARE(metrics.queueDepth(AuthorityMetrics::BackgroundLane), quint64(4));
+    QCOMPARE(metrics.queuedChecks(AuthorityMetrics::BackgroundLane), queued + 4);
+    QCOMPARE(metrics.queueDepth(AuthorityMetrics::InteractiveLane), quint64(0));
+
+    // A check cancelled while waiting does not wait for a slot
+    requests.last()->cancel();
+    for (int i = 0; i < 100 && !requests.at(4)->isFinished(); i++) {
+        wait();
+    }
+    QVERIFY(requests.last()->isCancelled());
+    for (int i = 0; i < requests.count() - 1; i++) {
+        QVERIFY(requests.at(i)->isFinished());
+        QCOMPARE(requests.at(i)->result(), Authority::Yes);
+    }
+    qDeleteAll(requests);
+
+    metrics = authority->metrics();
+    QCOMPARE(metrics.checksInFlight(AuthorityMetrics::BackgroundLane), quint64(0));
+    QCOMPARE(metrics.queueDepth(AuthorityMetrics::BackgroundLane), quint64(0));
+    QVERIFY(metrics.maxQueueDepth(AuthorityMetrics::BackgroundLane) >= 4);
+    QVERIFY(metrics.toPrometheusText().contains("polkitqt1_lane_queue_depth{lane=\"background\"} 0\n"));
+    authority->setBackgroundCheckLimit(64);
+}
+
+void TestAuth::test_Auth_checkAuthorizations()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    QStringList actions;
+    actions << "org.qt.policykit.examples.kick"
+            << "org.qt.policykit.examples.cry"
+            << "org.qt.policykit.examples.bleed";
+    QList<Subject> subjects;
+    subjects << UnixProcessSubject(QCoreApplication::applicationPid()) << Subject();
+    Authority *authority = Authority::instance();
+    authority->setBulkCheckWindow(2);
+
+    AuthorizationMatrix matrix = authority->checkAuthorizationsSync(actions, subjects, Authority::None);
+    QCOMPARE(matrix.rowCount(), 3);
+    QCOMPARE(matrix.columnCount(), 2);
+    QCOMPARE(matrix.result(0, 0), Authority::No);
+    QCOMPARE(matrix.result(1, 0), Authority::Yes);
+    QCOMPARE(matrix.result("org.qt.policykit.examples.bleed"), Authority::Challenge);
+    // The invalid subject fails in every row without affecting the others
+    QCOMPARE(matrix.errorCount(), 3);
+    QVERIFY(!matrix.hasError(2, 0));
+    QCOMPARE(matrix.error(2, 1), Authority::E_WrongSubject);
+    QCOMPARE(matrix.result(2, 1), Authority::Unknown);
+    QVERIFY(!authority->hasError());
+
+    // Asynchronous version
+    PendingAuthorizationMatrix *pending = authority->checkAuthorizations(actions, subjects, Authority::None);
+    QSignalSpy spy(pending, SIGNAL(finished(PolkitQt1::PendingAuthorizationMatrix*)));
+    wait();
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(pending->isFinished());
+    QCOMPARE(pending->matrix().result(0, 0), Authority::No);
+    QCOMPARE(pending->matrix().result(1, 0), Authority::Yes);
+    QCOMPARE(pending->matrix().result(2, 0), Authority::Challenge);
+    delete pending;
+
+    authority->setBulkCheckWindow(32);
+}
+
+void TestAuth::test_Auth_watch()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    QStringList actions;
+    actions << "org.qt.policykit.examples.kick"
+            << "org.qt.policykit.examples.cry";
+    QList<Subject> subjects;
+    subjects << UnixProcessSubject(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    AuthorizationWatch *watch = authority->watchAuthorizations(actions, subjects);
+    QSignalSpy resultSpy(watch, SIGNAL(resultChanged(QString,int,PolkitQt1::Authority::Result)));
+    QSignalSpy changedSpy(watch, SIGNAL(changed(PolkitQt1::AuthorizationWatch*)));
+    QVERIFY(!watch->isReady());
+    QCOMPARE(watch->matrix().result(0, 0), Authority::Unknown);
+
+    // The first check reports every known result
+    for (int i = 0; i < 100 && !watch->isReady(); i++) {
+        wait();
+    }
+    QVERIFY(watch->isReady());
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(resultSpy.count(), 2);
+    QCOMPARE(resultSpy.at(0).at(0).toString(), QString("org.qt.policykit.examples.kick"));
+    QCOMPARE(watch->matrix().result("org.qt.policykit.examples.kick"), Authority::No);
+    QCOMPARE(watch->matrix().result("org.qt.policykit.examples.cry"), Authority::Yes);
+
+    // Checking again without any change reports nothing
+    watch->refresh();
+    for (int i = 0; i < 10; i++) {
+        wait();
+    }
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(resultSpy.count(), 2);
+    delete watch;
+}
+
+void TestAuth::test_Auth_temporaryWatch()
+{
+    // polkitd only keeps temporary authorizations per session
+    UnixSessionSubject session(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    TemporaryAuthorizationWatch *watch = authority->watchTemporaryAuthorizations(session);
+    QSignalSpy changedSpy(watch, SIGNAL(changed(PolkitQt1::TemporaryAuthorizationWatch*)));
+    QSignalSpy addedSpy(watch, SIGNAL(added(PolkitQt1::TemporaryAuthorization)));
+    QVERIFY(!watch->isReady());
+
+    // Nothing obtained any temporary authorization, so the first listing is empty
+    for (int i = 0; i < 100 && !watch->isReady(); i++) {
+        wait();
+    }
+    QVERIFY(watch->isReady());
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(addedSpy.count(), 0);
+    QVERIFY(watch->authorizations().isEmpty());
+
+    // Revoking through the authority lists them again, and nothing changed
+    QVERIFY(authority->revokeTemporaryAuthorizationsSync(session));
+    for (int i = 0; i < 10; i++) {
+        wait();
+    }
+    QCOMPARE(changedSpy.count(), 1);
+    QVERIFY(!authority->hasError());
+    delete watch;
+}
+
+void TestAuth::test_Auth_bulkRevoke()
+{
+    Authority *authority = Authority::instance();
+    QList<Subject> subjects;
+    subjects << UnixSessionSubject(QCoreApplication::applicationPid()) << Subject();
+
+    // Every subject gets its own result
+    PendingRevocation *revocation = authority->revokeTemporaryAuthorizations(subjects);
+    QSignalSpy spy(revocation, SIGNAL(finished(PolkitQt1::PendingRevocation*)));
+    QCOMPARE(revocation->count(), 2);
+    for (int i = 0; i < 100 && spy.count() == 0; i++) {
+        wait();
+    }
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(revocation->isRevoked(0));
+    QCOMPARE(revocation->error(0), Authority::E_None);
+    QVERIFY(!revocation->isRevoked(1));
+    QCOMPARE(revocation->error(1), Authority::E_WrongSubject);
+    QCOMPARE(revocation->revokedCount(), 1);
+    QCOMPARE(revocation->errorCount(), 1);
+    QVERIFY(revocation->elapsed() >= 0);
+    delete revocation;
+
+    // Unknown ids fail one by one, and do not put the authority in error state
+    QStringList ids;
+    ids << "no-such-authorization-1" << "no-such-authorization-2" << "no-such-authorization-3";
+    authority->setBulkCheckWindow(2);
+    revocation = authority->revokeTemporaryAuthorizationsById(ids);
+    QSignalSpy idSpy(revocation, SIGNAL(finished(PolkitQt1::PendingRevocation*)));
+    for (int i = 0; i < 100 && idSpy.count() == 0; i++) {
+        wait();
+    }
+    QCOMPARE(idSpy.count(), 1);
+    QCOMPARE(revocation->errorCount(), 3);
+    QCOMPARE(revocation->error(2), Authority::E_RevokeFailed);
+    QVERIFY(!authority->hasError());
+    delete revocation;
+    authority->setBulkCheckWindow(32);
+}
+
+void TestAuth::test_Auth_metrics()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    authority->setCachingEnabled(false);
+    authority->resetMetrics();
+
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.examples.kick", process, Authority::None), Authority::No);
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.examples.cry", process, Authority::None), Authority::Yes);
+    authority->checkAuthorizationSync("org.qt.policykit.examples.kick", Subject(), Authority::None);
+    authority->clearError();
+
+    AuthorityMetrics metrics = authority->metrics();
+    QCOMPARE(metrics.calls(AuthorityMetrics::CheckAuthorizationSync), quint64(3));
+    QCOMPARE(metrics.completed(AuthorityMetrics::CheckAuthorizationSync), quint64(3));
+    QCOMPARE(metrics.errors(AuthorityMetrics::CheckAuthorizationSync), quint64(1));
+    QCOMPARE(metrics.calls(AuthorityMetrics::EnumerateActionsSync), quint64(0));
+    QVERIFY(metrics.p50(AuthorityMetrics::CheckAuthorizationSync) <= metrics.p999(AuthorityMetrics::CheckAuthorizationSync));
+    QVERIFY(metrics.p999(AuthorityMetrics::CheckAuthorizationSync) > 0);
+    QVERIFY(metrics.toPrometheusText().contains("polkitqt1_operation_calls_total{operation=\"checkAuthorizationSync\"} 3\n"));
+
+    authority->resetMetrics();
+    QCOMPARE(authority->metrics().calls(AuthorityMetrics::CheckAuthorizationSync), quint64(0));
+}
+
 void TestAuth::test_Auth_enumerateActions()
 {
     // This needs the file org.qt.policykit.examples.policy from examples to be installed
@@ -111,6 +492,156 @@ void TestAuth::test_Auth_enumerateActions()
     QVERIFY(!Authority::instance()->hasError());
 }
 
+void TestAuth::test_Auth_enumerateActionsStreamed()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    const int total = Authority::instance()->enumerateActionsSync().size();
+    QVERIFY(total >= 3);
+
+    // The actions come in chunks, then finished() follows
+    PendingActions *request = Authority::instance()->enumerateActionsStreamed(2);
+    QSignalSpy chunkSpy(request, SIGNAL(actionsReady(PolkitQt1::ActionDescription::List)));
+    QSignalSpy finishedSpy(request, SIGNAL(finished(PolkitQt1::PendingActions*)));
+    for (int i = 0; i < 100 && finishedSpy.count() == 0; i++) {
+        wait();
+    }
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(!request->hasError());
+    QVERIFY(!request->isCancelled());
+    QCOMPARE(request->count(), total);
+    QCOMPARE(chunkSpy.count(), (total + 1) / 2);
+    QStringList ids;
+    for (int i = 0; i < chunkSpy.count(); i++) {
+        ActionDescription::List chunk = qVariantValue<PolkitQt1::ActionDescription::List> (chunkSpy.at(i)[0]);
+        QVERIFY(chunk.size() <= 2);
+        Q_FOREACH(const ActionDescription &ad, chunk) {
+            ids << ad.actionId();
+        }
+    }
+    QVERIFY(ids.contains("org.qt.policykit.examples.kick"));
+    delete request;
+
+    // Cancelling stops the delivery and still finishes
+    request = Authority::instance()->enumerateActionsStreamed(1);
+    QSignalSpy cancelledSpy(request, SIGNAL(finished(PolkitQt1::PendingActions*)));
+    request->cancel();
+    for (int i = 0; i < 100 && cancelledSpy.count() == 0; i++) {
+        wait();
+    }
+    QCOMPARE(cancelledSpy.count(), 1);
+    QVERIFY(request->isCancelled());
+    QVERIFY(!request->hasError());
+    QVERIFY(request->count() < total);
+    delete request;
+
+    // A request deleted by the receiver of its first chunk stops there
+    request = Authority::instance()->enumerateActionsStreamed(1);
+    QPointer<PendingActions> guard(request);
+    connect(request, SIGNAL(actionsReady(PolkitQt1::ActionDescription::List)), this, SLOT(deleteSender()));
+    for (int i = 0; i < 100 && !guard.isNull(); i++) {
+        wait();
+    }
+    QVERIFY(guard.isNull());
+    // the chunk it had queued is dropped along with it
+    wait();
+    QVERIFY(!Authority::instance()->hasError());
+}
+
+void TestAuth::deleteSender()
+{
+    delete sender();
+}
+
+void TestAuth::test_Auth_actionCatalog()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    ActionCatalog *catalog = Authority::instance()->actionCatalog();
+    // Not the snapshot of the user, which a previous run may have left
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString defaultPath = catalog->snapshotPath();
+    const QString snapshotPath = dir.path() + QString("/actions.snapshot");
+    catalog->setSnapshotPath(snapshotPath);
+    QVERIFY(catalog->contains("org.qt.policykit.examples.kick"));
+    QVERIFY(catalog->isLoaded());
+    QVERIFY(!catalog->contains("org.qt.policykit.examples.nonexistent"));
+    QCOMPARE(catalog->action("org.qt.policykit.examples.kick").actionId(), QString("org.qt.policykit.examples.kick"));
+    QVERIFY(catalog->action("org.qt.policykit.examples.nonexistent").actionId().isEmpty());
+    QCOMPARE(catalog->actionIds().size(), catalog->count());
+
+    // The descriptions of the catalog read their strings from its snapshot,
+    // and are the same as the enumerated ones
+    Q_FOREACH(const ActionDescription &ad, Authority::instance()->enumerateActionsSync()) {
+        QCOMPARE(catalog->action(ad.actionId()), ad);
+        QCOMPARE(catalog->action(ad.actionId()).message(), ad.message());
+    }
+
+    // The actions sharing a prefix come sorted
+    ActionDescription::List examples = catalog->actionsWithPrefix("org.qt.policykit.examples.");
+    QVERIFY(examples.size() >= 3);
+    for (int i = 1; i < examples.size(); ++i) {
+        QVERIFY(examples.at(i - 1).actionId() < examples.at(i).actionId());
+    }
+    QVERIFY(catalog->actionsWithPrefix("org.qt.policykit.examples.nonexistent").isEmpty());
+
+    QStringList kde;
+    Q_FOREACH(const ActionDescription &ad, catalog->actionsByVendor("KDE")) {
+        kde << ad.actionId();
+    }
+    QVERIFY(kde.contains("org.qt.policykit.examples.kick"));
+
+    QStringList authorized;
+    Q_FOREACH(const ActionDescription &ad, catalog->actionsWithImplicitAuthorization(ActionCatalog::ImplicitActive,
+                                                                                    ActionDescription::Authorized)) {
+        authorized << ad.actionId();
+    }
+    QVERIFY(authorized.contains("org.qt.policykit.examples.cry"));
+    QVERIFY(!authorized.contains("org.qt.policykit.examples.kick"));
+
+    // Refreshing loads the actions again in the background, and reports no difference
+    QSignalSpy spy(catalog, SIGNAL(loaded(PolkitQt1::ActionCatalog*)));
+    QSignalSpy addedSpy(catalog, SIGNAL(actionsAdded(PolkitQt1::ActionDescription::List)));
+    QSignalSpy removedSpy(catalog, SIGNAL(actionsRemoved(PolkitQt1::ActionDescription::List)));
+    QSignalSpy changedSpy(catalog, SIGNAL(actionsChanged(PolkitQt1::ActionDescription::List)));
+    catalog->refresh();
+    for (int i = 0; i < 100 && spy.count() == 0; i++) {
+        wait();
+    }
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(addedSpy.count(), 0);
+    QCOMPARE(removedSpy.count(), 0);
+    QCOMPARE(changedSpy.count(), 0);
+    QVERIFY(catalog->contains("org.qt.policykit.examples.kick"));
+
+    // Every enumeration is saved for the next processes, from the thread pool
+    QThreadPool::globalInstance()->waitForDone();
+    QFile snapshot(snapshotPath);
+    QVERIFY(snapshot.open(QIODevice::ReadOnly));
+    const QByteArray bytes = snapshot.readAll();
+    snapshot.close();
+    QCOMPARE(bytes.left(8), QByteArray("PKQTACT", 8));
+
+    // A copy of it is mapped by the next lookup, and describes the same actions
+    const ActionDescription::List enumerated = catalog->actions();
+    const QString copyPath = dir.path() + QString("/copy.snapshot");
+    QVERIFY(QFile::copy(snapshotPath, copyPath));
+    catalog->setSnapshotPath(copyPath);
+    QCOMPARE(catalog->count(), enumerated.size());
+    QCOMPARE(spy.count(), 2);
+    const ActionDescription::List mapped = catalog->actions();
+    for (int i = 0; i < enumerated.size(); ++i) {
+        QCOMPARE(mapped.at(i), enumerated.at(i));
+        QCOMPARE(mapped.at(i).message(), enumerated.at(i).message());
+        QCOMPARE(mapped.at(i).implicitActive(), enumerated.at(i).implicitActive());
+    }
+    QCOMPARE(addedSpy.count(), 0);
+    QCOMPARE(removedSpy.count(), 0);
+    QCOMPARE(changedSpy.count(), 0);
+    QThreadPool::globalInstance()->waitForDone();
+    catalog->setSnapshotPath(defaultPath);
+    QVERIFY(!Authority::instance()->hasError());
+}
+
 void TestAuth::test_Identity()
 {
     // Get real name and id of current user and group
@@ -168,6 +699,12 @@ void TestAuth::test_Authority()
     //QVERIFY(spy.count() > 0);
     QVERIFY(!authority->hasError());
 
+    // A burst of notifications results in a single changed() signal
+    QCOMPARE(authority->changeCoalescingWindow(), 100);
+    authority->setChangeCoalescingWindow(-1);
+    QCOMPARE(authority->changeCoalescingWindow(), 0);
+    authority->setChangeCoalescingWindow(100);
+
     // configChanged signal from authority requires changing some policy files
     // and it would require user interaction (typing the password)
     // so this is not covered by this test
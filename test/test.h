@@ -7,9 +7,26 @@
 class TestAuth : public QObject
 {
     Q_OBJECT
+public Q_SLOTS:
+    /** Deletes the object whose signal it is connected to */
+    void deleteSender();
+
 private Q_SLOTS:
+    void test_Auth_asyncInit();
     void test_Auth_checkAuthorization();
+    void test_Auth_cache();
+    void test_Auth_pendingAuthorization();
+    void test_Auth_coalescing();
+    void test_Auth_timeout();
+    void test_Auth_lanes();
+    void test_Auth_checkAuthorizations();
+    void test_Auth_watch();
+    void test_Auth_temporaryWatch();
+    void test_Auth_bulkRevoke();
+    void test_Auth_metrics();
     void test_Auth_enumerateActions();
+    void test_Auth_enumerateActionsStreamed();
+    void test_Auth_actionCatalog();
     void test_Identity();
     void test_Authority();
     void test_Subject();